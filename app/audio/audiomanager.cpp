@@ -85,11 +85,26 @@ void AudioManager::StartOutput(QIODevice *device, int playback_speed)
   output_manager_.PullFromDevice(device, playback_speed);
 }
 
+bool AudioManager::SetOutputSpeed(int playback_speed)
+{
+  return output_manager_.SetPlaybackSpeed(playback_speed);
+}
+
 void AudioManager::StopOutput()
 {
   output_manager_.ResetToPushMode();
 }
 
+int AudioManager::GetOutputUnderrunCount() const
+{
+  return output_manager_.GetUnderrunCount();
+}
+
+qint64 AudioManager::GetOutputLatency() const
+{
+  return output_manager_.GetLatency();
+}
+
 void AudioManager::SetOutputDevice(const QAudioDeviceInfo &info)
 {
   qInfo() << "Setting output audio device to" << info.deviceName();
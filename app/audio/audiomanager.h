@@ -84,11 +84,28 @@ public:
    */
   void StartOutput(QIODevice* device, int playback_speed);
 
+  /**
+   * @brief Change the speed of the audio started with StartOutput() without interrupting it
+   *
+   * Returns false if the output couldn't be changed in place (e.g. the direction changed).
+   */
+  bool SetOutputSpeed(int playback_speed);
+
   /**
    * @brief Stop audio output immediately
    */
   void StopOutput();
 
+  /**
+   * @brief Number of times the output device ran out of samples during playback
+   */
+  int GetOutputUnderrunCount() const;
+
+  /**
+   * @brief Time in microseconds between samples being queued for output and them being heard
+   */
+  qint64 GetOutputLatency() const;
+
   void SetOutputDevice(const QAudioDeviceInfo& info);
 
   void SetOutputParams(const AudioRenderingParams& params);
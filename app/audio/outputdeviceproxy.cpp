@@ -20,14 +20,16 @@
 
 #include "outputdeviceproxy.h"
 
+#include <QDebug>
+
 #include "audiomanager.h"
-#include "bufferaverage.h"
 
 OLIVE_NAMESPACE_ENTER
 
 AudioOutputDeviceProxy::AudioOutputDeviceProxy() :
   device_(nullptr),
-  send_averages_(false)
+  playback_speed_(0),
+  pending_speed_(0)
 {
 }
 
@@ -45,15 +47,22 @@ void AudioOutputDeviceProxy::SetDevice(QIODevice *device, int playback_speed)
   }
 
   playback_speed_ = playback_speed;
+  pending_speed_.storeRelease(playback_speed);
+
+  // Always stretch, even at normal speed, so the speed can change later without reopening anything
+  if (tempo_processor_.IsOpen()) {
+    tempo_processor_.Close();
+  }
 
-  if (qAbs(playback_speed_) != 1) {
-    tempo_processor_.Open(params_, qAbs(playback_speed_));
+  if (!tempo_processor_.Open(params_, qAbs(playback_speed_))) {
+    // Fall back to passing audio through, it just won't be stretched
+    qWarning() << "Audio will play without tempo processing";
   }
 }
 
-void AudioOutputDeviceProxy::SetSendAverages(bool send)
+void AudioOutputDeviceProxy::SetPlaybackSpeed(int playback_speed)
 {
-  send_averages_ = send;
+  pending_speed_.storeRelease(playback_speed);
 }
 
 void AudioOutputDeviceProxy::close()
@@ -73,14 +82,24 @@ qint64 AudioOutputDeviceProxy::readData(char *data, qint64 maxlen)
 
     qint64 read_count;
 
+    int speed = pending_speed_.loadAcquire();
 
+    if (speed != playback_speed_ && (speed > 0) == (playback_speed_ > 0)) {
+      playback_speed_ = speed;
+      tempo_processor_.SetSpeed(qAbs(playback_speed_));
+    }
 
     if (tempo_processor_.IsOpen()) {
 
       while ((read_count = tempo_processor_.Pull(data, static_cast<int>(maxlen))) == 0) {
-        int dev_read = static_cast<int>(ReverseAwareRead(data, maxlen));
+        // Never read more than the stretcher can take
+        qint64 dev_maxlen = qMin(maxlen, static_cast<qint64>(tempo_processor_.GetInputSpace()));
+        int dev_read = static_cast<int>(ReverseAwareRead(data, dev_maxlen));
 
         if (!dev_read) {
+          // Reached the end of the device, flush out whatever the stretcher still has
+          tempo_processor_.Push(nullptr, 0);
+          read_count = tempo_processor_.Pull(data, static_cast<int>(maxlen));
           break;
         }
 
@@ -92,11 +111,6 @@ qint64 AudioOutputDeviceProxy::readData(char *data, qint64 maxlen)
       read_count = ReverseAwareRead(data, maxlen);
     }
 
-    // If we read any
-    if (read_count > 0 && send_averages_) {
-      emit ProcessedAverages(AudioBufferAverage::ProcessAverages(data, static_cast<int>(read_count), params_.channel_count()));
-    }
-
     return read_count;
   }
 
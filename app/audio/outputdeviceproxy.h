@@ -21,6 +21,7 @@
 #ifndef AUDIOOUTPUTDEVICEPROXY_H
 #define AUDIOOUTPUTDEVICEPROXY_H
 
+#include <QAtomicInt>
 #include <QIODevice>
 
 #include "common/define.h"
@@ -38,13 +39,15 @@ public:
 
   void SetDevice(QIODevice* device, int playback_speed);
 
-  void SetSendAverages(bool send);
+  /**
+   * @brief Change the playback speed without reopening the device
+   *
+   * The direction must stay the same. Thread-safe, the new speed is picked up on the next read.
+   */
+  void SetPlaybackSpeed(int playback_speed);
 
   virtual void close() override;
 
-signals:
-  void ProcessedAverages(QVector<double> averages);
-
 protected:
   virtual qint64 readData(char *data, qint64 maxlen) override;
 
@@ -57,12 +60,12 @@ private:
 
   TempoProcessor tempo_processor_;
 
-  bool send_averages_;
-
   AudioRenderingParams params_;
 
   int playback_speed_;
 
+  QAtomicInt pending_speed_;
+
 };
 
 OLIVE_NAMESPACE_EXIT
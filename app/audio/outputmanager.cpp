@@ -27,13 +27,45 @@
 
 OLIVE_NAMESPACE_ENTER
 
+/**
+ * @brief Capacity of the output ring in microseconds
+ */
+const qint64 kRingBufferLength = 500000;
+
+/**
+ * @brief How much the feeder thread keeps queued in the ring in microseconds
+ *
+ * Kept well below kRingBufferLength so pushed samples always have room without waiting on the device.
+ */
+const qint64 kFeedTarget = 150000;
+
+/**
+ * @brief How long the feeder thread sleeps when the ring is full, in milliseconds
+ */
+const unsigned long kFeedInterval = 5;
+
 AudioOutputManager::AudioOutputManager(QObject *parent) :
   QObject(parent),
   output_(nullptr),
-  push_device_(nullptr),
+  ring_device_(this),
+  feed_thread_(this),
+  feed_target_(0),
+  bytes_per_frame_(1),
+  silence_(0),
+  playback_speed_(0),
+  streaming_(0),
+  underruns_(0),
   enable_sending_samples_(false)
 {
-  connect(&device_proxy_, &AudioOutputDeviceProxy::ProcessedAverages, this, &AudioOutputManager::SentSamples);
+}
+
+AudioOutputManager::~AudioOutputManager()
+{
+  StopFeeding();
+
+  if (output_) {
+    output_->stop();
+  }
 }
 
 bool AudioOutputManager::OutputIsSet()
@@ -48,28 +80,29 @@ void AudioOutputManager::Push(const QByteArray& samples)
     return;
   }
 
-  // Replace sample buffer with this one
-  pushed_samples_ = samples;
-  pushed_sample_index_ = 0;
-
-  // If we had another device connected, disconnect it now
+  // If we had another device connected, disconnect it now and drop whatever it had queued
   ResetToPushMode();
 
-  // Start pushing samples to the output
-  PushMoreSamples();
+  // Queue samples for the device, the ring is never filled past kFeedTarget so there's room for anything short
+  int written = ring_.write(samples.constData(), samples.size());
+
+  if (written < samples.size()) {
+    qWarning() << "Dropped" << (samples.size() - written) << "pushed audio bytes";
+  }
+
+  meter_ring_.write(samples.constData(), written);
 }
 
 void AudioOutputManager::ResetToPushMode()
 {
-  // If we have a null push device, then we currently have the output in pull mode. We restore it to push mode here.
-  if (output_ && !push_device_) {
-    output_->stop();
+  StopFeeding();
 
+  if (device_proxy_.isOpen()) {
     device_proxy_.close();
-
-    // Put QAudioOutput back into push mode
-    push_device_ = output_->start();
   }
+
+  ring_.Flush();
+  meter_ring_.Flush();
 }
 
 void AudioOutputManager::SetParameters(const AudioRenderingParams &params)
@@ -77,81 +110,197 @@ void AudioOutputManager::SetParameters(const AudioRenderingParams &params)
   device_proxy_.SetParameters(params);
 }
 
+int AudioOutputManager::GetUnderrunCount() const
+{
+  return underruns_.loadAcquire();
+}
+
+qint64 AudioOutputManager::GetLatency() const
+{
+  if (!output_) {
+    return 0;
+  }
+
+  int device_queued = output_->bufferSize() - output_->bytesFree();
+
+  return output_->format().durationForBytes(ring_.queued() + qMax(0, device_queued));
+}
+
 void AudioOutputManager::PullFromDevice(QIODevice *device, int playback_speed)
 {
   if (!output_ || !device) {
     return;
   }
 
-  // Stop any current output and disable push mode
-  output_->stop();
-  push_device_ = nullptr;
-  pushed_samples_.clear();
+  // Stop any current reading and discard queued samples
+  ResetToPushMode();
 
-  // Pull from the device
+  // Pull from the device on the feeder thread
+  playback_speed_ = playback_speed;
   device_proxy_.SetDevice(device, playback_speed);
   device_proxy_.open(QIODevice::ReadOnly);
-  output_->start(&device_proxy_);
+
+  streaming_.storeRelease(1);
+  feed_thread_.Start();
 }
 
-void AudioOutputManager::PushMoreSamples()
+bool AudioOutputManager::SetPlaybackSpeed(int playback_speed)
 {
-  // Check if we're currently in push mode and if we have samples to push
-  if (!push_device_ || pushed_samples_.isEmpty()) {
-    return;
+  if (!feed_thread_.isRunning() || (playback_speed > 0) != (playback_speed_ > 0)) {
+    return false;
   }
 
-  const char* read_ptr = pushed_samples_.constData() + pushed_sample_index_;
+  playback_speed_ = playback_speed;
+  device_proxy_.SetPlaybackSpeed(playback_speed);
 
-  // Push the bytes we have to the audio output
-  qint64 write_count = push_device_->write(read_ptr,
-                                           pushed_samples_.size() - pushed_sample_index_);
-
-  // Emit the samples we just sent
-  ProcessAverages(read_ptr, static_cast<int>(write_count));
-
-  // Increment sample buffer index (faster than shift the bytes up)
-  pushed_sample_index_ += static_cast<int>(write_count);
-
-  // If we've pushed all samples, we can clear this array
-  if (pushed_sample_index_ == pushed_samples_.size()) {
-    pushed_samples_.clear();
-  }
+  return true;
 }
 
 void AudioOutputManager::SetEnableSendingSamples(bool e)
 {
   enable_sending_samples_ = e;
-
-  device_proxy_.SetSendAverages(e);
 }
 
 void AudioOutputManager::SetOutputDevice(QAudioDeviceInfo info, QAudioFormat format)
 {
   // Whatever the output is doing right now, stop it
+  ResetToPushMode();
+
   if (output_) {
     output_->stop();
+  }
 
-    if (device_proxy_.isOpen()) {
-      device_proxy_.close();
-    }
+  if (ring_device_.isOpen()) {
+    ring_device_.close();
   }
 
-  // Create a new output device and start it in push mode
+  // Nothing is reading or writing the rings now so they can be reallocated for this format
+  bytes_per_frame_ = qMax(1, format.bytesPerFrame());
+  silence_ = (format.sampleType() == QAudioFormat::UnSignedInt) ? char(0x80) : 0;
+
+  int capacity = format.bytesForDuration(kRingBufferLength);
+  ring_.Allocate(capacity);
+  meter_ring_.Allocate(ring_.capacity());
+  meter_buffer_.resize(ring_.capacity());
+
+  feed_target_ = format.bytesForDuration(kFeedTarget);
+  feed_target_ -= feed_target_ % bytes_per_frame_;
+  feed_buffer_.resize(feed_target_);
+
+  // Create a new output device that always pulls from the ring
   output_ = std::unique_ptr<QAudioOutput>(new QAudioOutput(info, format, this));
   output_->setNotifyInterval(1);
-  push_device_ = output_->start();
-  connect(output_.get(), &QAudioOutput::notify, this, &AudioOutputManager::PushMoreSamples);
+  connect(output_.get(), &QAudioOutput::notify, this, &AudioOutputManager::ProcessAverages);
   connect(output_.get(), &QAudioOutput::notify, this, &AudioOutputManager::OutputNotified);
+
+  ring_device_.open(QIODevice::ReadOnly);
+  output_->start(&ring_device_);
 }
 
-void AudioOutputManager::ProcessAverages(const char *data, int length)
+void AudioOutputManager::StopFeeding()
 {
+  streaming_.storeRelease(0);
+
+  if (feed_thread_.isRunning()) {
+    feed_thread_.Cancel();
+    feed_thread_.wait();
+  }
+}
+
+void AudioOutputManager::ProcessAverages()
+{
+  // Everything in the meter ring that's no longer queued in the output ring has been consumed by the device
+  int length = qBound(0, meter_ring_.available() - ring_.queued(), meter_buffer_.size());
+
+  length = meter_ring_.read(meter_buffer_.data(), length);
+
   if (!enable_sending_samples_ || length == 0) {
     return;
   }
 
-  emit SentSamples(AudioBufferAverage::ProcessAverages(data, length, output_.get()->format().channelCount()));
+  emit SentSamples(AudioBufferAverage::ProcessAverages(meter_buffer_.constData(), length, output_->format().channelCount()));
+}
+
+AudioOutputManager::RingDevice::RingDevice(AudioOutputManager *parent) :
+  parent_(parent)
+{
+}
+
+bool AudioOutputManager::RingDevice::isSequential() const
+{
+  return true;
+}
+
+qint64 AudioOutputManager::RingDevice::readData(char *data, qint64 maxlen)
+{
+  // NOTE: Called from the audio thread on some platforms, nothing here may allocate or block
+  int length = static_cast<int>(qMin(maxlen, static_cast<qint64>(parent_->ring_.capacity())));
+  length -= length % parent_->bytes_per_frame_;
+
+  int read_count = parent_->ring_.read(data, length);
+
+  // Never return a short read since that puts QAudioOutput into an idle state, fill the rest with silence instead
+  if (read_count < length) {
+    if (parent_->streaming_.loadAcquire()) {
+      parent_->underruns_.fetchAndAddRelaxed(1);
+    }
+
+    memset(data + read_count, parent_->silence_, static_cast<size_t>(length - read_count));
+  }
+
+  return length;
+}
+
+qint64 AudioOutputManager::RingDevice::writeData(const char *data, qint64 maxSize)
+{
+  Q_UNUSED(data)
+  Q_UNUSED(maxSize)
+
+  return -1;
+}
+
+AudioOutputManager::FeedThread::FeedThread(AudioOutputManager *parent) :
+  parent_(parent),
+  cancelled_(0)
+{
+}
+
+void AudioOutputManager::FeedThread::Start()
+{
+  cancelled_.storeRelease(0);
+
+  start(QThread::TimeCriticalPriority);
+}
+
+void AudioOutputManager::FeedThread::Cancel()
+{
+  cancelled_.storeRelease(1);
+}
+
+void AudioOutputManager::FeedThread::run()
+{
+  while (!cancelled_.loadAcquire()) {
+    int wanted = parent_->feed_target_ - parent_->ring_.queued();
+    wanted -= wanted % parent_->bytes_per_frame_;
+
+    if (wanted <= 0) {
+      msleep(kFeedInterval);
+      continue;
+    }
+
+    char* buffer = parent_->feed_buffer_.data();
+    qint64 read_count = parent_->device_proxy_.read(buffer, wanted);
+
+    if (read_count <= 0) {
+      // Reached the end of the device, let the ring drain without counting it as an underrun
+      parent_->streaming_.storeRelease(0);
+      break;
+    }
+
+    int length = static_cast<int>(read_count);
+    parent_->ring_.write(buffer, length);
+    parent_->meter_ring_.write(buffer, length);
+  }
 }
 
 OLIVE_NAMESPACE_EXIT
@@ -23,20 +23,30 @@
 
 #include <memory>
 #include <QAudioOutput>
-#include <QBuffer>
 #include <QIODevice>
-#include <QMutex>
+#include <QThread>
 
 #include "outputdeviceproxy.h"
+#include "ringbuffer.h"
 
 OLIVE_NAMESPACE_ENTER
 
+/**
+ * @brief Feeds the system audio output from a lock-free ring buffer
+ *
+ * The QAudioOutput always runs in pull mode reading from `ring_`, so the device callback never allocates, locks or
+ * waits on the main thread. When playing from a QIODevice, a feeder thread does the reading (including any reversing
+ * and tempo processing) and keeps the ring topped up; pushed samples (e.g. scrubbing) are written into the ring
+ * directly. Metering is done on the main thread from a copy of the same samples as the device consumes them.
+ */
 class AudioOutputManager : public QObject
 {
   Q_OBJECT
 public:
   AudioOutputManager(QObject* parent = nullptr);
 
+  virtual ~AudioOutputManager() override;
+
   bool OutputIsSet();
 
   /**
@@ -46,20 +56,45 @@ public:
 
   void SetOutputDevice(QAudioDeviceInfo info, QAudioFormat format);
 
+  /**
+   * @brief Replace whatever is queued for output with these samples
+   */
   void Push(const QByteArray &samples);
 
   /**
    * @brief Connect a QIODevice (e.g. QFile) to start sending to the audio output
    *
-   * This will clear any pushed samples or QIODevices currently being read and will start reading from this next time
-   * the audio output requests data.
+   * This will clear any pushed samples or QIODevices currently being read and will start reading from this on the
+   * feeder thread.
    */
   void PullFromDevice(QIODevice* device, int playback_speed);
 
+  /**
+   * @brief Change the speed of the QIODevice currently being played without restarting it
+   *
+   * Returns false if nothing is playing or the direction would change, in which case PullFromDevice() should be used.
+   */
+  bool SetPlaybackSpeed(int playback_speed);
+
+  /**
+   * @brief Stop reading from any QIODevice and discard anything still queued
+   */
   void ResetToPushMode();
 
   void SetParameters(const AudioRenderingParams& params);
 
+  /**
+   * @brief Number of times the device asked for samples while playing and the ring couldn't supply them
+   */
+  int GetUnderrunCount() const;
+
+  /**
+   * @brief Current time in microseconds between a sample being queued and it being heard
+   *
+   * This is the amount queued in the ring plus whatever the system output is holding in its own buffer.
+   */
+  qint64 GetLatency() const;
+
 signals:
   /**
    * @brief Signal emitted when samples are sent to the output device
@@ -74,20 +109,82 @@ signals:
   void OutputNotified();
 
 private:
-  void ProcessAverages(const char* data, int length);
+  void StopFeeding();
+
+  class RingDevice : public QIODevice
+  {
+  public:
+    RingDevice(AudioOutputManager* parent);
+
+    virtual bool isSequential() const override;
+
+  protected:
+    virtual qint64 readData(char *data, qint64 maxlen) override;
+
+    virtual qint64 writeData(const char *data, qint64 maxSize) override;
+
+  private:
+    AudioOutputManager* parent_;
+
+  };
+
+  class FeedThread : public QThread
+  {
+  public:
+    FeedThread(AudioOutputManager* parent);
+
+    void Start();
+
+    void Cancel();
+
+  protected:
+    virtual void run() override;
+
+  private:
+    AudioOutputManager* parent_;
+
+    QAtomicInt cancelled_;
+
+  };
 
   std::unique_ptr<QAudioOutput> output_;
-  QIODevice* push_device_;
 
-  QByteArray pushed_samples_;
-  int pushed_sample_index_;
+  AudioRingBuffer ring_;
+
+  /**
+   * @brief Copy of everything written to `ring_`, read back on the main thread for metering
+   */
+  AudioRingBuffer meter_ring_;
+
+  QByteArray meter_buffer_;
+
+  RingDevice ring_device_;
+
+  FeedThread feed_thread_;
+
+  QByteArray feed_buffer_;
+
+  int feed_target_;
+
+  int bytes_per_frame_;
+
+  char silence_;
+
+  int playback_speed_;
+
+  /**
+   * @brief Set while the feeder thread is expected to keep the ring filled
+   */
+  QAtomicInt streaming_;
+
+  QAtomicInt underruns_;
 
   bool enable_sending_samples_;
 
   AudioOutputDeviceProxy device_proxy_;
 
 private slots:
-  void PushMoreSamples();
+  void ProcessAverages();
 };
 
 OLIVE_NAMESPACE_EXIT
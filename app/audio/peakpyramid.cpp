@@ -0,0 +1,367 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "peakpyramid.h"
+
+#include <QDataStream>
+
+OLIVE_NAMESPACE_ENTER
+
+QMutex PeakPyramid::write_lock_;
+
+// "OPKP" in little endian
+const quint32 kPeakPyramidMagic = 0x504B504F;
+
+const qint64 kPeakPyramidHeaderSize = 24;
+
+// The top level is a few minutes per Sum at this point, there's no reason to go any further
+const int kMaxPeakLevels = 16;
+
+PeakPyramid::PeakPyramid(const QString &filename) :
+  file_(filename)
+{
+  header_.magic = kPeakPyramidMagic;
+  header_.channels = 0;
+  header_.capacity = 0;
+  header_.length = 0;
+}
+
+PeakPyramid::~PeakPyramid()
+{
+  close();
+}
+
+bool PeakPyramid::open()
+{
+  if (!file_.open(QFile::ReadOnly)) {
+    return false;
+  }
+
+  if (!ReadHeader(&file_, &header_) || !header_.channels) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void PeakPyramid::close()
+{
+  if (file_.isOpen()) {
+    file_.close();
+  }
+}
+
+int PeakPyramid::channels() const
+{
+  return static_cast<int>(header_.channels);
+}
+
+qint64 PeakPyramid::length() const
+{
+  return header_.length;
+}
+
+QVector<SampleSummer::Sum> PeakPyramid::read(int level, qint64 index, qint64 count)
+{
+  level = qBound(0, level, LevelCount(header_.capacity) - 1);
+
+  index = qMax(static_cast<qint64>(0), index);
+  count = qMin(count, LevelLength(header_.length, level) - index);
+
+  if (!file_.isOpen() || count <= 0) {
+    return QVector<SampleSummer::Sum>();
+  }
+
+  QVector<SampleSummer::Sum> sums(static_cast<int>(count * header_.channels));
+
+  qint64 sum_size = static_cast<qint64>(header_.channels * sizeof(SampleSummer::Sum));
+
+  file_.seek(LevelOffset(header_, level) + index * sum_size);
+
+  qint64 read_size = file_.read(reinterpret_cast<char*>(sums.data()), count * sum_size);
+
+  if (read_size < count * sum_size) {
+    sums.resize(static_cast<int>(qMax(static_cast<qint64>(0), read_size) / sizeof(SampleSummer::Sum)));
+  }
+
+  return sums;
+}
+
+bool PeakPyramid::Write(const QString &filename, SampleBufferPtr samples, const rational &time)
+{
+  int channels = samples->audio_params().channel_count();
+  int chunk_size = samples->audio_params().sample_rate() / SampleSummer::kSumSampleRate;
+
+  if (!channels || !chunk_size) {
+    return false;
+  }
+
+  QVector<SampleSummer::Sum> sums;
+  sums.reserve((samples->sample_count_per_channel() / chunk_size + 1) * channels);
+
+  for (int i=0;i<samples->sample_count_per_channel();i+=chunk_size) {
+    sums.append(SampleSummer::SumSamples(samples,
+                                         i,
+                                         qMin(chunk_size, samples->sample_count_per_channel() - i)));
+  }
+
+  return Write(filename, channels, qRound64(time.toDouble() * SampleSummer::kSumSampleRate), sums);
+}
+
+void PeakPyramid::Truncate(const QString &filename, const rational &time)
+{
+  QMutexLocker locker(&write_lock_);
+
+  QFile f(filename);
+
+  if (!f.open(QFile::ReadWrite)) {
+    return;
+  }
+
+  Header header;
+
+  qint64 length = qMax(static_cast<qint64>(0), qRound64(time.toDouble() * SampleSummer::kSumSampleRate));
+
+  if (!ReadHeader(&f, &header) || header.length <= length) {
+    return;
+  }
+
+  qint64 old_length = header.length;
+  qint64 sum_size = static_cast<qint64>(header.channels * sizeof(SampleSummer::Sum));
+
+  header.length = length;
+  WriteHeader(&f, header);
+
+  // Silence everything past the new end in every level, so none of it resurfaces if the audio grows again
+  for (int level=0;level<LevelCount(header.capacity);level++) {
+    qint64 level_length = LevelLength(length, level);
+    qint64 stale_count = LevelLength(old_length, level) - level_length;
+
+    if (stale_count > 0) {
+      QByteArray silence(static_cast<int>(stale_count * sum_size), 0);
+
+      f.seek(LevelOffset(header, level) + level_length * sum_size);
+      f.write(silence);
+    }
+  }
+
+  // The last Sum of each level above 0 may have covered audio that's gone now, so rebuild it from what's left
+  if (length > 0) {
+    UpdateLevels(&f, header, length - 1, length);
+  }
+}
+
+double PeakPyramid::LevelRate(int level)
+{
+  return static_cast<double>(SampleSummer::kSumSampleRate) / static_cast<double>(static_cast<qint64>(1) << level);
+}
+
+int PeakPyramid::LevelForScale(const double &scale)
+{
+  int level = 0;
+
+  while (level < kMaxPeakLevels - 1 && LevelRate(level + 1) >= scale) {
+    level++;
+  }
+
+  return level;
+}
+
+bool PeakPyramid::Write(const QString &filename, int channels, qint64 index, const QVector<SampleSummer::Sum> &sums)
+{
+  if (index < 0 || sums.isEmpty()) {
+    return false;
+  }
+
+  QMutexLocker locker(&write_lock_);
+
+  QFile f(filename);
+
+  if (!f.open(QFile::ReadWrite)) {
+    return false;
+  }
+
+  qint64 count = sums.size() / channels;
+  qint64 end = index + count;
+  qint64 sum_size = static_cast<qint64>(channels * sizeof(SampleSummer::Sum));
+
+  Header header;
+  bool valid = ReadHeader(&f, &header) && header.channels == static_cast<quint32>(channels);
+
+  if (!valid || end > header.capacity) {
+    // The layout has to change, keep whatever level 0 we have and rebuild the rest
+    QVector<SampleSummer::Sum> level0;
+
+    if (valid) {
+      level0.resize(static_cast<int>(header.length * channels));
+
+      f.seek(LevelOffset(header, 0));
+      f.read(reinterpret_cast<char*>(level0.data()), header.length * sum_size);
+    } else {
+      header.magic = kPeakPyramidMagic;
+      header.channels = static_cast<quint32>(channels);
+      header.length = 0;
+    }
+
+    header.capacity = 1;
+    while (header.capacity < end) {
+      header.capacity *= 2;
+    }
+
+    header.length = qMax(header.length, end);
+
+    // Anything we haven't received is silent
+    level0.resize(static_cast<int>(header.length * channels));
+    memcpy(level0.data() + index * channels, sums.constData(), static_cast<size_t>(count * sum_size));
+
+    if (!f.resize(LevelOffset(header, LevelCount(header.capacity)))) {
+      return false;
+    }
+
+    WriteHeader(&f, header);
+
+    f.seek(LevelOffset(header, 0));
+    f.write(reinterpret_cast<const char*>(level0.constData()), header.length * sum_size);
+
+    UpdateLevels(&f, header, 0, header.length);
+  } else {
+    if (end > header.length) {
+      header.length = end;
+      WriteHeader(&f, header);
+    }
+
+    f.seek(LevelOffset(header, 0) + index * sum_size);
+    f.write(reinterpret_cast<const char*>(sums.constData()), count * sum_size);
+
+    UpdateLevels(&f, header, index, end);
+  }
+
+  return true;
+}
+
+bool PeakPyramid::ReadHeader(QFile *f, PeakPyramid::Header *header)
+{
+  if (f->size() < kPeakPyramidHeaderSize) {
+    return false;
+  }
+
+  f->seek(0);
+
+  QDataStream ds(f);
+  ds.setByteOrder(QDataStream::LittleEndian);
+
+  ds >> header->magic >> header->channels >> header->capacity >> header->length;
+
+  return ds.status() == QDataStream::Ok
+      && header->magic == kPeakPyramidMagic
+      && header->capacity > 0
+      && header->length >= 0
+      && header->length <= header->capacity
+      && f->size() >= LevelOffset(*header, LevelCount(header->capacity));
+}
+
+void PeakPyramid::WriteHeader(QFile *f, const PeakPyramid::Header &header)
+{
+  f->seek(0);
+
+  QDataStream ds(f);
+  ds.setByteOrder(QDataStream::LittleEndian);
+
+  ds << header.magic << header.channels << header.capacity << header.length;
+}
+
+void PeakPyramid::UpdateLevels(QFile *f, const Header &header, qint64 start, qint64 end)
+{
+  int channels = static_cast<int>(header.channels);
+  qint64 sum_size = static_cast<qint64>(channels * sizeof(SampleSummer::Sum));
+  int level_count = LevelCount(header.capacity);
+
+  for (int level=1;level<level_count;level++) {
+    qint64 below_length = LevelLength(header.length, level - 1);
+
+    // Each Sum in this level covers two in the level below
+    start /= 2;
+    end = (end + 1) / 2;
+
+    qint64 below_start = start * 2;
+    qint64 below_count = qMin(end * 2, below_length) - below_start;
+
+    if (below_count <= 0) {
+      break;
+    }
+
+    QVector<SampleSummer::Sum> below(static_cast<int>(below_count * channels));
+
+    f->seek(LevelOffset(header, level - 1) + below_start * sum_size);
+    f->read(reinterpret_cast<char*>(below.data()), below_count * sum_size);
+
+    QVector<SampleSummer::Sum> sums(static_cast<int>((end - start) * channels));
+
+    for (int i=0;i<below_count;i++) {
+      for (int j=0;j<channels;j++) {
+        const SampleSummer::Sum& src = below.at(i * channels + j);
+        SampleSummer::Sum& dst = sums[(i / 2) * channels + j];
+
+        if (i % 2 == 0 || src.min < dst.min) {
+          dst.min = src.min;
+        }
+
+        if (i % 2 == 0 || src.max > dst.max) {
+          dst.max = src.max;
+        }
+      }
+    }
+
+    f->seek(LevelOffset(header, level) + start * sum_size);
+    f->write(reinterpret_cast<const char*>(sums.constData()), sums.size() * static_cast<qint64>(sizeof(SampleSummer::Sum)));
+  }
+}
+
+int PeakPyramid::LevelCount(qint64 capacity)
+{
+  int count = 1;
+
+  while (count < kMaxPeakLevels && LevelLength(capacity, count - 1) > 1) {
+    count++;
+  }
+
+  return count;
+}
+
+qint64 PeakPyramid::LevelLength(qint64 length, int level)
+{
+  qint64 divider = static_cast<qint64>(1) << level;
+
+  return (length + divider - 1) / divider;
+}
+
+qint64 PeakPyramid::LevelOffset(const Header &header, int level)
+{
+  qint64 offset = kPeakPyramidHeaderSize;
+
+  for (int i=0;i<level;i++) {
+    offset += LevelLength(header.capacity, i) * header.channels * static_cast<qint64>(sizeof(SampleSummer::Sum));
+  }
+
+  return offset;
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,125 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PEAKPYRAMID_H
+#define PEAKPYRAMID_H
+
+#include <QFile>
+#include <QMutex>
+
+#include "audio/sumsamples.h"
+#include "common/rational.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief A file of waveform peaks (SampleSummer::Sum) at power-of-two decimations
+ *
+ * Level 0 holds one Sum per channel for every 1/SampleSummer::kSumSampleRate of a second and each level above it
+ * halves the rate of the one below. Drawing picks the coarsest level that still has at least one Sum per pixel, so
+ * the cost of drawing depends on the number of pixels rather than the length of the audio.
+ *
+ * The file is a small header followed by every level, each interleaved by channel. Levels are laid out for a capacity
+ * that doubles as the audio grows so that appending doesn't rewrite the whole file every time.
+ */
+class PeakPyramid
+{
+public:
+  PeakPyramid(const QString& filename);
+
+  ~PeakPyramid();
+
+  DISABLE_COPY_MOVE(PeakPyramid)
+
+  bool open();
+
+  void close();
+
+  int channels() const;
+
+  /**
+   * @brief Number of level 0 Sums per channel
+   */
+  qint64 length() const;
+
+  /**
+   * @brief Read `count` Sums per channel of `level` starting at `index`
+   *
+   * Returns them interleaved by channel, clamped to the length of the level.
+   */
+  QVector<SampleSummer::Sum> read(int level, qint64 index, qint64 count);
+
+  /**
+   * @brief Summarize `samples` starting at `time` into level 0 and update the levels above it
+   *
+   * Safe to call from multiple threads.
+   */
+  static bool Write(const QString& filename, SampleBufferPtr samples, const rational& time);
+
+  /**
+   * @brief Shorten the audio described by this file to `time`
+   *
+   * Every level is cut to the new length, including Sums that only partially covered the removed audio.
+   */
+  static void Truncate(const QString& filename, const rational& time);
+
+  /**
+   * @brief Number of Sums per second in a level
+   */
+  static double LevelRate(int level);
+
+  /**
+   * @brief Returns the coarsest level with at least one Sum per pixel at `scale` (pixels per second)
+   */
+  static int LevelForScale(const double& scale);
+
+private:
+  struct Header {
+    quint32 magic;
+    quint32 channels;
+    qint64 capacity;
+    qint64 length;
+  };
+
+  static bool Write(const QString& filename, int channels, qint64 index, const QVector<SampleSummer::Sum>& sums);
+
+  static bool ReadHeader(QFile* f, Header* header);
+
+  static void WriteHeader(QFile* f, const Header& header);
+
+  static void UpdateLevels(QFile* f, const Header& header, qint64 start, qint64 end);
+
+  static int LevelCount(qint64 capacity);
+
+  static qint64 LevelLength(qint64 length, int level);
+
+  static qint64 LevelOffset(const Header& header, int level);
+
+  static QMutex write_lock_;
+
+  QFile file_;
+
+  Header header_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // PEAKPYRAMID_H
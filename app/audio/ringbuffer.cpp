@@ -0,0 +1,143 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "ringbuffer.h"
+
+#include <cstring>
+
+OLIVE_NAMESPACE_ENTER
+
+AudioRingBuffer::AudioRingBuffer() :
+  buffer_(nullptr),
+  mask_(0),
+  write_pos_(0),
+  read_pos_(0),
+  flush_pos_(0)
+{
+}
+
+void AudioRingBuffer::Allocate(int capacity)
+{
+  int size = 1;
+
+  while (size < capacity) {
+    size <<= 1;
+  }
+
+  data_.resize(size);
+  data_.fill(0);
+  buffer_ = data_.data();
+  mask_ = static_cast<quint64>(size - 1);
+
+  write_pos_.storeRelease(0);
+  read_pos_.storeRelease(0);
+  flush_pos_.storeRelease(0);
+}
+
+int AudioRingBuffer::capacity() const
+{
+  return data_.size();
+}
+
+int AudioRingBuffer::write(const char *data, int length)
+{
+  quint64 w = write_pos_.loadAcquire();
+
+  length = qMin(length, free_space());
+
+  if (length <= 0) {
+    return 0;
+  }
+
+  // Copy in at most two pieces, the tail of the storage and then the start
+  int offset = static_cast<int>(w & mask_);
+  int first = qMin(length, data_.size() - offset);
+
+  memcpy(buffer_ + offset, data, static_cast<size_t>(first));
+  memcpy(buffer_, data + first, static_cast<size_t>(length - first));
+
+  // Publish only once the bytes are in place
+  write_pos_.storeRelease(w + static_cast<quint64>(length));
+
+  return length;
+}
+
+void AudioRingBuffer::Flush()
+{
+  flush_pos_.storeRelease(write_pos_.loadAcquire());
+}
+
+int AudioRingBuffer::free_space() const
+{
+  // The consumer may not have applied a flush yet, so its real position is the conservative one to use here
+  quint64 used = write_pos_.loadAcquire() - read_pos_.loadAcquire();
+
+  return data_.size() - static_cast<int>(used);
+}
+
+int AudioRingBuffer::read(char *data, int length)
+{
+  quint64 r = ConsumerPosition();
+  quint64 w = write_pos_.loadAcquire();
+
+  length = qMin(length, static_cast<int>(w - r));
+
+  if (length > 0) {
+    int offset = static_cast<int>(r & mask_);
+    int first = qMin(length, data_.size() - offset);
+
+    memcpy(data, buffer_ + offset, static_cast<size_t>(first));
+    memcpy(data + first, buffer_, static_cast<size_t>(length - first));
+
+    r += static_cast<quint64>(length);
+  } else {
+    length = 0;
+  }
+
+  // Hand the space back to the producer (this also commits any flush we just applied)
+  read_pos_.storeRelease(r);
+
+  return length;
+}
+
+int AudioRingBuffer::available() const
+{
+  return static_cast<int>(write_pos_.loadAcquire() - ConsumerPosition());
+}
+
+quint64 AudioRingBuffer::read_position() const
+{
+  return read_pos_.loadAcquire();
+}
+
+int AudioRingBuffer::queued() const
+{
+  quint64 w = write_pos_.loadAcquire();
+  quint64 r = qMax(read_pos_.loadAcquire(), flush_pos_.loadAcquire());
+
+  return (w > r) ? static_cast<int>(w - r) : 0;
+}
+
+quint64 AudioRingBuffer::ConsumerPosition() const
+{
+  return qMax(read_pos_.loadAcquire(), flush_pos_.loadAcquire());
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,112 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Lock-free single-producer/single-consumer byte ring
+ *
+ * Storage is allocated once with Allocate() and never resized while in use, so neither write() nor read() allocate
+ * or block. Exactly one thread may call the producer functions (write(), Flush(), free_space()) and exactly one thread
+ * may call the consumer functions (read(), available()) at any given time. Read and write positions are monotonic
+ * byte counters, so the consumer's position doubles as a count of every byte that has been played.
+ */
+class AudioRingBuffer
+{
+public:
+  AudioRingBuffer();
+
+  /**
+   * @brief Allocate storage for at least `capacity` bytes and reset both positions
+   *
+   * The capacity is rounded up to a power of two. Not thread-safe, neither side may be using the ring during this call.
+   */
+  void Allocate(int capacity);
+
+  int capacity() const;
+
+  /**
+   * @brief Producer: copy up to `length` bytes into the ring, returns the number of bytes actually written
+   */
+  int write(const char* data, int length);
+
+  /**
+   * @brief Producer: discard everything written so far
+   *
+   * The consumer skips ahead to the current write position the next time it reads. Data written after this call is
+   * kept.
+   */
+  void Flush();
+
+  /**
+   * @brief Producer: number of bytes that can currently be written
+   */
+  int free_space() const;
+
+  /**
+   * @brief Consumer: copy up to `length` bytes out of the ring, returns the number of bytes actually read
+   */
+  int read(char* data, int length);
+
+  /**
+   * @brief Consumer: number of bytes that can currently be read
+   */
+  int available() const;
+
+  /**
+   * @brief Total number of bytes the consumer has read or skipped since the last Allocate()
+   *
+   * Safe to call from any thread.
+   */
+  quint64 read_position() const;
+
+  /**
+   * @brief Number of bytes written but not yet read, safe to call from any thread
+   */
+  int queued() const;
+
+private:
+  quint64 ConsumerPosition() const;
+
+  QVector<char> data_;
+
+  char* buffer_;
+
+  quint64 mask_;
+
+  QAtomicInteger<quint64> write_pos_;
+
+  QAtomicInteger<quint64> read_pos_;
+
+  QAtomicInteger<quint64> flush_pos_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // AUDIORINGBUFFER_H
@@ -102,9 +102,4 @@ void SampleSummer::ClampMinMax(SampleSummer::Sum &sum, T value)
   }
 }
 
-SampleSummer::Info::Info()
-{
-  channels = 0;
-}
-
 OLIVE_NAMESPACE_EXIT
@@ -20,258 +20,122 @@
 
 #include "tempoprocessor.h"
 
-extern "C" {
-#include <libavfilter/buffersink.h>
-#include <libavfilter/buffersrc.h>
-#include <libavutil/opt.h>
-}
-
 #include <QDebug>
 
-#include "codec/ffmpeg/ffmpegcommon.h"
-
 OLIVE_NAMESPACE_ENTER
 
 TempoProcessor::TempoProcessor() :
-  filter_graph_(nullptr),
-  buffersrc_ctx_(nullptr),
-  buffersink_ctx_(nullptr),
-  processed_frame_(nullptr),
-  open_(false)
+  planar_capacity_(0)
 {
 
 }
 
 bool TempoProcessor::IsOpen() const
 {
-  return open_;
+  return stretcher_.IsOpen();
 }
 
 const double &TempoProcessor::GetSpeed() const
 {
-  return speed_;
+  return stretcher_.GetSpeed();
 }
 
 bool TempoProcessor::Open(const AudioRenderingParams &params, const double& speed)
 {
-  if (open_) {
+  if (IsOpen()) {
     return true;
   }
 
-  params_ = params;
-  speed_ = speed;
-
-  // Create AVFilterGraph instance
-  filter_graph_ = avfilter_graph_alloc();
-  if (!filter_graph_) {
-    qCritical() << "Failed to create AVFilterGraph";
-    Close();
-    return false;
-  }
-
-  // Set up audio buffer args
-  char filter_args[200];
-  snprintf(filter_args, 200, "time_base=%d/%d:sample_rate=%d:sample_fmt=%d:channel_layout=0x%" PRIx64,
-           1,
-           params_.sample_rate(),
-           params_.sample_rate(),
-           FFmpegCommon::GetFFmpegSampleFormat(params_.format()),
-           params.channel_layout());
-
-  // Create buffer and buffersink
-  if (avfilter_graph_create_filter(&buffersrc_ctx_, avfilter_get_by_name("abuffer"), "in", filter_args, nullptr, filter_graph_) < 0) {
-    qCritical() << "Failed to create audio buffer source";
-    Close();
+  // Packed samples are converted straight to TimeStretcher's planar floats without any format conversion
+  if (params.format() != SampleFormat::SAMPLE_FMT_FLT) {
+    qCritical() << "TempoProcessor only supports float samples, got"
+                << SampleFormat::GetSampleFormatName(params.format());
     return false;
   }
 
-  if (avfilter_graph_create_filter(&buffersink_ctx_, avfilter_get_by_name("abuffersink"), "out", nullptr, nullptr, filter_graph_) < 0) {
-    qCritical() << "Failed to create audio buffer sink";
-    Close();
-    return false;
-  }
-
-  // Create audio tempo filters: FFmpeg's atempo can only be set between 0.5 and 2.0. If the requested speed is outside
-  // those boundaries, we need to daisychain more than one together.
-  double base = (speed_ > 1.0) ? 2.0 : 0.5;
-  double speed_log = log(speed_) / log(base);
-
-  // This is the number of how many 0.5 or 2.0 tempos we need to daisychain
-  int whole = qFloor(speed_log);
-
-  // Set speed_log to the remainder
-  speed_log -= whole;
-
-  AVFilterContext* previous_filter = buffersrc_ctx_;
-
-  for (int i=0;i<=whole;i++) {
-    double filter_tempo = (i == whole) ? qPow(base, speed_log) : base;
-
-    if (qFuzzyCompare(filter_tempo, 1.0)) {
-      // This filter would do nothing
-      continue;
-    }
+  params_ = params;
 
-    previous_filter = CreateTempoFilter(filter_graph_,
-                                        previous_filter,
-                                        filter_tempo);
+  stretcher_.Open(params_, speed);
 
-    if (!previous_filter) {
-      qCritical() << "Failed to create audio tempo filter";
-      Close();
-      return false;
-    }
-  }
+  // Scratch space for converting between packed and planar, big enough for a full input buffer
+  planar_capacity_ = stretcher_.GetInputSpace();
+  planar_.resize(planar_capacity_ * params_.channel_count());
+  planar_ptrs_.resize(params_.channel_count());
 
-  // Link the last filter to the buffersink
-  if (avfilter_link(previous_filter, 0, buffersink_ctx_, 0) != 0) {
-    qCritical() << "Failed to link final filter and buffer sink";
-    Close();
-    return false;
+  for (int i=0;i<planar_ptrs_.size();i++) {
+    planar_ptrs_[i] = planar_.data() + i * planar_capacity_;
   }
 
-  // Config graph
-  if (avfilter_graph_config(filter_graph_, nullptr) < 0) {
-    qCritical() << "Failed to configure filter graph";
-    Close();
-    return false;
-  }
-
-  timestamp_ = 0;
-
-  open_ = true;
+  return true;
+}
 
-  flushed_ = false;
+void TempoProcessor::SetSpeed(const double &speed)
+{
+  stretcher_.SetSpeed(speed);
+}
 
-  return true;
+int TempoProcessor::GetInputSpace() const
+{
+  return params_.samples_to_bytes(stretcher_.GetInputSpace());
 }
 
 void TempoProcessor::Push(const char *data, int length)
 {
-  if (flushed_) {
-    if (length > 0) {
-      qCritical() << "Tried to push" << length << "bytes after TempoProcessor was closed";
-    }
+  if (!IsOpen()) {
     return;
   }
 
-  AVFrame* src_frame;
-
   if (length == 0) {
-    // No audio data, flush the last out of the filter graph
-    src_frame = nullptr;
-    flushed_ = true;
-  } else {
-    src_frame = av_frame_alloc();
-
-    if (!src_frame) {
-      qCritical() << "Failed to allocate source frame";
-      return;
-    }
-
-    // Allocate a buffer for the number of samples we got
-    src_frame->sample_rate = params_.sample_rate();
-    src_frame->format = FFmpegCommon::GetFFmpegSampleFormat(params_.format());
-    src_frame->channel_layout = params_.channel_layout();
-    src_frame->nb_samples = params_.bytes_to_samples(length);
-    src_frame->pts = timestamp_;
-    timestamp_ += src_frame->nb_samples;
-
-    if (av_frame_get_buffer(src_frame, 0) < 0) {
-      qCritical() << "Failed to allocate buffer for source frame";
-      av_frame_free(&src_frame);
-      return;
-    }
-
-    // Copy buffer from data array to frame
-    memcpy(src_frame->data[0], data, static_cast<size_t>(length));
+    // No audio data, flush the last out of the stretcher
+    stretcher_.Flush();
+    return;
   }
 
-  int ret = av_buffersrc_add_frame_flags(buffersrc_ctx_, src_frame, AV_BUFFERSRC_FLAG_KEEP_REF);
+  const float* packed = reinterpret_cast<const float*>(data);
+  int count = qMin(params_.bytes_to_samples(length), planar_capacity_);
+  int channels = params_.channel_count();
 
-  if (ret < 0) {
-    qCritical() << "Failed to feed buffer source" << ret;
+  for (int i=0;i<count;i++) {
+    for (int j=0;j<channels;j++) {
+      planar_ptrs_[j][i] = packed[i * channels + j];
+    }
   }
 
-  if (src_frame) {
-    av_frame_free(&src_frame);
+  int pushed = stretcher_.Push(const_cast<const float**>(planar_ptrs_.data()), count);
+
+  if (pushed < params_.bytes_to_samples(length)) {
+    qCritical() << "Tried to push" << length << "bytes to TempoProcessor which only had room for"
+                << params_.samples_to_bytes(pushed);
   }
 }
 
 int TempoProcessor::Pull(char *data, int max_length)
 {
-  if (!processed_frame_) {
-    processed_frame_ = av_frame_alloc();
-
-    // Try to pull samples from the buffersink
-    int ret = av_buffersink_get_frame(buffersink_ctx_, processed_frame_);
-
-    if (ret < 0) {
-      // We couldn't pull for some reason, if the error was EAGAIN, we just need to send more samples. Otherwise the
-      // error might be fatal...
-      if (ret != AVERROR(EAGAIN)) {
-        qCritical() << "Failed to pull from buffersink" << ret;
-      }
-
-      av_frame_free(&processed_frame_);
-
-      return 0;
-    }
-
-    processed_frame_byte_index_ = 0;
-    processed_frame_max_bytes_ = params_.samples_to_bytes(processed_frame_->nb_samples);
+  if (!IsOpen()) {
+    return 0;
   }
 
-  // Determine how many bytes we should copy into the data array
-  int copy_length = qMin(max_length, processed_frame_max_bytes_ - processed_frame_byte_index_);
-
-  // Copy the bytes
-  memcpy(data, processed_frame_->data[0] + processed_frame_byte_index_, static_cast<size_t>(copy_length));
+  int count = stretcher_.Pull(planar_ptrs_.data(), qMin(params_.bytes_to_samples(max_length), planar_capacity_));
+  int channels = params_.channel_count();
 
-  // Add the copied amount to the current index
-  processed_frame_byte_index_ += copy_length;
+  float* packed = reinterpret_cast<float*>(data);
 
-  // If the index has reached the limit of this processed frame, we can dispose of the frame now
-  if (processed_frame_byte_index_ == processed_frame_max_bytes_) {
-    av_frame_free(&processed_frame_);
-    processed_frame_ = nullptr;
+  for (int i=0;i<count;i++) {
+    for (int j=0;j<channels;j++) {
+      packed[i * channels + j] = planar_ptrs_[j][i];
+    }
   }
 
-  return copy_length;
+  return params_.samples_to_bytes(count);
 }
 
 void TempoProcessor::Close()
 {
-  open_ = false;
-
-  if (filter_graph_) {
-    avfilter_graph_free(&filter_graph_);
-    filter_graph_ = nullptr;
-  }
-
-  if (processed_frame_) {
-    av_frame_free(&processed_frame_);
-    processed_frame_ = nullptr;
-  }
-
-  buffersrc_ctx_ = nullptr;
-  buffersink_ctx_ = nullptr;
-}
-
-AVFilterContext *TempoProcessor::CreateTempoFilter(AVFilterGraph* graph, AVFilterContext* link, const double &tempo)
-{
-  // Set up tempo param, which is taken as a C string
-  char speed_param[20];
-  snprintf(speed_param, 20, "%f", tempo);
-
-  AVFilterContext* tempo_ctx = nullptr;
-
-  if (avfilter_graph_create_filter(&tempo_ctx, avfilter_get_by_name("atempo"), "atempo", speed_param, nullptr, graph) >= 0
-      && avfilter_link(link, 0, tempo_ctx, 0) == 0) {
-    return tempo_ctx;
-  }
+  stretcher_.Close();
 
-  return nullptr;
+  planar_.clear();
+  planar_ptrs_.clear();
+  planar_capacity_ = 0;
 }
 
 OLIVE_NAMESPACE_EXIT
@@ -21,22 +21,16 @@
 #ifndef TEMPOPROCESSOR_H
 #define TEMPOPROCESSOR_H
 
-#ifdef __MINGW32__
-#ifndef __USE_MINGW_ANSI_STDIO
-#define __USE_MINGW_ANSI_STDIO
-#endif
-#endif
-
-#include <inttypes.h>
-
-extern "C" {
-#include <libavfilter/avfilter.h>
-}
-
-#include "render/audioparams.h"
+#include "timestretcher.h"
 
 OLIVE_NAMESPACE_ENTER
 
+/**
+ * @brief Packed sample interface around TimeStretcher for the playback path
+ *
+ * Only float samples are supported, Open() fails for any other format. All buffers are allocated in Open(), so Push(),
+ * Pull() and SetSpeed() can be called from the audio output path.
+ */
 class TempoProcessor
 {
 public:
@@ -48,6 +42,19 @@ public:
 
   bool Open(const AudioRenderingParams& params, const double &speed);
 
+  /**
+   * @brief Change speed without interrupting the stream
+   */
+  void SetSpeed(const double& speed);
+
+  /**
+   * @brief Maximum number of bytes Push() will currently accept
+   */
+  int GetInputSpace() const;
+
+  /**
+   * @brief Push packed samples, pushing a length of 0 flushes out the last of the audio
+   */
   void Push(const char *data, int length);
 
   int Pull(char* data, int max_length);
@@ -55,27 +62,16 @@ public:
   void Close();
 
 private:
-  static AVFilterContext* CreateTempoFilter(AVFilterGraph *graph, AVFilterContext *link, const double& tempo);
+  TimeStretcher stretcher_;
 
-  AVFilterGraph* filter_graph_;
+  QVector<float> planar_;
 
-  AVFilterContext* buffersrc_ctx_;
+  QVector<float*> planar_ptrs_;
 
-  AVFilterContext* buffersink_ctx_;
-
-  AVFrame* processed_frame_;
-  int processed_frame_byte_index_;
-  int processed_frame_max_bytes_;
+  int planar_capacity_;
 
   AudioRenderingParams params_;
 
-  int64_t timestamp_;
-
-  double speed_;
-
-  bool open_;
-
-  bool flushed_;
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,385 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "timestretcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <QtMath>
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Length of each grain in seconds
+ */
+const double kWindowLength = 0.03;
+
+/**
+ * @brief How far either side of the nominal position to search for the best grain, in seconds
+ */
+const double kSearchLength = 0.008;
+
+/**
+ * @brief Decimation used when comparing grains
+ *
+ * Positions are searched coarsely at this step and then refined around the best match, and only every nth sample is
+ * compared, which keeps the search cheap enough to run on every grain.
+ */
+const int kSearchStep = 4;
+
+const double kMinimumSpeed = 0.0625;
+
+const double kMaximumSpeed = 16.0;
+
+TimeStretcher::TimeStretcher() :
+  channels_(0),
+  window_(0),
+  hop_(0),
+  search_(0),
+  input_capacity_(0),
+  input_count_(0),
+  output_count_(0),
+  output_read_(0),
+  input_pos_(0),
+  prev_pos_(0),
+  has_prev_(false),
+  skip_(0),
+  input_end_(-1),
+  speed_(1.0),
+  open_(false)
+{
+}
+
+bool TimeStretcher::IsOpen() const
+{
+  return open_;
+}
+
+void TimeStretcher::Open(const AudioRenderingParams &params, const double &speed)
+{
+  params_ = params;
+  channels_ = params.channel_count();
+
+  hop_ = GetHopSize(params.sample_rate());
+  window_ = hop_ * 2;
+  search_ = qMax(kSearchStep, qRound(params.sample_rate() * kSearchLength));
+
+  // Periodic Hann, two of these overlapping by half always sum to 1
+  window_fn_.resize(window_);
+  for (int i=0;i<window_;i++) {
+    window_fn_[i] = static_cast<float>(0.5 - 0.5 * qCos(2.0 * M_PI * i / window_));
+  }
+
+  // Enough for a grain at the maximum speed plus the search area on either side, see ProcessGrain() for how much of
+  // the input is kept around
+  input_capacity_ = qCeil(hop_ * kMaximumSpeed) + window_ + 2 * search_ + 2 * hop_;
+  input_.resize(input_capacity_ * channels_);
+  overlap_.resize(hop_ * channels_);
+  output_.resize(hop_ * channels_);
+
+  open_ = true;
+
+  SetSpeed(speed);
+  Reset();
+}
+
+void TimeStretcher::Close()
+{
+  open_ = false;
+
+  input_.clear();
+  overlap_.clear();
+  output_.clear();
+  window_fn_.clear();
+}
+
+void TimeStretcher::Reset()
+{
+  // Start with one hop of silence so the first real sample lands at the start of a grain's flat half rather than
+  // fading in. The output that only covers that silence is skipped.
+  input_.fill(0);
+  overlap_.fill(0);
+
+  input_count_ = hop_;
+  input_pos_ = 0;
+  prev_pos_ = 0;
+  has_prev_ = false;
+  skip_ = hop_;
+  input_end_ = -1;
+
+  output_count_ = 0;
+  output_read_ = 0;
+}
+
+const double &TimeStretcher::GetSpeed() const
+{
+  return speed_;
+}
+
+void TimeStretcher::SetSpeed(const double &speed)
+{
+  speed_ = qBound(kMinimumSpeed, speed, kMaximumSpeed);
+}
+
+int TimeStretcher::GetInputSpace() const
+{
+  if (!open_ || input_end_ >= 0) {
+    return 0;
+  }
+
+  return input_capacity_ - input_count_;
+}
+
+int TimeStretcher::Push(const float **data, int count)
+{
+  count = qMin(count, GetInputSpace());
+
+  if (count <= 0) {
+    return 0;
+  }
+
+  for (int i=0;i<channels_;i++) {
+    memcpy(input_.data() + i * input_capacity_ + input_count_, data[i], static_cast<size_t>(count) * sizeof(float));
+  }
+
+  input_count_ += count;
+
+  return count;
+}
+
+void TimeStretcher::Flush()
+{
+  if (open_ && input_end_ < 0) {
+    input_end_ = input_count_;
+  }
+}
+
+int TimeStretcher::Pull(float **data, int max_count)
+{
+  int written = 0;
+
+  while (open_ && written < max_count) {
+    if (output_read_ == output_count_) {
+      if (!CanProcessGrain()) {
+        break;
+      }
+
+      ProcessGrain();
+    }
+
+    int count = qMin(output_count_ - output_read_, max_count - written);
+
+    if (skip_ > 0) {
+      count = qMin(count, skip_);
+      skip_ -= count;
+    } else {
+      for (int i=0;i<channels_;i++) {
+        memcpy(data[i] + written, output_.constData() + i * hop_ + output_read_, static_cast<size_t>(count) * sizeof(float));
+      }
+
+      written += count;
+    }
+
+    output_read_ += count;
+  }
+
+  return written;
+}
+
+SampleBufferPtr TimeStretcher::Stretch(SampleBufferPtr input, const double &speed)
+{
+  const AudioRenderingParams& params = input->audio_params();
+  int input_count = input->sample_count_per_channel();
+  int output_count = qMax(1, qRound(input_count / speed));
+
+  SampleBufferPtr output = SampleBuffer::CreateAllocated(params, output_count);
+
+  TimeStretcher stretcher;
+  stretcher.Open(params, speed);
+
+  QVector<const float*> input_ptrs(params.channel_count());
+  QVector<float*> output_ptrs(params.channel_count());
+
+  int pushed = 0;
+  int pulled = 0;
+
+  while (pulled < output_count) {
+    if (pushed < input_count) {
+      for (int i=0;i<input_ptrs.size();i++) {
+        input_ptrs[i] = input->const_data()[i] + pushed;
+      }
+
+      pushed += stretcher.Push(input_ptrs.data(), input_count - pushed);
+    }
+
+    if (pushed == input_count) {
+      stretcher.Flush();
+    }
+
+    for (int i=0;i<output_ptrs.size();i++) {
+      output_ptrs[i] = output->data()[i] + pulled;
+    }
+
+    int count = stretcher.Pull(output_ptrs.data(), output_count - pulled);
+
+    if (!count && pushed == input_count) {
+      break;
+    }
+
+    pulled += count;
+  }
+
+  if (pulled < output_count) {
+    output->fill(0, pulled, output_count);
+  }
+
+  return output;
+}
+
+int TimeStretcher::GetHopSize(int sample_rate)
+{
+  return qMax(32, qRound(sample_rate * kWindowLength * 0.5));
+}
+
+bool TimeStretcher::CanProcessGrain() const
+{
+  int nominal = qFloor(input_pos_);
+
+  if (input_end_ < 0) {
+    // Need every candidate position within the search area to be available
+    return input_count_ >= nominal + search_ + window_;
+  }
+
+  // Once flushed, keep going (padding with silence) until the last real sample has been through the overlap
+  return nominal < input_end_ + hop_;
+}
+
+void TimeStretcher::ProcessGrain()
+{
+  int nominal = qFloor(input_pos_);
+
+  if (input_end_ >= 0) {
+    // Flushing, pad anything past the real input with silence
+    int needed = qMin(input_capacity_, nominal + search_ + window_);
+
+    for (int i=0;i<channels_;i++) {
+      float* channel = input_.data() + i * input_capacity_;
+      std::fill(channel + input_count_, channel + qMax(input_count_, needed), 0.0f);
+    }
+
+    input_count_ = qMax(input_count_, needed);
+  }
+
+  int pos = has_prev_ ? FindBestPosition(nominal) : nominal;
+
+  // Overlap-add this grain onto the previous one, the first half completes one hop of output and the second half is
+  // kept for the next grain
+  for (int i=0;i<channels_;i++) {
+    const float* in = input_.constData() + i * input_capacity_ + pos;
+    float* overlap = overlap_.data() + i * hop_;
+    float* out = output_.data() + i * hop_;
+
+    for (int j=0;j<hop_;j++) {
+      out[j] = overlap[j] + window_fn_.at(j) * in[j];
+      overlap[j] = window_fn_.at(hop_ + j) * in[hop_ + j];
+    }
+  }
+
+  output_count_ = hop_;
+  output_read_ = 0;
+
+  prev_pos_ = pos;
+  has_prev_ = true;
+  input_pos_ += hop_ * speed_;
+
+  // Drop any input that neither the next grain's search area nor its reference (what would naturally follow this
+  // grain) can reach. This is what bounds the input to `input_capacity_`.
+  int discard = qMin(prev_pos_ + hop_, qFloor(input_pos_) - search_);
+
+  if (discard > 0) {
+    for (int i=0;i<channels_;i++) {
+      float* channel = input_.data() + i * input_capacity_;
+      memmove(channel, channel + discard, static_cast<size_t>(input_count_ - discard) * sizeof(float));
+    }
+
+    input_count_ -= discard;
+    prev_pos_ -= discard;
+    input_pos_ -= discard;
+
+    if (input_end_ >= 0) {
+      input_end_ = qMax(0, input_end_ - discard);
+    }
+  }
+}
+
+int TimeStretcher::FindBestPosition(int nominal) const
+{
+  int reference = prev_pos_ + hop_;
+  int min_pos = qMax(0, nominal - search_);
+  int max_pos = qMin(nominal + search_, input_count_ - window_);
+
+  int best_pos = qBound(min_pos, nominal, max_pos);
+  double best_score = Similarity(reference, best_pos);
+
+  // Coarse search
+  for (int i=min_pos;i<=max_pos;i+=kSearchStep) {
+    double score = Similarity(reference, i);
+
+    if (score > best_score) {
+      best_score = score;
+      best_pos = i;
+    }
+  }
+
+  // Refine around the best coarse match
+  int coarse_pos = best_pos;
+
+  for (int i=qMax(min_pos, coarse_pos - kSearchStep + 1);i<=qMin(max_pos, coarse_pos + kSearchStep - 1);i++) {
+    double score = Similarity(reference, i);
+
+    if (score > best_score) {
+      best_score = score;
+      best_pos = i;
+    }
+  }
+
+  return best_pos;
+}
+
+double TimeStretcher::Similarity(int reference, int candidate) const
+{
+  double correlation = 0;
+  double energy = 0;
+
+  // Compare the candidate's first half (which gets overlapped) with what would have followed the previous grain
+  for (int i=0;i<channels_;i++) {
+    const float* ref = input_.constData() + i * input_capacity_ + reference;
+    const float* cand = input_.constData() + i * input_capacity_ + candidate;
+
+    for (int j=0;j<hop_;j+=kSearchStep) {
+      correlation += static_cast<double>(ref[j]) * cand[j];
+      energy += static_cast<double>(cand[j]) * cand[j];
+    }
+  }
+
+  return correlation / qSqrt(energy + 1e-9);
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,161 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef TIMESTRETCHER_H
+#define TIMESTRETCHER_H
+
+#include <QVector>
+
+#include "codec/samplebuffer.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Pitch-preserving time stretcher for planar float audio using WSOLA
+ *
+ * Waveform similarity overlap-add: the output is built from Hann-windowed grains at a fixed synthesis hop, each grain
+ * taken from near its nominal input position (advanced by the hop times the speed) at whichever offset lines up best
+ * with the natural continuation of the previous grain. Since that only needs one grain's worth of state, the speed can
+ * be changed between any two grains without any discontinuity.
+ *
+ * All storage is allocated in Open(), nothing after that allocates, so it's safe to use from the audio output path.
+ */
+class TimeStretcher
+{
+public:
+  TimeStretcher();
+
+  bool IsOpen() const;
+
+  /**
+   * @brief Allocate buffers for these parameters and start a new stream at this speed
+   */
+  void Open(const AudioRenderingParams& params, const double& speed);
+
+  void Close();
+
+  /**
+   * @brief Discard all buffered audio and start a new stream, keeping the current allocation
+   */
+  void Reset();
+
+  const double& GetSpeed() const;
+
+  /**
+   * @brief Change the speed, takes effect from the next grain
+   */
+  void SetSpeed(const double& speed);
+
+  /**
+   * @brief Number of samples per channel that Push() will currently accept
+   */
+  int GetInputSpace() const;
+
+  /**
+   * @brief Queue input samples, returns the number of samples per channel that were accepted
+   */
+  int Push(const float** data, int count);
+
+  /**
+   * @brief Signal that there's no more input so the remaining buffered audio can be pulled
+   */
+  void Flush();
+
+  /**
+   * @brief Retrieve up to `max_count` stretched samples per channel, returns the number of samples retrieved
+   *
+   * Returns 0 when more input is needed (or once everything has been pulled after a Flush()).
+   */
+  int Pull(float** data, int max_count);
+
+  /**
+   * @brief Convenience function to stretch a whole buffer
+   *
+   * The result has the input's length divided by `speed`.
+   */
+  static SampleBufferPtr Stretch(SampleBufferPtr input, const double& speed);
+
+  /**
+   * @brief Number of output samples per channel between the starts of consecutive grains at this sample rate
+   *
+   * Stretching two overlapping stretches of input that start a multiple of this apart (in output samples) puts their
+   * grains in the same places, so their outputs can be joined anywhere they overlap.
+   */
+  static int GetHopSize(int sample_rate);
+
+private:
+  bool CanProcessGrain() const;
+
+  void ProcessGrain();
+
+  int FindBestPosition(int nominal) const;
+
+  double Similarity(int reference, int candidate) const;
+
+  AudioRenderingParams params_;
+
+  int channels_;
+
+  int window_;
+
+  int hop_;
+
+  int search_;
+
+  QVector<float> window_fn_;
+
+  /**
+   * @brief Input samples, channel `c` starts at `c * input_capacity_`
+   */
+  QVector<float> input_;
+  int input_capacity_;
+  int input_count_;
+
+  /**
+   * @brief Second half of the previous windowed grain, waiting to be added to the next one
+   */
+  QVector<float> overlap_;
+
+  /**
+   * @brief One hop of finished output, channel `c` starts at `c * hop_`
+   */
+  QVector<float> output_;
+  int output_count_;
+  int output_read_;
+
+  double input_pos_;
+
+  int prev_pos_;
+
+  bool has_prev_;
+
+  int skip_;
+
+  int input_end_;
+
+  double speed_;
+
+  bool open_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // TIMESTRETCHER_H
@@ -59,7 +59,7 @@ void Decoder::set_stream(StreamPtr fs)
   stream_ = fs;
 }
 
-FramePtr Decoder::RetrieveVideo(const rational &/*timecode*/, const int &/*divider*/)
+FramePtr Decoder::RetrieveVideo(const rational &/*timecode*/, const int &/*divider*/, bool /*allow_yuv*/)
 {
   return nullptr;
 }
@@ -136,7 +136,7 @@ bool Decoder::ProbeMedia(Footage *f, const QAtomicInt* cancelled)
 
       // Start an index task
       foreach (StreamPtr stream, f->streams()) {
-        if (stream->type() == Stream::kAudio) {
+        if (stream->type() == Stream::kAudio || stream->type() == Stream::kVideo) {
           QMetaObject::invokeMethod(IndexManager::instance(),
                                     "StartIndexingStream",
                                     Qt::QueuedConnection,
@@ -349,6 +349,11 @@ bool Decoder::HasConformedVersion(const AudioRenderingParams &params)
   return index_already_matches;
 }
 
+bool Decoder::CanStreamAudio()
+{
+  return false;
+}
+
 void Decoder::SignalIndexProgress(const int64_t &ts)
 {
   if (stream()->duration() != AV_NOPTS_VALUE && stream()->duration() != 0) {
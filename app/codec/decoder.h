@@ -138,12 +138,18 @@ public:
    * The timecode (a rational in seconds) to retrieve the frame at. If there is not a frame at this precise location
    * this should be corrected internally to the closest fit for the timecode.
    *
+   * @param allow_yuv
+   *
+   * Set this if the caller can convert planar Y'CbCr itself. The Decoder may then return a frame with Frame::is_yuv()
+   * set, in which case the frame is at the stream's full resolution and scaling it down by `divider` is also left to
+   * the caller. Decoders are free to ignore this and always return RGB(A).
+   *
    * @return
    *
    * A FramePtr of valid data at this timecode or nullptr if there was nothing to retrieve at the provided timecode or
    * the media could not be opened.
    */
-  virtual FramePtr RetrieveVideo(const rational& timecode, const int& divider);
+  virtual FramePtr RetrieveVideo(const rational& timecode, const int& divider, bool allow_yuv = false);
 
   /**
    * @brief Retrieve video frame
@@ -244,6 +250,11 @@ public:
    */
   bool HasConformedVersion(const AudioRenderingParams& params);
 
+  /**
+   * @brief AUDIO ONLY: Returns whether RetrieveAudio() can decode from the source when there's no conformed version
+   */
+  virtual bool CanStreamAudio();
+
 signals:
   /**
    * @brief While indexing, this signal will provide progress as a percentage (0-100 inclusive) if available
@@ -176,7 +176,10 @@ void Encoder::Open()
 void Encoder::WriteFrame(FramePtr frame)
 {
   if (open_) {
+    // WriteInternal() is responsible for emitting FrameWritten()
     WriteInternal(frame);
+  } else {
+    emit FrameWritten();
   }
 }
 
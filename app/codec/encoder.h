@@ -111,13 +111,25 @@ signals:
   void OpenSucceeded();
   void OpenFailed();
 
+  /**
+   * @brief Emitted once a frame sent to WriteFrame() has been encoded so callers can limit how many frames they queue up
+   *
+   * Encoders that work asynchronously may emit this from another thread.
+   */
+  void FrameWritten();
+
   void Closed();
 
   void AudioComplete();
 
 protected:
   virtual bool OpenInternal() = 0;
+
+  /**
+   * @brief Encode a frame, emitting FrameWritten() once it has been consumed
+   */
   virtual void WriteInternal(FramePtr frame) = 0;
+
   virtual void CloseInternal() = 0;
 
   bool IsOpen() const;
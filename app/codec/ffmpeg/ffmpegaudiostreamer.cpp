@@ -0,0 +1,363 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "ffmpegaudiostreamer.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+
+#include "common/timecodefunctions.h"
+#include "ffmpegcommon.h"
+
+OLIVE_NAMESPACE_ENTER
+
+// Seconds of decoded audio kept for sequential reads
+const int kRingSeconds = 10;
+
+// Start decoding this fraction of a second before a seek target so codecs with priming samples have settled
+const int kSeekPrerollDivider = 4;
+
+// Reads up to this many seconds past the ring are reached by decoding forward rather than seeking
+const int kMaxForwardDecodeSeconds = 1;
+
+// Identifies seek index files, change this if their layout changes
+const quint32 kSeekIndexMagic = 0x4F534931; // "OSI1"
+
+FFmpegAudioStreamer::FFmpegAudioStreamer(const char *filename, int stream_index, const QString &seek_index_filename) :
+  instance_(filename, stream_index),
+  seek_index_filename_(seek_index_filename),
+  seek_index_loaded_(false),
+  start_time_(0),
+  source_channel_layout_(0),
+  resampler_(nullptr),
+  pkt_(nullptr),
+  frame_(nullptr),
+  ring_capacity_(0),
+  ring_head_(0),
+  ring_count_(0),
+  ring_start_(0),
+  synced_(false),
+  seek_timestamp_(AV_NOPTS_VALUE),
+  at_eof_(false)
+{
+  if (!instance_.IsValid()) {
+    return;
+  }
+
+  AVStream* s = instance_.stream();
+
+  time_base_ = s->time_base;
+
+  if (s->start_time != AV_NOPTS_VALUE) {
+    start_time_ = s->start_time;
+  }
+
+  source_channel_layout_ = s->codecpar->channel_layout;
+  if (!source_channel_layout_) {
+    source_channel_layout_ = static_cast<uint64_t>(av_get_default_channel_layout(s->codecpar->channels));
+  }
+
+  pkt_ = av_packet_alloc();
+  frame_ = av_frame_alloc();
+}
+
+FFmpegAudioStreamer::~FFmpegAudioStreamer()
+{
+  swr_free(&resampler_);
+  av_frame_free(&frame_);
+  av_packet_free(&pkt_);
+}
+
+bool FFmpegAudioStreamer::IsValid() const
+{
+  return instance_.IsValid() && pkt_ && frame_ && source_channel_layout_;
+}
+
+SampleBufferPtr FFmpegAudioStreamer::Read(const rational &time, const rational &length, const AudioRenderingParams &params)
+{
+  int64_t start = Timecode::time_to_timestamp(time, params.time_base());
+  int count = params.time_to_samples(length);
+
+  if (params != params_ || ring_capacity_ < count) {
+    SetParams(params, count);
+  }
+
+  if (!resampler_) {
+    return nullptr;
+  }
+
+  // Decode forward if we're already close, otherwise seek
+  if (!synced_
+      || start < ring_start_
+      || start > RingEnd() + params_.sample_rate() * kMaxForwardDecodeSeconds) {
+    Seek(start);
+  }
+
+  int64_t end = start + count;
+
+  while (!at_eof_ && (!synced_ || RingEnd() < end)) {
+    if (!DecodeNext()) {
+      break;
+    }
+  }
+
+  // Anything the source doesn't cover is silent
+  QByteArray packed(params_.samples_to_bytes(count),
+                    (params_.format() == SampleFormat::SAMPLE_FMT_U8) ? static_cast<char>(0x80) : 0);
+
+  CopyFromRing(start, count, packed.data());
+
+  return SampleBuffer::CreateFromPackedData(params_, packed);
+}
+
+void FFmpegAudioStreamer::SetParams(const AudioRenderingParams &params, int minimum_capacity)
+{
+  swr_free(&resampler_);
+
+  params_ = params;
+
+  AVStream* s = instance_.stream();
+
+  resampler_ = swr_alloc_set_opts(nullptr,
+                                  static_cast<int64_t>(params_.channel_layout()),
+                                  FFmpegCommon::GetFFmpegSampleFormat(params_.format()),
+                                  params_.sample_rate(),
+                                  static_cast<int64_t>(source_channel_layout_),
+                                  static_cast<AVSampleFormat>(s->codecpar->format),
+                                  s->codecpar->sample_rate,
+                                  0,
+                                  nullptr);
+
+  if (resampler_ && swr_init(resampler_) < 0) {
+    qWarning() << "Failed to initialize audio resampler";
+    swr_free(&resampler_);
+  }
+
+  // Leave room for the frame that overshoots the end of a read so it can't push out the start of it
+  ring_capacity_ = qMax(params_.sample_rate() * kRingSeconds, minimum_capacity + params_.sample_rate());
+  ring_.resize(params_.samples_to_bytes(ring_capacity_));
+  ring_head_ = 0;
+  ring_count_ = 0;
+  synced_ = false;
+}
+
+void FFmpegAudioStreamer::LoadSeekIndex()
+{
+  if (seek_index_loaded_) {
+    return;
+  }
+
+  QFile file(seek_index_filename_);
+
+  // The index may not have been created yet, try again next time
+  if (!file.open(QFile::ReadOnly)) {
+    return;
+  }
+
+  AVStream* s = instance_.stream();
+
+  // Demuxers that index the file themselves (e.g. MP4, Matroska with cues) already seek well, ours is for the ones
+  // that would otherwise have to read from the start of the file to find a timestamp
+  if (s->nb_index_entries > 0) {
+    seek_index_loaded_ = true;
+    return;
+  }
+
+  QDataStream ds(&file);
+  rational length;
+
+  // An index left over from an older version will be replaced by the indexer, try again next time
+  if (!ReadSeekIndexHeader(ds, &length)) {
+    return;
+  }
+
+  seek_index_loaded_ = true;
+
+  while (!ds.atEnd()) {
+    qint64 timestamp, position;
+
+    ds >> timestamp >> position;
+
+    if (ds.status() != QDataStream::Ok) {
+      break;
+    }
+
+    av_add_index_entry(s, position, timestamp, 0, 0, AVINDEX_KEYFRAME);
+  }
+}
+
+void FFmpegAudioStreamer::Seek(int64_t sample)
+{
+  LoadSeekIndex();
+
+  int64_t target = qMax(static_cast<int64_t>(0), sample - params_.sample_rate() / kSeekPrerollDivider);
+
+  seek_timestamp_ = Timecode::rescale_timestamp(target, params_.time_base(), time_base_) + start_time_;
+
+  instance_.Seek(seek_timestamp_);
+
+  // Re-initializing drops any samples still buffered from before the seek
+  swr_init(resampler_);
+
+  ring_head_ = 0;
+  ring_count_ = 0;
+  synced_ = false;
+  at_eof_ = false;
+}
+
+bool FFmpegAudioStreamer::DecodeNext()
+{
+  int ret = instance_.GetFrame(pkt_, frame_);
+
+  if (ret < 0) {
+    if (ret != AVERROR_EOF) {
+      char err_str[50];
+      av_strerror(ret, err_str, 50);
+      qWarning() << "Failed to decode audio:" << ret << err_str;
+    }
+
+    at_eof_ = true;
+    return false;
+  }
+
+  if (!synced_) {
+    // Find out where the seek actually landed
+    int64_t ts = frame_->best_effort_timestamp;
+
+    if (ts == AV_NOPTS_VALUE) {
+      ts = seek_timestamp_;
+    }
+
+    ring_start_ = Timecode::rescale_timestamp(ts - start_time_, time_base_, params_.time_base());
+    ring_head_ = 0;
+    ring_count_ = 0;
+    synced_ = true;
+  }
+
+  int out_count = swr_get_out_samples(resampler_, frame_->nb_samples);
+
+  convert_buffer_.resize(params_.samples_to_bytes(out_count));
+
+  uint8_t* out_data = reinterpret_cast<uint8_t*>(convert_buffer_.data());
+
+  out_count = swr_convert(resampler_,
+                          &out_data,
+                          out_count,
+                          const_cast<const uint8_t**>(frame_->extended_data),
+                          frame_->nb_samples);
+
+  if (out_count < 0) {
+    char err_str[50];
+    av_strerror(out_count, err_str, 50);
+    qWarning() << "libswresample failed with error:" << out_count << err_str;
+
+    at_eof_ = true;
+    return false;
+  }
+
+  Append(convert_buffer_.constData(), out_count);
+
+  return true;
+}
+
+void FFmpegAudioStreamer::Append(const char *data, int sample_count)
+{
+  if (sample_count > ring_capacity_) {
+    // Only the end of this will fit
+    int skip = sample_count - ring_capacity_;
+
+    data += params_.samples_to_bytes(skip);
+    ring_start_ = RingEnd() + skip;
+    ring_head_ = 0;
+    ring_count_ = 0;
+    sample_count = ring_capacity_;
+  }
+
+  // Drop the oldest samples to make room
+  int overflow = ring_count_ + sample_count - ring_capacity_;
+
+  if (overflow > 0) {
+    ring_head_ = (ring_head_ + overflow) % ring_capacity_;
+    ring_start_ += overflow;
+    ring_count_ -= overflow;
+  }
+
+  int write_pos = (ring_head_ + ring_count_) % ring_capacity_;
+  int first_part = qMin(sample_count, ring_capacity_ - write_pos);
+
+  memcpy(ring_.data() + params_.samples_to_bytes(write_pos), data, params_.samples_to_bytes(first_part));
+
+  if (first_part < sample_count) {
+    memcpy(ring_.data(), data + params_.samples_to_bytes(first_part), params_.samples_to_bytes(sample_count - first_part));
+  }
+
+  ring_count_ += sample_count;
+}
+
+void FFmpegAudioStreamer::CopyFromRing(int64_t start, int sample_count, char *dest) const
+{
+  int64_t copy_start = qMax(start, ring_start_);
+  int64_t copy_end = qMin(start + sample_count, RingEnd());
+
+  if (copy_end <= copy_start) {
+    return;
+  }
+
+  int read_pos = static_cast<int>((ring_head_ + (copy_start - ring_start_)) % ring_capacity_);
+  int copy_count = static_cast<int>(copy_end - copy_start);
+  int first_part = qMin(copy_count, ring_capacity_ - read_pos);
+
+  dest += params_.samples_to_bytes(static_cast<int>(copy_start - start));
+
+  memcpy(dest, ring_.constData() + params_.samples_to_bytes(read_pos), params_.samples_to_bytes(first_part));
+
+  if (first_part < copy_count) {
+    memcpy(dest + params_.samples_to_bytes(first_part), ring_.constData(), params_.samples_to_bytes(copy_count - first_part));
+  }
+}
+
+int64_t FFmpegAudioStreamer::RingEnd() const
+{
+  return ring_start_ + ring_count_;
+}
+
+void FFmpegAudioStreamer::WriteSeekIndexHeader(QDataStream &ds, const rational &length)
+{
+  ds << kSeekIndexMagic << static_cast<qint64>(length.numerator()) << static_cast<qint64>(length.denominator());
+}
+
+bool FFmpegAudioStreamer::ReadSeekIndexHeader(QDataStream &ds, rational *length)
+{
+  quint32 magic;
+  qint64 length_num, length_den;
+
+  ds >> magic >> length_num >> length_den;
+
+  if (ds.status() != QDataStream::Ok || magic != kSeekIndexMagic) {
+    return false;
+  }
+
+  *length = rational(length_num, length_den);
+
+  return true;
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,139 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef FFMPEGAUDIOSTREAMER_H
+#define FFMPEGAUDIOSTREAMER_H
+
+extern "C" {
+#include <libswresample/swresample.h>
+}
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QString>
+
+#include "codec/samplebuffer.h"
+#include "ffmpegdecoder.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Decodes and resamples audio straight from the source file as it's requested
+ *
+ * An alternative to indexing a whole audio stream into a WAV (and conforming another one for every set of
+ * AudioRenderingParams). Decoded audio is resampled to the requested params and kept in a small ring so that
+ * sequential reads (i.e. playback) only decode each packet once. Reads that fall outside the ring seek the source,
+ * using the seek index of packet positions created by FFmpegDecoder::Index() if there is one.
+ *
+ * Not thread-safe, each FFmpegDecoder owns its own streamer.
+ */
+class FFmpegAudioStreamer
+{
+public:
+  FFmpegAudioStreamer(const char* filename, int stream_index, const QString& seek_index_filename);
+
+  ~FFmpegAudioStreamer();
+
+  DISABLE_COPY_MOVE(FFmpegAudioStreamer)
+
+  bool IsValid() const;
+
+  /**
+   * @brief Retrieve `length` of audio starting at `time`, converted to `params`
+   *
+   * Any part of the range that the source doesn't cover is filled with silence.
+   */
+  SampleBufferPtr Read(const rational& time, const rational& length, const AudioRenderingParams& params);
+
+  /**
+   * @brief Write the header of a seek index, which records the length of the stream it covers
+   */
+  static void WriteSeekIndexHeader(QDataStream& ds, const rational& length);
+
+  /**
+   * @brief Read the header of a seek index, returns false if `ds` isn't a seek index this version can use
+   *
+   * On success, `ds` is left at the first entry.
+   */
+  static bool ReadSeekIndexHeader(QDataStream& ds, rational* length);
+
+private:
+  void SetParams(const AudioRenderingParams& params, int minimum_capacity);
+
+  void LoadSeekIndex();
+
+  void Seek(int64_t sample);
+
+  bool DecodeNext();
+
+  void Append(const char* data, int sample_count);
+
+  void CopyFromRing(int64_t start, int sample_count, char* dest) const;
+
+  int64_t RingEnd() const;
+
+  FFmpegDecoderInstance instance_;
+
+  QString seek_index_filename_;
+
+  bool seek_index_loaded_;
+
+  rational time_base_;
+
+  int64_t start_time_;
+
+  uint64_t source_channel_layout_;
+
+  SwrContext* resampler_;
+
+  AudioRenderingParams params_;
+
+  AVPacket* pkt_;
+
+  AVFrame* frame_;
+
+  QByteArray convert_buffer_;
+
+  /**
+   * @brief Packed PCM in params_, ring_count_ samples starting at ring_start_ (in samples at params_ rate)
+   */
+  QByteArray ring_;
+  int ring_capacity_;
+  int ring_head_;
+  int ring_count_;
+  int64_t ring_start_;
+
+  /**
+   * @brief Whether ring_start_ has been set from a decoded frame since the last seek
+   */
+  bool synced_;
+
+  /**
+   * @brief Timestamp to assume for the first frame after a seek if the decoder doesn't provide one
+   */
+  int64_t seek_timestamp_;
+
+  bool at_eof_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // FFMPEGAUDIOSTREAMER_H
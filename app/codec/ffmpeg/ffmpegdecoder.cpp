@@ -27,10 +27,15 @@ extern "C" {
 #include <libavutil/pixdesc.h>
 }
 
+#include <QCoreApplication>
+#include <QDataStream>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 #include <QString>
+#include <QThread>
+#include <QTimer>
 #include <QtMath>
 
 #include "codec/waveinput.h"
@@ -38,7 +43,10 @@ extern "C" {
 #include "common/filefunctions.h"
 #include "common/functiontimer.h"
 #include "common/timecodefunctions.h"
+#include "config/config.h"
+#include "ffmpegaudiostreamer.h"
 #include "ffmpegcommon.h"
+#include "render/backend/indexmanager.h"
 #include "render/diskmanager.h"
 #include "render/pixelformat.h"
 
@@ -46,14 +54,38 @@ OLIVE_NAMESPACE_ENTER
 
 QHash< Stream*, QList<FFmpegDecoderInstance*> > FFmpegDecoder::instance_map_;
 QMutex FFmpegDecoder::instance_map_lock_;
-QHash< Stream*, FFmpegFramePool* > FFmpegDecoder::frame_pool_map_;
+QHash< Stream*, std::shared_ptr<FFmpegFramePool> > FFmpegDecoder::frame_pool_map_;
+QHash< Stream*, FFmpegDecoderStatistics* > FFmpegDecoder::statistics_map_;
+QHash< Stream*, int > FFmpegDecoder::decoder_count_map_;
 
 // FIXME: Hardcoded, ideally this value is dynamically chosen based on memory restraints
 const int FFmpegDecoderInstance::kMaxFrameLife = 2000;
 
+// Decode up to this fraction of a second past the last frame that was requested
+const int kReadAheadDivider = 2;
+
+// Seconds between entries in the audio seek index
+const int kSeekIndexInterval = 1;
+
+// Minimum number of new frames before a partial video frame index is published
+const int kFrameIndexPublishInterval = 1024;
+
+// Bytes of decoded frames that the instances of one video stream may hold between them
+const qint64 kInstanceMemoryBudget = 536870912;
+
+// Number of scaled frames allocated at a time for handing decoded video to the renderer
+const int kScaledFramePoolSize = 8;
+
+// Milliseconds an instance beyond those needed by open decoders can go unused before it's destroyed
+const int kMaxInstanceIdle = 10000;
+
 FFmpegDecoder::FFmpegDecoder() :
   scale_ctx_(nullptr),
-  scale_divider_(0)
+  scale_divider_(0),
+  src_is_yuv_(false),
+  audio_streamer_(nullptr),
+  conformed_input_(nullptr),
+  max_instances_(1)
 {
 }
 
@@ -72,13 +104,9 @@ bool FFmpegDecoder::Open()
 
   Q_ASSERT(stream());
 
-  // Convert QString to a C string
-  QByteArray fn_bytes = stream()->footage()->filename().toUtf8();
-
-  FFmpegDecoderInstance* our_instance_ = new FFmpegDecoderInstance(fn_bytes.constData(), stream()->index());
+  FFmpegDecoderInstance* our_instance_ = CreateInstance();
 
-  if (!our_instance_->IsValid()) {
-    delete our_instance_;
+  if (!our_instance_) {
     return false;
   }
 
@@ -87,22 +115,22 @@ bool FFmpegDecoder::Open()
     src_pix_fmt_ = static_cast<AVPixelFormat>(our_instance_->stream()->codecpar->format);
     ideal_pix_fmt_ = FFmpegCommon::GetCompatiblePixelFormat(src_pix_fmt_);
 
-    {
-      QMutexLocker map_locker(&instance_map_lock_);
-
-      // FIXME: Test code, this should be changed later
-      FFmpegFramePool* frame_pool = frame_pool_map_.value(stream().get());
-
-      if (!frame_pool) {
-        frame_pool = new FFmpegFramePool(256,
-                                         our_instance_->stream()->codecpar->width,
-                                         our_instance_->stream()->codecpar->height,
-                                         static_cast<AVPixelFormat>(our_instance_->stream()->codecpar->format));
-        frame_pool_map_.insert(stream().get(), frame_pool);
-      }
-
-      our_instance_->SetFramePool(frame_pool);
-      // End test code
+    // Each instance caches up to two seconds of frames, see how many of those fit in the budget
+    AVStream* avstream = our_instance_->stream();
+    double frame_rate = av_q2d(avstream->avg_frame_rate.num ? avstream->avg_frame_rate : avstream->r_frame_rate);
+    qint64 frame_size = av_image_get_buffer_size(src_pix_fmt_,
+                                                 avstream->codecpar->width,
+                                                 avstream->codecpar->height,
+                                                 1);
+    qint64 instance_size = frame_size * (qCeil(2.0 * frame_rate) + 1);
+
+    if (instance_size > 0) {
+      // There's no point in more instances than there are threads to decode with
+      max_instances_ = qBound(1,
+                              static_cast<int>(kInstanceMemoryBudget / instance_size),
+                              qMax(1, QThread::idealThreadCount()));
+    } else {
+      max_instances_ = 1;
     }
 
     // Determine which Olive native pixel format we retrieved
@@ -125,7 +153,47 @@ bool FFmpegDecoder::Open()
       qFatal("Invalid output format");
     }
 
+    // Planar 8-bit Y'CbCr can be converted by the renderer instead of sws_scale
+    switch (src_pix_fmt_) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUV444P:
+    case AV_PIX_FMT_YUVJ444P:
+    {
+      AVCodecParameters* codecpar = our_instance_->stream()->codecpar;
+
+      src_is_yuv_ = true;
+
+      av_pix_fmt_get_chroma_sub_sample(src_pix_fmt_, &yuv_layout_.chroma_shift_x, &yuv_layout_.chroma_shift_y);
+
+      // FFmpeg's own default for untagged footage is BT.601, except for HD where BT.709 is far more likely
+      if (codecpar->color_space == AVCOL_SPC_UNSPECIFIED) {
+        yuv_layout_.rec709 = (codecpar->height > 576);
+      } else {
+        yuv_layout_.rec709 = (codecpar->color_space == AVCOL_SPC_BT709);
+      }
+
+      yuv_layout_.full_range = (codecpar->color_range == AVCOL_RANGE_JPEG
+                                || src_pix_fmt_ == AV_PIX_FMT_YUVJ420P
+                                || src_pix_fmt_ == AV_PIX_FMT_YUVJ422P
+                                || src_pix_fmt_ == AV_PIX_FMT_YUVJ444P);
+      break;
+    }
+    default:
+      src_is_yuv_ = false;
+    }
+
     aspect_ratio_ = our_instance_->sample_aspect_ratio();
+
+    // Make sure there's a frame index on its way for seeking
+    if (!std::static_pointer_cast<VideoStream>(stream())->is_frame_index_ready()) {
+      QMetaObject::invokeMethod(IndexManager::instance(),
+                                "StartIndexingStream",
+                                Qt::QueuedConnection,
+                                OLIVE_NS_ARG(StreamPtr, stream()));
+    }
   }
 
   time_base_ = our_instance_->stream()->time_base;
@@ -140,6 +208,10 @@ bool FFmpegDecoder::Open()
     QList<FFmpegDecoderInstance*> list = instance_map_.value(stream().get());
     list.append(our_instance_);
     instance_map_.insert(stream().get(), list);
+
+    decoder_count_map_.insert(stream().get(), decoder_count_map_.value(stream().get()) + 1);
+
+    frame_pool_ = frame_pool_map_.value(stream().get());
   }
 
   return true;
@@ -160,7 +232,7 @@ Decoder::RetrieveState FFmpegDecoder::GetRetrieveState(const rational& time)
   } else if (stream()->type() == Stream::kAudio) {
     AudioStreamPtr audio_stream = std::static_pointer_cast<AudioStream>(stream());
 
-    if (time > audio_stream->index_length() && !audio_stream->index_done()) {
+    if (!CanStreamAudio() && time > audio_stream->index_length() && !audio_stream->index_done()) {
       return kIndexUnavailable;
     }
   }
@@ -168,7 +240,7 @@ Decoder::RetrieveState FFmpegDecoder::GetRetrieveState(const rational& time)
   return kReady;
 }
 
-FramePtr FFmpegDecoder::RetrieveVideo(const rational &timecode, const int &divider)
+FramePtr FFmpegDecoder::RetrieveVideo(const rational &timecode, const int &divider, bool allow_yuv)
 {
   QMutexLocker locker(&mutex_);
 
@@ -183,17 +255,55 @@ FramePtr FFmpegDecoder::RetrieveVideo(const rational &timecode, const int &divid
 
   int64_t target_ts = Timecode::time_to_timestamp(timecode, time_base_) + start_time_;
 
+  FrameIndexPtr index = std::static_pointer_cast<VideoStream>(stream())->frame_index();
+
   FFmpegDecoderInstance* working_instance = nullptr;
   FFmpegFramePool::ElementPtr return_frame = nullptr;
 
+  QList<FFmpegDecoderInstance*> retired;
+  bool can_spawn = true;
+
   // Find instance
   do {
     QMutexLocker list_locker(&instance_map_lock_);
 
-    QList<FFmpegDecoderInstance*> non_ideal_contenders;
+    QList<FFmpegDecoderInstance*> idle;
+
+    QList<FFmpegDecoderInstance*> reading_ahead;
 
     QList<FFmpegDecoderInstance*> instances = instance_map_.value(stream().get());
 
+    // Retire extra instances that haven't been needed for a while, every open decoder keeps at least one
+    int needed_instances = decoder_count_map_.value(stream().get());
+    int64_t idle_since = FFmpegFramePool::AccessClock() - kMaxInstanceIdle;
+
+    for (int j=0; j<instances.size() && instances.size() > needed_instances; ) {
+      FFmpegDecoderInstance* i = instances.at(j);
+
+      if (i->cache_lock()->tryLock()) {
+        bool stale = !i->IsWorking() && !i->HasWaiters() && i->last_used() < idle_since;
+
+        i->cache_lock()->unlock();
+
+        if (stale) {
+          instances.removeAt(j);
+          retired.append(i);
+          continue;
+        }
+      }
+
+      j++;
+    }
+
+    if (!retired.isEmpty()) {
+      instance_map_.insert(stream().get(), instances);
+    }
+
+    // Cheapest idle instance to reach this frame with
+    FFmpegDecoderInstance* best = nullptr;
+    int64_t best_cost = 0;
+    bool best_seeks = false;
+
     foreach (FFmpegDecoderInstance* i, instances) {
 
       i->cache_lock()->lock();
@@ -206,6 +316,10 @@ FramePtr FFmpegDecoder::RetrieveVideo(const rational &timecode, const int &divid
 
         // Get the frame from this cache
         return_frame = i->GetFrameFromCache(target_ts);
+        i->MarkUsed();
+
+        // Keep this instance ahead of us
+        i->RequestReadAhead(target_ts);
 
         // Got our frame, allow cache to continue
         i->cache_lock()->unlock();
@@ -219,11 +333,13 @@ FramePtr FFmpegDecoder::RetrieveVideo(const rational &timecode, const int &divid
         if (i->IsWorking()) {
           do {
             // Allow instance to continue to the next frame
-            i->cache_wait_cond()->wait(i->cache_lock());
+            i->WaitForCache();
 
             // See if the cache now contains this frame, if so we'll exit this loop
             if (i->CacheContainsTime(target_ts)) {
               return_frame = i->GetFrameFromCache(target_ts);
+              i->MarkUsed();
+              i->RequestReadAhead(target_ts);
             } else if (!i->IsWorking()) {
               // Grab this instance and continue it
               working_instance = i;
@@ -243,90 +359,190 @@ FramePtr FFmpegDecoder::RetrieveVideo(const rational &timecode, const int &divid
       } else if (i->IsWorking()) {
 
         // Ignore currently working instances
+        if (i->IsReadingAhead()) {
+          reading_ahead.append(i);
+        }
+
         i->cache_lock()->unlock();
 
-      } else if (i->CacheIsEmpty()) {
+      } else {
 
-        // Prioritize this cache over others (leaves this instance LOCKED in case we end up using it later)
-        non_ideal_contenders.prepend(i);
+        // Rank by how much decoding it'd take to get this instance to our frame, preferring whichever has been
+        // unused the longest on a tie since its cache is the least likely to be wanted again (leaves this instance
+        // LOCKED in case we end up using it later)
+        bool seeks;
+        int64_t cost = i->CostToReach(target_ts, index, &seeks);
+
+        if (!best
+            || cost < best_cost
+            || (cost == best_cost && i->last_used() < best->last_used())) {
+          best = i;
+          best_cost = cost;
+          best_seeks = seeks;
+        }
 
-      } else {
+        idle.append(i);
 
-        // De-prioritize this cache (leaves this instance LOCKED in case we end up using it later)
-        non_ideal_contenders.append(i);
+      }
+    }
+
+    // Rather than make an instance abandon its place in the file, open another one if the budget allows it
+    bool spawn = false;
 
+    if (!return_frame && !working_instance) {
+      if (can_spawn && (!best || best_seeks) && instances.size() < max_instances_) {
+        spawn = true;
+      } else {
+        working_instance = best;
       }
     }
 
-    // If we didn't find a suitable contender, grab the first non-suitable and roll with that
-    if (!return_frame && !working_instance && !non_ideal_contenders.isEmpty()) {
-      working_instance = non_ideal_contenders.takeFirst();
+    // For all instances we left locked but didn't end up using, unlock them now
+    foreach (FFmpegDecoderInstance* unsuitable_instance, idle) {
+      if (unsuitable_instance != working_instance) {
+        unsuitable_instance->cache_lock()->unlock();
+      }
     }
 
-    // For all instances we left locked but didn't end up using, lock them now
-    foreach (FFmpegDecoderInstance* unsuitable_instance, non_ideal_contenders) {
-      unsuitable_instance->cache_lock()->unlock();
+    if (spawn) {
+      // Opening a file can take a while, don't hold up other threads while we do it
+      list_locker.unlock();
+
+      FFmpegDecoderInstance* spawned = CreateInstance();
+
+      if (spawned) {
+        spawned->cache_lock()->lock();
+
+        list_locker.relock();
+        instance_map_[stream().get()].append(spawned);
+
+        working_instance = spawned;
+      } else {
+        // Don't keep trying, just use what we already have
+        can_spawn = false;
+      }
+    } else if (!return_frame && !working_instance) {
+      // If every instance is busy, stop any that are only reading ahead so we can use them on the next pass
+      foreach (FFmpegDecoderInstance* i, reading_ahead) {
+        i->cache_lock()->lock();
+        i->InterruptReadAhead();
+        i->cache_lock()->unlock();
+      }
     }
   } while (!return_frame && !working_instance);
 
+  // Nothing can find these anymore
+  DestroyInstances(retired);
+
   if (!return_frame && working_instance) {
 
     // This instance SHOULD remain locked from our earlier loop, making this operation safe
     working_instance->SetWorking(true);
 
     // Retrieve frame
-    return_frame = working_instance->RetrieveFrame(target_ts, true);
+    return_frame = working_instance->RetrieveFrame(target_ts, true, index);
+
+    if (return_frame) {
+      return_frame->access();
+    }
 
     // Set working to false and wake any threads waiting
     working_instance->cache_lock()->lock();
     working_instance->SetWorking(false);
+    working_instance->MarkUsed();
+    working_instance->RequestReadAhead(target_ts);
     working_instance->cache_wait_cond()->wakeAll();
     working_instance->cache_lock()->unlock();
   }
 
-  // We found the frame, we'll return a copy
+  // We found the frame, hand it over in a format the rest of the pipeline understands
   if (return_frame) {
-    if (divider != scale_divider_) {
-      FreeScaler();
-      InitScaler(divider);
-    }
-
     VideoStream* vs = static_cast<VideoStream*>(stream().get());
 
     // Create frame to return
-    FramePtr copy = Frame::Create();
-    copy->set_video_params(VideoRenderingParams(vs->width() / divider,
-                                                vs->height() / divider,
-                                                native_pix_fmt_));
-    copy->set_timestamp(Timecode::timestamp_to_time(target_ts, time_base_));
-    copy->set_sample_aspect_ratio(aspect_ratio_);
-    copy->allocate();
-
-    // Align buffer to data/linesize points that can be passed to sws_scale
-    uint8_t* input_data[4];
-    int input_linesize[4];
-
-    av_image_fill_arrays(input_data,
-                         input_linesize,
-                         reinterpret_cast<const uint8_t*>(return_frame->data()),
-                         src_pix_fmt_,
-                         vs->width(),
-                         vs->height(),
-                         1);
-
-    // Convert frame to RGB/A for the rest of the pipeline
-    uint8_t* output_data = reinterpret_cast<uint8_t*>(copy->data());
-    int output_linesize = copy->width() * PixelFormat::BytesPerPixel(native_pix_fmt_);
-
-    sws_scale(scale_ctx_,
-              input_data,
-              input_linesize,
-              0,
-              vs->height(),
-              &output_data,
-              &output_linesize);
-
-    return copy;
+    FramePtr frame = Frame::Create();
+    frame->set_timestamp(Timecode::timestamp_to_time(target_ts, time_base_));
+    frame->set_sample_aspect_ratio(aspect_ratio_);
+
+    std::shared_ptr<PooledFrameBuffer> buffer = std::make_shared<PooledFrameBuffer>();
+
+    if (allow_yuv && src_is_yuv_) {
+
+      // The caller converts and scales Y'CbCr itself, share the decoded planes rather than converting them here
+      frame->set_video_params(VideoRenderingParams(vs->width(), vs->height(), native_pix_fmt_));
+
+      buffer->pool = frame_pool_;
+      buffer->element = return_frame;
+
+      frame->set_buffer(reinterpret_cast<char*>(return_frame->data()),
+                        av_image_get_buffer_size(src_pix_fmt_, vs->width(), vs->height(), 1),
+                        buffer);
+      frame->set_yuv_layout(yuv_layout_);
+
+      return frame;
+    }
+
+    frame->set_video_params(VideoRenderingParams(vs->width() / divider,
+                                                 vs->height() / divider,
+                                                 native_pix_fmt_));
+
+    if (divider == 1 && src_pix_fmt_ == ideal_pix_fmt_) {
+
+      // The decoded frame is already usable as-is, share it rather than copying it
+      buffer->pool = frame_pool_;
+      buffer->element = return_frame;
+
+    } else {
+
+      if (divider != scale_divider_) {
+        FreeScaler();
+        InitScaler(divider);
+      }
+
+      if (!scale_ctx_) {
+        qCritical() << "Failed to create scaler for" << vs->footage()->filename();
+        return nullptr;
+      }
+
+      buffer->pool = scaled_pool_;
+      buffer->element = scaled_pool_->Get();
+
+      if (!buffer->element) {
+        qCritical() << "Scaled frame pool failed to return a valid frame - out of memory?";
+        return nullptr;
+      }
+
+      // Align buffer to data/linesize points that can be passed to sws_scale
+      uint8_t* input_data[4];
+      int input_linesize[4];
+
+      av_image_fill_arrays(input_data,
+                           input_linesize,
+                           reinterpret_cast<const uint8_t*>(return_frame->data()),
+                           src_pix_fmt_,
+                           vs->width(),
+                           vs->height(),
+                           1);
+
+      // Convert frame to RGB/A for the rest of the pipeline
+      uint8_t* output_data = buffer->element->data();
+      int output_linesize = frame->width() * PixelFormat::BytesPerPixel(native_pix_fmt_);
+
+      sws_scale(scale_ctx_,
+                input_data,
+                input_linesize,
+                0,
+                vs->height(),
+                &output_data,
+                &output_linesize);
+
+    }
+
+    frame->set_buffer(reinterpret_cast<char*>(buffer->element->data()),
+                      PixelFormat::GetBufferSize(native_pix_fmt_, frame->width(), frame->height()),
+                      buffer);
+
+    return frame;
   }
 
   return nullptr;
@@ -345,46 +561,111 @@ SampleBufferPtr FFmpegDecoder::RetrieveAudio(const rational &timecode, const rat
     return nullptr;
   }
 
-  QString wav_fn = GetConformedFilename(params);
-  WaveInput input(wav_fn);
+  // Keep using the file we have open as long as the params haven't changed
+  if (conformed_input_ && conformed_input_->params() != params) {
+    delete conformed_input_;
+    conformed_input_ = nullptr;
+  }
 
-  if (input.open()) {
-    const AudioRenderingParams& input_params = input.params();
+  if (!conformed_input_ && CanStreamAudio() && !HasConformedVersion(params)) {
+    // Nothing has been cached for these params, decode straight from the source instead
+    if (!audio_streamer_) {
+      QByteArray fn_bytes = stream()->footage()->filename().toUtf8();
 
-    // Read bytes from wav
-    QByteArray packed_data = input.read(input_params.time_to_bytes(timecode), input_params.time_to_bytes(length));
-    input.close();
+      audio_streamer_ = new FFmpegAudioStreamer(fn_bytes.constData(), stream()->index(), GetSeekIndexFilename());
 
-    // Create sample buffer
-    SampleBufferPtr sample_buffer = SampleBuffer::CreateFromPackedData(input_params, packed_data);
+      if (!audio_streamer_->IsValid()) {
+        delete audio_streamer_;
+        audio_streamer_ = nullptr;
+        return nullptr;
+      }
+    }
 
-    return sample_buffer;
+    return audio_streamer_->Read(timecode, length, params);
   }
 
-  qCritical() << "Failed to open cached file" << wav_fn;
+  if (!conformed_input_) {
+    QString wav_fn = GetConformedFilename(params);
 
-  return nullptr;
+    conformed_input_ = new WaveInput(wav_fn);
+
+    if (!conformed_input_->open()) {
+      qCritical() << "Failed to open cached file" << wav_fn;
+      delete conformed_input_;
+      conformed_input_ = nullptr;
+      return nullptr;
+    }
+
+    // The index may still be growing, in which case a mapping would go out of date
+    if (std::static_pointer_cast<AudioStream>(stream())->index_done()) {
+      conformed_input_->map();
+    }
+  }
+
+  const AudioRenderingParams& input_params = conformed_input_->params();
+
+  int offset = input_params.time_to_bytes(timecode);
+  int byte_length = input_params.time_to_bytes(length);
+
+  SampleBufferPtr sample_buffer;
+
+  if (conformed_input_->is_mapped()) {
+    // Slice straight out of the mapping
+    const char* packed_data = conformed_input_->data(offset, &byte_length);
+
+    sample_buffer = SampleBuffer::CreateFromPackedData(input_params, packed_data, byte_length);
+  } else {
+    sample_buffer = SampleBuffer::CreateFromPackedData(input_params, conformed_input_->read(offset, byte_length));
+
+    // Re-open next time so we see any data that's been indexed since
+    delete conformed_input_;
+    conformed_input_ = nullptr;
+  }
+
+  return sample_buffer;
 }
 
 void FFmpegDecoder::Close()
 {
   QMutexLocker locker(&mutex_);
 
-  {
-    // Clear whichever instance is not in use and is least useful (there are only ever as many instances as there are
-    // threads so if this thread is closing, an instance MUST be inactive)
-    QMutexLocker l(&instance_map_lock_);
+  if (open_) {
+    QList<FFmpegDecoderInstance*> removed;
+    std::shared_ptr<FFmpegFramePool> frame_pool;
+    FFmpegDecoderStatistics* statistics = nullptr;
 
-    QList<FFmpegDecoderInstance*> list = instance_map_.value(stream().get());
+    {
+      // Clear whichever instances are not in use and are least useful until there are only as many as the remaining
+      // decoders need (there are only ever as many working instances as there are threads so if this thread is
+      // closing, an instance MUST be inactive)
+      QMutexLocker l(&instance_map_lock_);
+
+      int needed_instances = decoder_count_map_.value(stream().get()) - 1;
+
+      if (needed_instances > 0) {
+        decoder_count_map_.insert(stream().get(), needed_instances);
+      } else {
+        decoder_count_map_.remove(stream().get());
+      }
+
+      QList<FFmpegDecoderInstance*> list = instance_map_.value(stream().get());
 
-    if (!list.isEmpty()) {
       // Rank the instances by least useful (the top one should be one that isn't working and isn't in use)
       QList<FFmpegDecoderInstance*> least_useful;
 
       foreach (FFmpegDecoderInstance* i, list) {
         i->cache_lock()->lock();
 
-        if (i->IsWorking()) {
+        if (i->IsReadingAhead()) {
+          // Reading ahead is just speculative, stop it so this instance can be considered
+          i->InterruptReadAhead();
+
+          while (i->IsWorking()) {
+            i->cache_wait_cond()->wait(i->cache_lock());
+          }
+        }
+
+        if (i->IsWorking() || i->HasWaiters()) {
           // Don't bother any currently working instances
           i->cache_lock()->unlock();
           continue;
@@ -398,25 +679,121 @@ void FFmpegDecoder::Close()
       }
 
       // Remove the least useful from the list and re-insert it into the map
-      list.removeOne(least_useful.takeFirst());
-      instance_map_.insert(stream().get(), list);
+      while (list.size() > needed_instances && !least_useful.isEmpty()) {
+        FFmpegDecoderInstance* i = least_useful.takeFirst();
+        list.removeOne(i);
+        removed.append(i);
+
+        // Nothing can find this instance anymore
+        i->cache_lock()->unlock();
+      }
 
       // Unlock all the instances we locked
       foreach (FFmpegDecoderInstance* i, least_useful) {
         i->cache_lock()->unlock();
       }
 
-      // If there are no more instances, destroy frame pool
       if (list.isEmpty()) {
-        FFmpegFramePool* frame_pool = frame_pool_map_.take(stream().get());
-        delete frame_pool;
+        // If there are no more instances, destroy frame pool
+        instance_map_.remove(stream().get());
+        frame_pool = frame_pool_map_.take(stream().get());
+        statistics = statistics_map_.take(stream().get());
+      } else {
+        instance_map_.insert(stream().get(), list);
       }
     }
+
+    // Make sure the removed instances stop decoding, the pool itself goes once every frame from it has been released
+    DestroyInstances(removed);
+    frame_pool = nullptr;
+
+    delete statistics;
   }
 
   ClearResources();
 }
 
+bool FFmpegDecoder::GetStatistics(Stream *stream, qint64 *seeks, qint64 *decoded_frames, qint64 *wasted_frames)
+{
+  QMutexLocker l(&instance_map_lock_);
+
+  FFmpegDecoderStatistics* statistics = statistics_map_.value(stream);
+
+  if (!statistics) {
+    return false;
+  }
+
+  *seeks = statistics->seeks.loadAcquire();
+  *decoded_frames = statistics->decoded_frames.loadAcquire();
+  *wasted_frames = statistics->wasted_frames.loadAcquire();
+
+  return true;
+}
+
+FFmpegDecoderInstance *FFmpegDecoder::CreateInstance()
+{
+  // Convert QString to a C string
+  QByteArray fn_bytes = stream()->footage()->filename().toUtf8();
+
+  FFmpegDecoderInstance* instance = new FFmpegDecoderInstance(fn_bytes.constData(), stream()->index());
+
+  if (!instance->IsValid()) {
+    delete instance;
+    return nullptr;
+  }
+
+  QMutexLocker map_locker(&instance_map_lock_);
+
+  if (stream()->type() == Stream::kVideo) {
+    // FIXME: Test code, this should be changed later
+    std::shared_ptr<FFmpegFramePool> frame_pool = frame_pool_map_.value(stream().get());
+
+    if (!frame_pool) {
+      frame_pool = std::make_shared<FFmpegFramePool>(256,
+                                                     instance->stream()->codecpar->width,
+                                                     instance->stream()->codecpar->height,
+                                                     static_cast<AVPixelFormat>(instance->stream()->codecpar->format));
+      frame_pool_map_.insert(stream().get(), frame_pool);
+    }
+
+    instance->SetFramePool(frame_pool.get());
+    // End test code
+  }
+
+  FFmpegDecoderStatistics* statistics = statistics_map_.value(stream().get());
+
+  if (!statistics) {
+    statistics = new FFmpegDecoderStatistics();
+    statistics_map_.insert(stream().get(), statistics);
+  }
+
+  instance->SetStatistics(statistics);
+
+  return instance;
+}
+
+void FFmpegDecoder::DestroyInstances(const QList<FFmpegDecoderInstance *> &instances)
+{
+  if (instances.isEmpty()) {
+    return;
+  }
+
+  if (QThread::currentThread() == qApp->thread()) {
+    qDeleteAll(instances);
+    return;
+  }
+
+  // Render threads can't stop the instances' timers without blocking on the main thread, which may itself be waiting
+  // on us, so only do the parts that are safe here
+  foreach (FFmpegDecoderInstance* i, instances) {
+    i->Detach();
+  }
+
+  QTimer::singleShot(0, qApp, [instances](){
+    qDeleteAll(instances);
+  });
+}
+
 QString FFmpegDecoder::id()
 {
   return QStringLiteral("ffmpeg");
@@ -621,19 +998,204 @@ void FFmpegDecoder::Index(const QAtomicInt* cancelled)
 
         input.close();
       }
+    } else if (CanStreamAudio()) {
+      QFile seek_index(GetSeekIndexFilename());
+      bool have_seek_index = false;
+      rational length;
+
+      if (seek_index.open(QFile::ReadOnly)) {
+        QDataStream ds(&seek_index);
+
+        have_seek_index = FFmpegAudioStreamer::ReadSeekIndexHeader(ds, &length);
+
+        seek_index.close();
+      }
+
+      if (have_seek_index) {
+        std::static_pointer_cast<AudioStream>(stream())->set_index_length(length);
+        std::static_pointer_cast<AudioStream>(stream())->set_index_done(true);
+      } else {
+        AudioSeekIndex(cancelled);
+      }
     } else {
       UnconditionalAudioIndex(cancelled);
     }
 
+  } else if (stream()->type() == Stream::kVideo) {
+
+    VideoFrameIndex(cancelled);
+
   }
 }
 
+bool FFmpegDecoder::CanStreamAudio()
+{
+  return Config::Current()["StreamAudioFromSource"].toBool();
+}
+
 QString FFmpegDecoder::GetIndexFilename()
 {
   return GetMediaIndexFilename(GetUniqueFileIdentifier(stream()->footage()->filename()))
       .append(QString::number(stream()->index()));
 }
 
+QString FFmpegDecoder::GetSeekIndexFilename()
+{
+  return GetIndexFilename().append(QStringLiteral(".seek"));
+}
+
+void FFmpegDecoder::AudioSeekIndex(const QAtomicInt *cancelled)
+{
+  QByteArray fn_bytes = stream()->footage()->filename().toUtf8();
+
+  FFmpegDecoderInstance index_instance(fn_bytes.constData(), stream()->index());
+
+  if (!index_instance.IsValid()) {
+    return;
+  }
+
+  AudioStreamPtr audio_stream = std::static_pointer_cast<AudioStream>(stream());
+
+  audio_stream->clear_index();
+
+  // Streamers may be reading this file, so only replace it once it's complete
+  QSaveFile index_file(GetSeekIndexFilename());
+
+  if (!index_file.open(QFile::WriteOnly)) {
+    qWarning() << "Failed to open seek index for writing:" << index_file.fileName();
+    return;
+  }
+
+  // The header needs the stream's length, so entries are collected here until it's known
+  QByteArray entries;
+  QDataStream ds(&entries, QIODevice::WriteOnly);
+
+  AVStream* avstream = index_instance.stream();
+  int64_t interval = Timecode::time_to_timestamp(rational(kSeekIndexInterval), avstream->time_base);
+  int64_t stream_start = (avstream->start_time == AV_NOPTS_VALUE) ? 0 : avstream->start_time;
+  int64_t last_entry = AV_NOPTS_VALUE;
+  int64_t end_ts = stream_start;
+
+  AVPacket* pkt = av_packet_alloc();
+  int ret;
+
+  while ((ret = index_instance.GetPacket(pkt)) >= 0) {
+    // Check if we have a `cancelled` ptr and its value
+    if (cancelled && *cancelled) {
+      break;
+    }
+
+    int64_t ts = (pkt->pts == AV_NOPTS_VALUE) ? pkt->dts : pkt->pts;
+
+    if (ts == AV_NOPTS_VALUE) {
+      continue;
+    }
+
+    if (pkt->pos >= 0
+        && (pkt->flags & AV_PKT_FLAG_KEY)
+        && (last_entry == AV_NOPTS_VALUE || ts >= last_entry + interval)) {
+      ds << static_cast<qint64>(ts) << static_cast<qint64>(pkt->pos);
+      last_entry = ts;
+    }
+
+    end_ts = qMax(end_ts, ts + pkt->duration);
+
+    SignalIndexProgress(ts);
+  }
+
+  av_packet_free(&pkt);
+
+  if (ret != AVERROR_EOF) {
+    if (ret < 0) {
+      char err_str[50];
+      av_strerror(ret, err_str, 50);
+      qWarning() << "Failed to create seek index:" << ret << err_str;
+    }
+
+    index_file.cancelWriting();
+    return;
+  }
+
+  rational length = Timecode::timestamp_to_time(end_ts - stream_start, avstream->time_base);
+
+  QDataStream header(&index_file);
+  FFmpegAudioStreamer::WriteSeekIndexHeader(header, length);
+  index_file.write(entries);
+
+  if (index_file.commit()) {
+    audio_stream->set_index_length(length);
+    audio_stream->set_index_done(true);
+  }
+}
+
+void FFmpegDecoder::VideoFrameIndex(const QAtomicInt *cancelled)
+{
+  VideoStreamPtr video_stream = std::static_pointer_cast<VideoStream>(stream());
+
+  if (video_stream->is_frame_index_ready()
+      || (video_stream->load_frame_index(GetIndexFilename()) && video_stream->is_frame_index_ready())) {
+    return;
+  }
+
+  QByteArray fn_bytes = stream()->footage()->filename().toUtf8();
+
+  FFmpegDecoderInstance index_instance(fn_bytes.constData(), stream()->index());
+
+  if (!index_instance.IsValid()) {
+    return;
+  }
+
+  FrameIndex index;
+  int next_publish = kFrameIndexPublishInterval;
+
+  AVPacket* pkt = av_packet_alloc();
+  int ret;
+
+  while ((ret = index_instance.GetPacket(pkt)) >= 0) {
+    // Check if we have a `cancelled` ptr and its value
+    if (cancelled && *cancelled) {
+      break;
+    }
+
+    int64_t ts = (pkt->pts == AV_NOPTS_VALUE) ? pkt->dts : pkt->pts;
+
+    if (ts == AV_NOPTS_VALUE) {
+      continue;
+    }
+
+    index.Append(ts, pkt->pos, pkt->flags & AV_PKT_FLAG_KEY);
+
+    // Publishing shares the index's data, so the next append copies it. Growing the interval with the index keeps
+    // that linear overall.
+    if (index.count() >= next_publish) {
+      video_stream->set_frame_index(std::make_shared<FrameIndex>(index));
+      next_publish = index.count() + qMax(kFrameIndexPublishInterval, index.count() / 4);
+    }
+
+    SignalIndexProgress(ts);
+  }
+
+  av_packet_free(&pkt);
+
+  if (ret != AVERROR_EOF) {
+    if (ret < 0) {
+      char err_str[50];
+      av_strerror(ret, err_str, 50);
+      qWarning() << "Failed to create frame index:" << ret << err_str;
+    }
+
+    return;
+  }
+
+  index.SetComplete();
+
+  video_stream->set_frame_index(std::make_shared<FrameIndex>(index));
+
+  if (!index.Save(GetIndexFilename())) {
+    qWarning() << "Failed to save frame index:" << GetIndexFilename();
+  }
+}
+
 void FFmpegDecoder::UnconditionalAudioIndex(const QAtomicInt* cancelled)
 {
   // Iterate through each audio frame and extract the PCM data
@@ -790,13 +1352,7 @@ int FFmpegDecoderInstance::GetFrame(AVPacket *pkt, AVFrame *frame)
   while ((ret = avcodec_receive_frame(codec_ctx_, frame)) == AVERROR(EAGAIN) && !eof) {
 
     // Find next packet in the correct stream index
-    do {
-      // Free buffer in packet if there is one
-      av_packet_unref(pkt);
-
-      // Read packet from file
-      ret = av_read_frame(fmt_ctx_, pkt);
-    } while (pkt->stream_index != avstream_->index && ret >= 0);
+    ret = GetPacket(pkt);
 
     if (ret == AVERROR_EOF) {
       // Don't break so that receive gets called again, but don't try to read again
@@ -823,6 +1379,21 @@ int FFmpegDecoderInstance::GetFrame(AVPacket *pkt, AVFrame *frame)
   return ret;
 }
 
+int FFmpegDecoderInstance::GetPacket(AVPacket *pkt)
+{
+  int ret;
+
+  do {
+    // Free buffer in packet if there is one
+    av_packet_unref(pkt);
+
+    // Read packet from file
+    ret = av_read_frame(fmt_ctx_, pkt);
+  } while (pkt->stream_index != avstream_->index && ret >= 0);
+
+  return ret;
+}
+
 QMutex *FFmpegDecoderInstance::cache_lock()
 {
   return &cache_lock_;
@@ -843,9 +1414,121 @@ void FFmpegDecoderInstance::SetWorking(bool working)
   is_working_ = working;
 }
 
-void FFmpegDecoderInstance::Seek(int64_t timestamp)
+void FFmpegDecoderInstance::WaitForCache()
+{
+  waiters_++;
+  cache_wait_cond_.wait(&cache_lock_);
+  waiters_--;
+}
+
+bool FFmpegDecoderInstance::HasWaiters() const
+{
+  return waiters_ > 0;
+}
+
+void FFmpegDecoderInstance::RequestReadAhead(const int64_t &from)
+{
+  if (read_ahead_disabled_) {
+    return;
+  }
+
+  // A read-ahead in progress will pick up the new position on its next frame
+  read_ahead_from_ = from;
+  read_ahead_interrupted_ = false;
+
+  if (!is_working_ && !read_ahead_queued_) {
+    read_ahead_queued_ = true;
+    read_ahead_pool_.start(new ReadAheadTask(this));
+  }
+}
+
+bool FFmpegDecoderInstance::IsReadingAhead() const
+{
+  return reading_ahead_;
+}
+
+void FFmpegDecoderInstance::InterruptReadAhead()
+{
+  read_ahead_interrupted_ = true;
+}
+
+void FFmpegDecoderInstance::DisableReadAhead()
+{
+  cache_lock_.lock();
+  read_ahead_disabled_ = true;
+  read_ahead_interrupted_ = true;
+  cache_lock_.unlock();
+
+  read_ahead_pool_.clear();
+  read_ahead_pool_.waitForDone();
+}
+
+void FFmpegDecoderInstance::ReadAhead()
 {
+  cache_lock_.lock();
+
+  read_ahead_queued_ = false;
+
+  if (is_working_ || read_ahead_interrupted_) {
+    // Either someone else is decoding (they'll request another read-ahead when they're done) or we've been told to
+    // stop before we've even started
+    cache_lock_.unlock();
+    return;
+  }
+
+  is_working_ = true;
+  reading_ahead_ = true;
+
+  // Only ever reads forward from whatever was last requested. Anything else would mean seeking which would just get
+  // in the way of the next real request.
+  while (!read_ahead_interrupted_
+         && !cached_frames_.isEmpty()
+         && !cache_at_eof_
+         && RangeEnd() < read_ahead_from_ + second_ts_ / kReadAheadDivider) {
+    // Decode the next frame, RetrieveFrame() unlocks the cache while it's working so we re-lock it afterwards
+    FFmpegFramePool::ElementPtr frame = RetrieveFrame(RangeEnd() + 1, true);
+
+    cache_lock_.lock();
+
+    if (!frame) {
+      // Decoding failed, leave it for the next real request to deal with
+      break;
+    }
+  }
+
+  is_working_ = false;
+  reading_ahead_ = false;
+
+  // Wake anyone waiting on us, either for a frame or for us to finish
+  cache_wait_cond_.wakeAll();
+  cache_lock_.unlock();
+}
+
+FFmpegDecoderInstance::ReadAheadTask::ReadAheadTask(FFmpegDecoderInstance *parent) :
+  parent_(parent)
+{
+}
+
+void FFmpegDecoderInstance::ReadAheadTask::run()
+{
+  parent_->ReadAhead();
+}
+
+void FFmpegDecoderInstance::Seek(int64_t timestamp, int64_t position)
+{
+  if (statistics_) {
+    statistics_->seeks.fetchAndAddRelaxed(1);
+  }
+
   avcodec_flush_buffers(codec_ctx_);
+
+  if (position >= 0
+      && (fmt_ctx_->iformat->flags & AVFMT_TS_DISCONT)
+      && !(fmt_ctx_->iformat->flags & AVFMT_NO_BYTE_SEEK)
+      && av_seek_frame(fmt_ctx_, avstream_->index, position, AVSEEK_FLAG_BYTE) >= 0) {
+    return;
+  }
+
   av_seek_frame(fmt_ctx_, avstream_->index, timestamp, AVSEEK_FLAG_BACKWARD);
 }
 
@@ -908,12 +1591,15 @@ void FFmpegDecoder::CacheFrameToDisk(AVFrame *f)
 
 void FFmpegDecoderInstance::ClearFrameCache()
 {
-  cached_frames_.clear();
+  while (!cached_frames_.isEmpty()) {
+    RemoveFirstFrame();
+  }
+
   cache_at_eof_ = false;
   cache_at_zero_ = false;
 }
 
-FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t& target_ts, bool cache_is_locked)
+FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t& target_ts, bool cache_is_locked, FrameIndexPtr index)
 {
   if (!cache_is_locked) {
     cache_lock_.lock();
@@ -924,18 +1610,43 @@ FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t&
 
   cache_target_time_ = target_ts;
 
+  // Find the keyframe this frame needs if the index has got this far
+  int keyframe = -1;
+
+  if (index && !index->isEmpty() && (index->is_complete() || target_ts <= index->last_timestamp())) {
+    keyframe = index->FindKeyframe(index->FindFrame(target_ts));
+  }
+
+  // Decoding forward is always cheaper than seeking if we've already decoded past the keyframe
+  bool decode_forward = CacheCouldContainTime(target_ts)
+      || (keyframe >= 0
+          && !cached_frames_.isEmpty()
+          && target_ts > RangeEnd()
+          && index->timestamp(keyframe) <= RangeEnd());
+
   // If the frame wasn't in the frame cache, see if this frame cache is too old to use
-  if (!CacheCouldContainTime(target_ts)) {
+  if (!decode_forward) {
     ClearFrameCache();
 
-    Seek(seek_ts);
-    if (seek_ts == 0) {
+    if (keyframe >= 0) {
+      // Seek straight to the keyframe rather than guessing
+      seek_ts = index->timestamp(keyframe);
+      Seek(seek_ts, index->position(keyframe));
+    } else {
+      Seek(seek_ts);
+    }
+
+    if (seek_ts == 0 || keyframe == 0) {
       cache_at_zero_ = true;
     }
 
     still_seeking = true;
   }
 
+  // The codec is only used by whoever has set this instance to working, so the cache doesn't need to stay locked
+  // while we decode. This lets other threads take frames from the cache in the meantime.
+  cache_lock_.unlock();
+
   int ret;
   AVPacket* pkt = av_packet_alloc();
   FFmpegFramePool::ElementPtr return_frame = nullptr;
@@ -950,7 +1661,6 @@ FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t&
 
     // Handle any errors that aren't EOF (EOF is handled later on)
     if (ret < 0 && ret != AVERROR_EOF) {
-      cache_lock_.unlock();
       qCritical() << "Failed to retrieve frame:" << ret;
       break;
     }
@@ -963,7 +1673,9 @@ FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t&
         seek_ts = qMax(static_cast<int64_t>(0), seek_ts - second_ts_);
         Seek(seek_ts);
         if (seek_ts == 0) {
+          cache_lock_.lock();
           cache_at_zero_ = true;
+          cache_lock_.unlock();
         }
         continue;
 
@@ -974,27 +1686,26 @@ FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t&
       }
     }
 
-    if (cache_is_locked) {
-      cache_is_locked = false;
-    } else {
-      cache_lock_.lock();
-    }
+    cache_lock_.lock();
 
     if (ret == AVERROR_EOF) {
 
       // Handle an "expected" EOF by using the last frame of our cache
       cache_at_eof_ = true;
 
+      if (!cached_frames_.isEmpty()) {
+        return_frame = cached_frames_.last();
+      }
+
       cache_wait_cond_.wakeAll();
       cache_lock_.unlock();
-
-      return_frame = cached_frames_.last();
       break;
 
     } else {
 
       // Whatever it is, keep this frame in memory for the time being just in case
       if (!frame_pool_) {
+        cache_lock_.unlock();
         qCritical() << "Cannot retrieve video without a valid frame pool";
         break;
       }
@@ -1002,10 +1713,15 @@ FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t&
       FFmpegFramePool::ElementPtr cached = frame_pool_->Get(working_frame.frame());
 
       if (!cached) {
+        cache_lock_.unlock();
         qCritical() << "Frame pool failed to return a valid frame - out of memory?";
         break;
       }
 
+      if (statistics_) {
+        statistics_->decoded_frames.fetchAndAddRelaxed(1);
+      }
+
       // Set timestamp so this frame can be identified later
       cached->set_timestamp(working_frame.frame()->pts);
 
@@ -1052,6 +1768,14 @@ void FFmpegDecoder::ClearResources()
 {
   FreeScaler();
 
+  delete audio_streamer_;
+  audio_streamer_ = nullptr;
+
+  delete conformed_input_;
+  conformed_input_ = nullptr;
+
+  frame_pool_ = nullptr;
+
   open_ = false;
 }
 
@@ -1072,6 +1796,12 @@ void FFmpegDecoder::InitScaler(int divider)
 
   if (scale_ctx_) {
     scale_divider_ = divider;
+
+    // Scaled frames are handed out to the renderer, so they're pooled rather than allocated every time
+    scaled_pool_ = std::make_shared<FFmpegFramePool>(kScaledFramePoolSize,
+                                                     vs->width() / divider,
+                                                     vs->height() / divider,
+                                                     ideal_pix_fmt_);
   } else {
     scale_divider_ = 0;
   }
@@ -1083,6 +1813,9 @@ void FFmpegDecoder::FreeScaler()
     sws_freeContext(scale_ctx_);
     scale_ctx_ = nullptr;
 
+    // Frames already handed out keep the pool alive until they're released
+    scaled_pool_ = nullptr;
+
     scale_divider_ = 0;
   }
 }
@@ -1165,7 +1898,7 @@ void FFmpegDecoderInstance::RemoveFramesBefore(const qint64 &t)
 {
   // We keep one frame in memory as an identifier for what pts the decoder is up to
   while (cached_frames_.size() > 1 && cached_frames_.first()->last_accessed() < t) {
-    cached_frames_.removeFirst();
+    RemoveFirstFrame();
     cache_at_zero_ = false;
   }
 }
@@ -1174,11 +1907,58 @@ void FFmpegDecoderInstance::TruncateCacheRangeTo(const qint64 &t)
 {
   // We keep one frame in memory as an identifier for what pts the decoder is up to
   while (cached_frames_.size() > 1 && (RangeEnd() - RangeStart()) > t) {
-    cached_frames_.removeFirst();
+    RemoveFirstFrame();
     cache_at_zero_ = false;
   }
 }
 
+int64_t FFmpegDecoderInstance::CostToReach(const int64_t &target, const FrameIndexPtr &index, bool *seeks) const
+{
+  int64_t keyframe_ts = AV_NOPTS_VALUE;
+
+  if (index && !index->isEmpty() && (index->is_complete() || target <= index->last_timestamp())) {
+    int keyframe = index->FindKeyframe(index->FindFrame(target));
+
+    if (keyframe >= 0) {
+      keyframe_ts = index->timestamp(keyframe);
+    }
+  }
+
+  // Same logic as RetrieveFrame(), decoding forward is cheaper than seeking if we're already past the keyframe
+  if (!cached_frames_.isEmpty()
+      && target > RangeEnd()
+      && (CacheCouldContainTime(target) || (keyframe_ts != AV_NOPTS_VALUE && keyframe_ts <= RangeEnd()))) {
+    *seeks = false;
+    return target - RangeEnd();
+  }
+
+  *seeks = true;
+
+  // Without an index, assume the keyframe is about a second back. Either way, add a little for the seek itself.
+  int64_t decode_from = (keyframe_ts != AV_NOPTS_VALUE) ? keyframe_ts : target - second_ts_;
+
+  return (target - decode_from) + second_ts_ / 4;
+}
+
+const int64_t &FFmpegDecoderInstance::last_used() const
+{
+  return last_used_;
+}
+
+void FFmpegDecoderInstance::MarkUsed()
+{
+  last_used_ = FFmpegFramePool::AccessClock();
+}
+
+void FFmpegDecoderInstance::RemoveFirstFrame()
+{
+  if (statistics_ && !cached_frames_.first()->has_been_accessed()) {
+    statistics_->wasted_frames.fetchAndAddRelaxed(1);
+  }
+
+  cached_frames_.removeFirst();
+}
+
 rational FFmpegDecoderInstance::sample_aspect_ratio() const
 {
   return av_guess_sample_aspect_ratio(fmt_ctx_, avstream_, nullptr);
@@ -1193,10 +1973,21 @@ FFmpegDecoderInstance::FFmpegDecoderInstance(const char *filename, int stream_in
   fmt_ctx_(nullptr),
   opts_(nullptr),
   frame_pool_(nullptr),
+  statistics_(nullptr),
   is_working_(false),
+  waiters_(0),
+  read_ahead_from_(0),
+  read_ahead_queued_(false),
+  reading_ahead_(false),
+  read_ahead_interrupted_(false),
+  read_ahead_disabled_(false),
   cache_at_zero_(false),
-  cache_at_eof_(false)
+  cache_at_eof_(false),
+  last_used_(FFmpegFramePool::AccessClock())
 {
+  // Frames need to be decoded in order so one thread is all we can use
+  read_ahead_pool_.setMaxThreadCount(1);
+
   // Open file in a format context
   int error_code = avformat_open_input(&fmt_ctx_, filename, nullptr, nullptr);
 
@@ -1248,8 +2039,13 @@ FFmpegDecoderInstance::FFmpegDecoderInstance(const char *filename, int stream_in
     return;
   }
 
-  // Set multithreading setting
-  error_code = av_dict_set(&opts_, "threads", "auto", 0);
+  // Set multithreading setting, a configured thread count of 0 lets FFmpeg choose
+  int thread_count = Config::Current()["DecoderThreads"].toInt();
+  QByteArray thread_count_str = (thread_count > 0) ? QByteArray::number(thread_count) : QByteArray("auto");
+  error_code = av_dict_set(&opts_, "threads", thread_count_str.constData(), 0);
+
+  // Allow whichever of frame and slice threading the codec supports
+  codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
   // Handle failure to set multithreaded decoding
   if (error_code < 0) {
@@ -1279,6 +2075,8 @@ FFmpegDecoderInstance::FFmpegDecoderInstance(const char *filename, int stream_in
 
 FFmpegDecoderInstance::~FFmpegDecoderInstance()
 {
+  DisableReadAhead();
+
   ClearResources();
 }
 
@@ -1292,13 +2090,33 @@ void FFmpegDecoderInstance::SetFramePool(FFmpegFramePool *frame_pool)
   frame_pool_ = frame_pool;
 }
 
+void FFmpegDecoderInstance::SetStatistics(FFmpegDecoderStatistics *statistics)
+{
+  statistics_ = statistics;
+}
+
+void FFmpegDecoderInstance::Detach()
+{
+  DisableReadAhead();
+
+  cache_lock_.lock();
+  ClearFrameCache();
+  frame_pool_ = nullptr;
+  statistics_ = nullptr;
+  cache_lock_.unlock();
+}
+
 void FFmpegDecoderInstance::ClearResources()
 {
   ClearFrameCache();
 
   // Stop timer
   if (clear_timer_.isActive()) {
-    QMetaObject::invokeMethod(&clear_timer_, "stop", Qt::BlockingQueuedConnection);
+    if (QThread::currentThread() == clear_timer_.thread()) {
+      clear_timer_.stop();
+    } else {
+      QMetaObject::invokeMethod(&clear_timer_, "stop", Qt::BlockingQueuedConnection);
+    }
   }
 
   if (opts_) {
@@ -1320,7 +2138,7 @@ void FFmpegDecoderInstance::ClearResources()
 void FFmpegDecoderInstance::ClearTimerEvent()
 {
   cache_lock()->lock();
-  RemoveFramesBefore(QDateTime::currentMSecsSinceEpoch() - kMaxFrameLife);
+  RemoveFramesBefore(FFmpegFramePool::AccessClock() - kMaxFrameLife);
   cache_lock()->unlock();
 }
 
@@ -28,6 +28,7 @@ extern "C" {
 }
 
 #include <QAtomicInt>
+#include <QThreadPool>
 #include <QTimer>
 #include <QVector>
 #include <QWaitCondition>
@@ -35,12 +36,35 @@ extern "C" {
 #include "audio/sampleformat.h"
 #include "avframeptr.h"
 #include "codec/decoder.h"
+#include "codec/waveinput.h"
 #include "codec/waveoutput.h"
 #include "ffmpegframepool.h"
 #include "project/item/footage/videostream.h"
 
 OLIVE_NAMESPACE_ENTER
 
+class FFmpegAudioStreamer;
+
+/**
+ * @brief Counters shared by every decoder instance of a stream, used to measure how well instances are scheduled
+ */
+struct FFmpegDecoderStatistics {
+  /**
+   * @brief Number of times any instance has had to seek
+   */
+  QAtomicInteger<qint64> seeks;
+
+  /**
+   * @brief Number of frames decoded into a cache
+   */
+  QAtomicInteger<qint64> decoded_frames;
+
+  /**
+   * @brief Number of decoded frames that were removed from a cache without ever being retrieved
+   */
+  QAtomicInteger<qint64> wasted_frames;
+};
+
 class FFmpegDecoderInstance : public QObject {
   Q_OBJECT
 public:
@@ -53,6 +77,8 @@ public:
 
   void SetFramePool(FFmpegFramePool* frame_pool);
 
+  void SetStatistics(FFmpegDecoderStatistics* statistics);
+
   int64_t RangeStart() const;
   int64_t RangeEnd() const;
   bool CacheContainsTime(const int64_t& t) const;
@@ -61,6 +87,22 @@ public:
   bool CacheIsEmpty() const;
   FFmpegFramePool::ElementPtr GetFrameFromCache(const int64_t& t) const;
 
+  /**
+   * @brief Estimate how far this instance would have to decode to reach `target`, in the stream's timebase
+   *
+   * Decoding forward from the end of the cache costs the distance to the target. If the target is in another GOP (or
+   * behind the cache), the cost is a seek plus decoding from the target's keyframe, and `seeks` is set to true.
+   *
+   * Assumes the cache lock is held by the caller.
+   */
+  int64_t CostToReach(const int64_t& target, const FrameIndexPtr& index, bool* seeks) const;
+
+  /**
+   * @brief The AccessClock() time this instance was last chosen to serve a frame
+   */
+  const int64_t& last_used() const;
+  void MarkUsed();
+
   void RemoveFramesBefore(const qint64& t);
   void TruncateCacheRangeTo(const qint64& t);
 
@@ -69,7 +111,13 @@ public:
 
   void ClearFrameCache();
 
-  FFmpegFramePool::ElementPtr RetrieveFrame(const int64_t &target_ts, bool cache_is_locked);
+  /**
+   * @brief Decode the frame at `target_ts`, seeking first if it can't be reached by decoding forward
+   *
+   * If `index` covers this time, it's used to seek straight to the frame's keyframe and to decode forward rather
+   * than seek whenever the target is in the same GOP as what's already been decoded.
+   */
+  FFmpegFramePool::ElementPtr RetrieveFrame(const int64_t &target_ts, bool cache_is_locked, FrameIndexPtr index = nullptr);
 
   /**
    * @brief Uses the FFmpeg API to retrieve a packet (stored in pkt_) and decode it (stored in frame_)
@@ -80,16 +128,93 @@ public:
    */
   int GetFrame(AVPacket* pkt, AVFrame* frame);
 
+  /**
+   * @brief Read the next packet belonging to this instance's stream without decoding it
+   *
+   * @return
+   *
+   * An FFmpeg error code, or >= 0 on success
+   */
+  int GetPacket(AVPacket* pkt);
+
+  /**
+   * @brief Seek to the last keyframe at or before `timestamp` and flush the decoder
+   *
+   * If the keyframe's byte `position` is known, formats whose timestamps can't be relied on for seeking (e.g. MPEG-TS)
+   * seek to that instead.
+   */
+  void Seek(int64_t timestamp, int64_t position = -1);
+
   QMutex* cache_lock();
   QWaitCondition* cache_wait_cond();
 
   bool IsWorking() const;
   void SetWorking(bool working);
 
+  /**
+   * @brief Wait on cache_wait_cond() as a thread that still needs this instance
+   *
+   * Instances with waiters are never destroyed, so the caller can keep using this instance once woken.
+   */
+  void WaitForCache();
+
+  /**
+   * @brief Returns true if any thread is waiting in WaitForCache()
+   */
+  bool HasWaiters() const;
+
+  /**
+   * @brief Continue decoding past `from` in the background so later requests are served from the cache
+   *
+   * Assumes the cache lock is held by the caller. Does nothing if read-ahead has been disabled.
+   */
+  void RequestReadAhead(const int64_t& from);
+
+  /**
+   * @brief Returns true if this instance is only working because it's reading ahead
+   */
+  bool IsReadingAhead() const;
+
+  /**
+   * @brief Ask the read-ahead to stop after the frame it's currently decoding
+   *
+   * Assumes the cache lock is held by the caller.
+   */
+  void InterruptReadAhead();
+
+  /**
+   * @brief Stop reading ahead permanently and wait for any read-ahead in progress to finish
+   *
+   * The cache lock must NOT be held by the caller.
+   */
+  void DisableReadAhead();
+
+  /**
+   * @brief Stop decoding and let go of the frame pool and statistics
+   *
+   * Used before handing an instance to another thread for destruction so it no longer depends on anything owned by
+   * the decoder. The cache lock must NOT be held by the caller.
+   */
+  void Detach();
+
 private:
   void ClearResources();
 
-  void Seek(int64_t timestamp);
+  void ReadAhead();
+
+  void RemoveFirstFrame();
+
+  class ReadAheadTask : public QRunnable
+  {
+  public:
+    ReadAheadTask(FFmpegDecoderInstance* parent);
+
+    virtual void run() override;
+
+  private:
+    FFmpegDecoderInstance* parent_;
+
+  };
 
   AVFormatContext* fmt_ctx_;
   AVCodecContext* codec_ctx_;
@@ -102,14 +227,25 @@ private:
   QMutex cache_lock_;
   QList<FFmpegFramePool::ElementPtr> cached_frames_;
   FFmpegFramePool* frame_pool_;
+  FFmpegDecoderStatistics* statistics_;
 
   int64_t cache_target_time_;
 
   bool is_working_;
+  int waiters_;
+
+  QThreadPool read_ahead_pool_;
+  int64_t read_ahead_from_;
+  bool read_ahead_queued_;
+  bool reading_ahead_;
+  bool read_ahead_interrupted_;
+  bool read_ahead_disabled_;
 
   bool cache_at_zero_;
   bool cache_at_eof_;
 
+  int64_t last_used_;
+
   QTimer clear_timer_;
   static const int kMaxFrameLife;
 
@@ -135,7 +271,7 @@ public:
 
   virtual bool Open() override;
   virtual RetrieveState GetRetrieveState(const rational &time) override;
-  virtual FramePtr RetrieveVideo(const rational &timecode, const int& divider) override;
+  virtual FramePtr RetrieveVideo(const rational &timecode, const int& divider, bool allow_yuv = false) override;
   virtual SampleBufferPtr RetrieveAudio(const rational &timecode, const rational &length, const AudioRenderingParams& params) override;
   virtual void Close() override;
 
@@ -146,6 +282,17 @@ public:
 
   virtual void Index(const QAtomicInt *cancelled) override;
 
+  virtual bool CanStreamAudio() override;
+
+  /**
+   * @brief Retrieve the decoding counters of every instance that has decoded this stream since it was first opened
+   *
+   * @return
+   *
+   * False if no decoder has this stream open.
+   */
+  static bool GetStatistics(Stream* stream, qint64* seeks, qint64* decoded_frames, qint64* wasted_frames);
+
 private:
   /**
    * @brief Handle an error
@@ -170,23 +317,87 @@ private:
 
   void UnconditionalAudioIndex(const QAtomicInt* cancelled);
 
+  /**
+   * @brief Returns the filename of the packet positions used to seek when streaming audio
+   */
+  QString GetSeekIndexFilename();
+
+  /**
+   * @brief Scan the audio stream's packets (without decoding them) and save their positions for seeking
+   *
+   * The file is a list of timestamp/byte position pairs (as qint64) roughly a second apart. Creating it is only bound
+   * by reading the file so it's much faster than UnconditionalAudioIndex().
+   */
+  void AudioSeekIndex(const QAtomicInt* cancelled);
+
+  /**
+   * @brief Scan the video stream's packets (without decoding them) to build its FrameIndex
+   *
+   * The index is published to the VideoStream periodically while scanning so retrieval can make use of it before the
+   * whole file has been read, and saved once complete so it only has to be built once.
+   */
+  void VideoFrameIndex(const QAtomicInt* cancelled);
+
   void ClearResources();
 
+  /**
+   * @brief Open a new instance of this decoder's stream with the stream's shared frame pool and statistics
+   *
+   * Returns nullptr if the file couldn't be opened. Must be called without instance_map_lock_ held.
+   */
+  FFmpegDecoderInstance* CreateInstance();
+
+  /**
+   * @brief Destroy instances that have been removed from instance_map_
+   *
+   * Instances own a timer that lives on the main thread and can only be stopped there, so if this isn't the main
+   * thread they're detached here and deleted on the main thread later.
+   */
+  static void DestroyInstances(const QList<FFmpegDecoderInstance*>& instances);
+
   void InitScaler(int divider);
   void FreeScaler();
 
+  /**
+   * @brief Keeps a pool element (and the pool it came from) alive for as long as a Frame uses its memory
+   */
+  struct PooledFrameBuffer {
+    std::shared_ptr<FFmpegFramePool> pool;
+    FFmpegFramePool::ElementPtr element;
+  };
+
   SwsContext* scale_ctx_;
   int scale_divider_;
+  std::shared_ptr<FFmpegFramePool> scaled_pool_;
   AVPixelFormat src_pix_fmt_;
   AVPixelFormat ideal_pix_fmt_;
   PixelFormat::Format native_pix_fmt_;
 
+  /**
+   * @brief Whether src_pix_fmt_ is planar 8-bit Y'CbCr that can be handed out as-is when RetrieveVideo() allows it
+   */
+  bool src_is_yuv_;
+  Frame::YUVLayout yuv_layout_;
+
   rational time_base_;
   rational aspect_ratio_;
   int64_t start_time_;
 
+  FFmpegAudioStreamer* audio_streamer_;
+
+  WaveInput* conformed_input_;
+
+  std::shared_ptr<FFmpegFramePool> frame_pool_;
+
+  /**
+   * @brief How many instances of this stream fit in the decoder memory budget
+   */
+  int max_instances_;
+
   static QHash< Stream*, QList<FFmpegDecoderInstance*> > instance_map_;
-  static QHash< Stream*, FFmpegFramePool* > frame_pool_map_;
+  static QHash< Stream*, std::shared_ptr<FFmpegFramePool> > frame_pool_map_;
+  static QHash< Stream*, FFmpegDecoderStatistics* > statistics_map_;
+  static QHash< Stream*, int > decoder_count_map_;
   static QMutex instance_map_lock_;
 
 };
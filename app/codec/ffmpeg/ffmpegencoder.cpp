@@ -21,26 +21,49 @@
 #include "ffmpegencoder.h"
 
 #include <QFile>
+#include <QThread>
 
 #include "ffmpegcommon.h"
 #include "render/pixelformat.h"
 
 OLIVE_NAMESPACE_ENTER
 
+// Encoded packets are small, this is only here so a stalled disk can't let them pile up indefinitely
+const int kMaxQueuedPackets = 64;
+
 FFmpegEncoder::FFmpegEncoder(const EncodingParams &params) :
   Encoder(params),
   fmt_ctx_(nullptr),
   video_stream_(nullptr),
   video_codec_ctx_(nullptr),
-  video_scale_ctx_(nullptr),
   audio_stream_(nullptr),
   audio_codec_ctx_(nullptr),
-  audio_resample_ctx_(nullptr)
+  audio_resample_ctx_(nullptr),
+  mux_queue_space_(kMaxQueuedPackets),
+  closing_(false)
+{
+  // Codecs run their own threads, so leave them half the cores for encoding
+  convert_pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+
+  // Codecs and muxers need their input in order, so these stages get one thread each
+  encode_pool_.setMaxThreadCount(1);
+  mux_pool_.setMaxThreadCount(1);
+}
+
+FFmpegEncoder::~FFmpegEncoder()
 {
+  // Tasks reference this object so they must finish before any of it is destroyed
+  WaitForPipeline();
 }
 
 void FFmpegEncoder::WriteAudio(AudioRenderingParams pcm_info, const QString &pcm_filename, TimeRange range)
 {
+  // Don't start on the audio if a video frame has already failed, CheckPipeline() closes the encoder in that case
+  if (!IsOpen() || !CheckPipeline()) {
+    emit AudioComplete();
+    return;
+  }
+
   QFile pcm(pcm_filename);
   if (pcm.open(QFile::ReadOnly)) {
     // Divide PCM stream into AVFrames
@@ -132,9 +155,9 @@ void FFmpegEncoder::WriteAudio(AudioRenderingParams pcm_info, const QString &pcm
       // Increment timestamp for the next frame by the amount of samples in this one
       sample_counter += converted;
 
-      // Write the frame
-      if (!WriteAVFrame(frame, audio_codec_ctx_, audio_stream_)) {
-        qCritical() << "Failed to write audio AVFrame";
+      // Write the frame, stopping if this or the muxer fails
+      if (!WriteAVFrame(frame, audio_codec_ctx_, audio_stream_)
+          || pipeline_failed_.loadAcquire()) {
         break;
       }
 
@@ -149,6 +172,8 @@ void FFmpegEncoder::WriteAudio(AudioRenderingParams pcm_info, const QString &pcm
     swr_free(&swr_ctx);
 
     pcm.close();
+
+    CheckPipeline();
   }
 
   emit AudioComplete();
@@ -158,6 +183,9 @@ bool FFmpegEncoder::OpenInternal()
 {
   int error_code;
 
+  pipeline_failed_.storeRelease(0);
+  pipeline_error_.clear();
+
   // Convert QString to C string that FFmpeg expects
   QByteArray filename_bytes = params().filename().toUtf8();
   const char* filename_c_str = filename_bytes.constData();
@@ -180,27 +208,9 @@ bool FFmpegEncoder::OpenInternal()
     // This is the format we will expect frames received in Write() to be in
     PixelFormat::Format native_pixel_fmt = params().video_params().format();
 
-    // This is the format we will need to convert the frame to for swscale to understand it
+    // This is the format we will need to convert the frame to for swscale to understand it. Scaling contexts are
+    // created as the conversion threads need them.
     video_conversion_fmt_ = FFmpegCommon::GetCompatiblePixelFormat(native_pixel_fmt);
-
-    // This is the equivalent pixel format above as an AVPixelFormat that swscale can understand
-    AVPixelFormat src_pix_fmt = FFmpegCommon::GetFFmpegPixelFormat(video_conversion_fmt_);
-
-    // This is the pixel format the encoder wants to encode to
-    AVPixelFormat encoder_pix_fmt = video_codec_ctx_->pix_fmt;
-
-    // Set up a scaling context - if the native pixel format is not equal to the encoder's, we'll need to convert it
-    // before encoding. Even if we don't, this may be useful for converting between linesizes, etc.
-    video_scale_ctx_ = sws_getContext(params().video_params().width(),
-                                      params().video_params().height(),
-                                      src_pix_fmt,
-                                      params().video_params().width(),
-                                      params().video_params().height(),
-                                      encoder_pix_fmt,
-                                      0,
-                                      nullptr,
-                                      nullptr,
-                                      nullptr);
   }
 
   // Initialize an audio stream if it's enabled
@@ -230,66 +240,50 @@ bool FFmpegEncoder::OpenInternal()
 
 void FFmpegEncoder::WriteInternal(FramePtr frame)
 {
-  AVFrame* encoded_frame = av_frame_alloc();
-
-  int error_code;
-  const char* input_data;
-  int input_linesize;
-
-  // Frame must be video
-  encoded_frame->width = frame->width();
-  encoded_frame->height = frame->height();
-  encoded_frame->format = video_codec_ctx_->pix_fmt;
-
-  error_code = av_frame_get_buffer(encoded_frame, 0);
-  if (error_code < 0) {
-    FFmpegError("Failed to create AVFrame buffer", error_code);
-    goto fail;
+  // Stop queueing work once something has failed, CheckPipeline() closes the encoder in that case
+  if (!CheckPipeline()) {
+    emit FrameWritten();
+    return;
   }
 
-  // We may need to convert this frame to a frame that swscale will understand
-  if (frame->format() != video_conversion_fmt_) {
-    frame = PixelFormat::ConvertPixelFormat(frame, video_conversion_fmt_);
-  }
-
-  // Use swscale context to convert formats/linesizes
-  input_data = frame->const_data();
-  input_linesize = frame->width() * PixelFormat::BytesPerPixel(video_conversion_fmt_);
-  error_code = sws_scale(video_scale_ctx_,
-                         reinterpret_cast<const uint8_t**>(&input_data),
-                         &input_linesize,
-                         0,
-                         frame->height(),
-                         encoded_frame->data,
-                         encoded_frame->linesize);
-  if (error_code < 0) {
-    FFmpegError("Failed to scale frame", error_code);
-    goto fail;
-  }
+  PendingFrame* pending = new PendingFrame();
+  pending->source = frame;
+  pending->converted = nullptr;
 
-  encoded_frame->pts = qRound(frame->timestamp().toDouble() / av_q2d(video_codec_ctx_->time_base));
-
-  WriteAVFrame(encoded_frame, video_codec_ctx_, video_stream_);
-
-fail:
-  av_frame_free(&encoded_frame);
+  // Frames are converted in parallel while the encode thread consumes them in the order they were received. The
+  // Exporter limits how many frames it sends us before FrameWritten(), which keeps this queue bounded.
+  convert_pool_.start(new ConvertTask(this, pending));
+  encode_pool_.start(new EncodeTask(this, pending));
 }
 
 void FFmpegEncoder::CloseInternal()
 {
   if (IsOpen()) {
+    closing_ = true;
+
+    // Finish encoding every frame we've received
+    WaitForPipeline();
+
+    // Report anything that failed on the pipeline threads, the file is still finalized below
+    CheckPipeline();
+
     // Flush encoders
     FlushEncoders();
 
+    // Flushing queues more packets, these must be in the file before the trailer is
+    mux_pool_.waitForDone();
+
     // We've written a header, so we'll write a trailer
     av_write_trailer(fmt_ctx_);
     avio_closep(&fmt_ctx_->pb);
+
+    closing_ = false;
   }
 
-  if (video_scale_ctx_) {
-    sws_freeContext(video_scale_ctx_);
-    video_scale_ctx_ = nullptr;
+  foreach (SwsContext* ctx, video_scale_ctxs_) {
+    sws_freeContext(ctx);
   }
+  video_scale_ctxs_.clear();
 
   if (video_codec_ctx_) {
     avcodec_free_context(&video_codec_ctx_);
@@ -309,22 +303,61 @@ void FFmpegEncoder::CloseInternal()
 }
 
 void FFmpegEncoder::FFmpegError(const char* context, int error_code)
+{
+  Error(FFmpegErrorString(context, error_code));
+}
+
+QString FFmpegEncoder::FFmpegErrorString(const char *context, int error_code) const
 {
   char err[128];
   av_strerror(error_code, err, 128);
 
-  Error(QStringLiteral("%1 for %2 - %3 %4").arg(context,
-                                                params().filename(),
-                                                QString::number(error_code),
-                                                err));
+  return QStringLiteral("%1 for %2 - %3 %4").arg(context,
+                                                 params().filename(),
+                                                 QString::number(error_code),
+                                                 err);
+}
+
+void FFmpegEncoder::PipelineError(const QString &s)
+{
+  QMutexLocker locker(&pipeline_error_lock_);
+
+  // Later errors are usually a consequence of the first, so that's the one worth reporting
+  if (!pipeline_failed_.loadAcquire()) {
+    pipeline_error_ = s;
+    pipeline_failed_.storeRelease(1);
+  }
+}
+
+bool FFmpegEncoder::CheckPipeline()
+{
+  if (!pipeline_failed_.loadAcquire()) {
+    return true;
+  }
+
+  QString s;
+
+  {
+    // The flag stays set so the rest of the pipeline keeps dropping its work, but the error is only reported once
+    QMutexLocker locker(&pipeline_error_lock_);
+    s = pipeline_error_;
+    pipeline_error_.clear();
+  }
+
+  if (!s.isEmpty()) {
+    Error(s);
+  }
+
+  return false;
 }
 
 bool FFmpegEncoder::WriteAVFrame(AVFrame *frame, AVCodecContext* codec_ctx, AVStream* stream)
 {
   // Send raw frame to the encoder
+  // NOTE: This may be called from the encode thread so errors are recorded for CheckPipeline() to report
   int error_code = avcodec_send_frame(codec_ctx, frame);
   if (error_code < 0) {
-    FFmpegError("Failed to send frame to encoder", error_code);
+    PipelineError(FFmpegErrorString("Failed to send frame to encoder", error_code));
     return false;
   }
 
@@ -340,7 +373,7 @@ bool FFmpegEncoder::WriteAVFrame(AVFrame *frame, AVCodecContext* codec_ctx, AVSt
     if (error_code == AVERROR(EAGAIN)) {
       break;
     } else if (error_code < 0) {
-      FFmpegError("Failed to receive packet from decoder", error_code);
+      PipelineError(FFmpegErrorString("Failed to receive packet from encoder", error_code));
       goto fail;
     }
 
@@ -349,11 +382,8 @@ bool FFmpegEncoder::WriteAVFrame(AVFrame *frame, AVCodecContext* codec_ctx, AVSt
 
     av_packet_rescale_ts(pkt, codec_ctx->time_base, stream->time_base);
 
-    // Write packet to file
-    av_interleaved_write_frame(fmt_ctx_, pkt);
-
-    // Unref packet in case we're getting another
-    av_packet_unref(pkt);
+    // Write packet to file, this also leaves `pkt` blank in case we're getting another
+    QueuePacket(pkt);
   }
 
   succeeded = true;
@@ -470,6 +500,9 @@ bool FFmpegEncoder::SetupCodecContext(AVStream* stream, AVCodecContext* codec_ct
   AVDictionary* codec_opts = nullptr;
   av_dict_set(&codec_opts, "threads", "auto", 0);
 
+  // Let the codec use whichever kinds of threading it supports, frame threading is usually the bigger win
+  codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
   // Try to open encoder
   error_code = avcodec_open2(codec_ctx, codec, &codec_opts);
   if (error_code < 0) {
@@ -513,8 +546,7 @@ void FFmpegEncoder::FlushCodecCtx(AVCodecContext *codec_ctx, AVStream* stream)
 
     pkt->stream_index = stream->index;
     av_packet_rescale_ts(pkt, codec_ctx->time_base, stream->time_base);
-    av_interleaved_write_frame(fmt_ctx_, pkt);
-    av_packet_unref(pkt);
+    QueuePacket(pkt);
   } while (error_code >= 0);
 
   av_packet_free(&pkt);
@@ -524,7 +556,178 @@ void FFmpegEncoder::Error(const QString &s)
 {
   qWarning() << s;
 
-  Close();
+  // CloseInternal() reports pipeline errors while it's already closing
+  if (!closing_) {
+    Close();
+  }
+}
+
+void FFmpegEncoder::QueuePacket(AVPacket *pkt)
+{
+  AVPacket* queued = av_packet_alloc();
+  av_packet_move_ref(queued, pkt);
+
+  // Wait here if the muxer has fallen behind
+  mux_queue_space_.acquire();
+
+  mux_pool_.start(new MuxTask(this, queued));
+}
+
+AVFrame *FFmpegEncoder::ConvertFrame(FramePtr frame)
+{
+  AVFrame* encoded_frame = av_frame_alloc();
+
+  int error_code;
+  const char* input_data;
+  int input_linesize;
+  SwsContext* scale_ctx;
+
+  // Frame must be video
+  encoded_frame->width = frame->width();
+  encoded_frame->height = frame->height();
+  encoded_frame->format = video_codec_ctx_->pix_fmt;
+
+  error_code = av_frame_get_buffer(encoded_frame, 0);
+  if (error_code < 0) {
+    PipelineError(FFmpegErrorString("Failed to create AVFrame buffer", error_code));
+    goto fail;
+  }
+
+  // We may need to convert this frame to a frame that swscale will understand
+  if (frame->format() != video_conversion_fmt_) {
+    frame = PixelFormat::ConvertPixelFormat(frame, video_conversion_fmt_);
+  }
+
+  // Use swscale context to convert formats/linesizes
+  input_data = frame->const_data();
+  input_linesize = frame->width() * PixelFormat::BytesPerPixel(video_conversion_fmt_);
+
+  scale_ctx = TakeScaleContext();
+  error_code = sws_scale(scale_ctx,
+                         reinterpret_cast<const uint8_t**>(&input_data),
+                         &input_linesize,
+                         0,
+                         frame->height(),
+                         encoded_frame->data,
+                         encoded_frame->linesize);
+  ReturnScaleContext(scale_ctx);
+
+  if (error_code < 0) {
+    PipelineError(FFmpegErrorString("Failed to scale frame", error_code));
+    goto fail;
+  }
+
+  encoded_frame->pts = qRound(frame->timestamp().toDouble() / av_q2d(video_codec_ctx_->time_base));
+
+  return encoded_frame;
+
+fail:
+  av_frame_free(&encoded_frame);
+
+  return nullptr;
+}
+
+SwsContext *FFmpegEncoder::TakeScaleContext()
+{
+  {
+    QMutexLocker locker(&video_scale_lock_);
+
+    if (!video_scale_ctxs_.isEmpty()) {
+      return video_scale_ctxs_.takeLast();
+    }
+  }
+
+  // swscale contexts aren't thread-safe so every conversion thread gets its own. If the native pixel format is not
+  // equal to the encoder's, we'll need to convert it before encoding. Even if we don't, this may be useful for
+  // converting between linesizes, etc.
+  return sws_getContext(params().video_params().width(),
+                        params().video_params().height(),
+                        FFmpegCommon::GetFFmpegPixelFormat(video_conversion_fmt_),
+                        params().video_params().width(),
+                        params().video_params().height(),
+                        video_codec_ctx_->pix_fmt,
+                        0,
+                        nullptr,
+                        nullptr,
+                        nullptr);
+}
+
+void FFmpegEncoder::ReturnScaleContext(SwsContext *ctx)
+{
+  QMutexLocker locker(&video_scale_lock_);
+
+  video_scale_ctxs_.append(ctx);
+}
+
+void FFmpegEncoder::WaitForPipeline()
+{
+  // Each stage feeds the next so they must be waited on in order
+  convert_pool_.waitForDone();
+  encode_pool_.waitForDone();
+  mux_pool_.waitForDone();
+}
+
+FFmpegEncoder::ConvertTask::ConvertTask(FFmpegEncoder *parent, PendingFrame *frame) :
+  parent_(parent),
+  frame_(frame)
+{
+}
+
+void FFmpegEncoder::ConvertTask::run()
+{
+  // No point converting frames that won't be written
+  if (!parent_->pipeline_failed_.loadAcquire()) {
+    frame_->converted = parent_->ConvertFrame(frame_->source);
+  }
+
+  // Conversion is finished with the source, no need to hold onto it until this frame is encoded
+  frame_->source = nullptr;
+
+  frame_->ready.release();
+}
+
+FFmpegEncoder::EncodeTask::EncodeTask(FFmpegEncoder *parent, PendingFrame *frame) :
+  parent_(parent),
+  frame_(frame)
+{
+}
+
+void FFmpegEncoder::EncodeTask::run()
+{
+  frame_->ready.acquire();
+
+  if (frame_->converted) {
+    if (!parent_->pipeline_failed_.loadAcquire()) {
+      parent_->WriteAVFrame(frame_->converted, parent_->video_codec_ctx_, parent_->video_stream_);
+    }
+
+    av_frame_free(&frame_->converted);
+  }
+
+  delete frame_;
+
+  emit parent_->FrameWritten();
+}
+
+FFmpegEncoder::MuxTask::MuxTask(FFmpegEncoder *parent, AVPacket *pkt) :
+  parent_(parent),
+  pkt_(pkt)
+{
+}
+
+void FFmpegEncoder::MuxTask::run()
+{
+  // Packets after a failure would only produce a file that looks complete but isn't
+  if (!parent_->pipeline_failed_.loadAcquire()) {
+    int error_code = av_interleaved_write_frame(parent_->fmt_ctx_, pkt_);
+    if (error_code < 0) {
+      parent_->PipelineError(parent_->FFmpegErrorString("Failed to write packet", error_code));
+    }
+  }
+
+  av_packet_free(&pkt_);
+
+  parent_->mux_queue_space_.release();
 }
 
 OLIVE_NAMESPACE_EXIT
@@ -28,6 +28,12 @@ extern "C" {
 #include <libavutil/opt.h>
 }
 
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+
 #include "codec/encoder.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -38,6 +44,8 @@ class FFmpegEncoder : public Encoder
 public:
   FFmpegEncoder(const EncodingParams &params);
 
+  virtual ~FFmpegEncoder() override;
+
 public slots:
   virtual void WriteAudio(OLIVE_NAMESPACE::AudioRenderingParams pcm_info, const QString& pcm_filename, OLIVE_NAMESPACE::TimeRange range) override;
 
@@ -66,8 +74,47 @@ private:
    */
   void FFmpegError(const char *context, int error_code);
 
+  /**
+   * @brief Create a descriptive string for an FFmpeg error code without closing the encoder
+   *
+   * Used by the pipeline stages, which run on other threads and therefore must not call Error().
+   */
+  QString FFmpegErrorString(const char *context, int error_code) const;
+
+  /**
+   * @brief Record an error from one of the pipeline threads
+   *
+   * Thread-safe. Only the first error is kept, it's sent to Error() the next time the encoder thread calls
+   * CheckPipeline().
+   */
+  void PipelineError(const QString& s);
+
+  /**
+   * @brief Pass any error recorded by the pipeline threads to Error()
+   *
+   * Must be called from the encoder's thread. Returns false if the pipeline has failed.
+   */
+  bool CheckPipeline();
+
   bool WriteAVFrame(AVFrame* frame, AVCodecContext *codec_ctx, AVStream *stream);
 
+  /**
+   * @brief Hand an encoded packet to the muxing thread
+   *
+   * Takes ownership of the packet's data. Blocks if the muxer has fallen too far behind.
+   */
+  void QueuePacket(AVPacket* pkt);
+
+  /**
+   * @brief Convert a frame to the encoder's pixel format
+   *
+   * Thread-safe. Returns nullptr on failure.
+   */
+  AVFrame* ConvertFrame(FramePtr frame);
+
+  SwsContext* TakeScaleContext();
+  void ReturnScaleContext(SwsContext* ctx);
+
   bool InitializeStream(enum AVMediaType type, AVStream** stream, AVCodecContext** codec_ctx, const QString& codec);
   bool InitializeCodecContext(AVStream** stream, AVCodecContext** codec_ctx, AVCodec* codec);
   bool SetupCodecContext(AVStream *stream, AVCodecContext *codec_ctx, AVCodec *codec);
@@ -75,17 +122,109 @@ private:
   void FlushEncoders();
   void FlushCodecCtx(AVCodecContext* codec_ctx, AVStream *stream);
 
+  /**
+   * @brief Wait for every frame and packet in the pipeline to reach the file
+   */
+  void WaitForPipeline();
+
+  struct PendingFrame {
+    FramePtr source;
+    AVFrame* converted;
+
+    // Released once `converted` has been set
+    QSemaphore ready;
+  };
+
+  class ConvertTask : public QRunnable
+  {
+  public:
+    ConvertTask(FFmpegEncoder* parent, PendingFrame* frame);
+
+    virtual void run() override;
+
+  private:
+    FFmpegEncoder* parent_;
+
+    PendingFrame* frame_;
+
+  };
+
+  class EncodeTask : public QRunnable
+  {
+  public:
+    EncodeTask(FFmpegEncoder* parent, PendingFrame* frame);
+
+    virtual void run() override;
+
+  private:
+    FFmpegEncoder* parent_;
+
+    PendingFrame* frame_;
+
+  };
+
+  class MuxTask : public QRunnable
+  {
+  public:
+    MuxTask(FFmpegEncoder* parent, AVPacket* pkt);
+
+    virtual void run() override;
+
+  private:
+    FFmpegEncoder* parent_;
+
+    AVPacket* pkt_;
+
+  };
+
   AVFormatContext* fmt_ctx_;
 
   AVStream* video_stream_;
   AVCodecContext* video_codec_ctx_;
-  SwsContext* video_scale_ctx_;
   PixelFormat::Format video_conversion_fmt_;
 
+  /**
+   * @brief Idle swscale contexts, one is created per conversion thread as needed
+   */
+  QVector<SwsContext*> video_scale_ctxs_;
+  QMutex video_scale_lock_;
+
   AVStream* audio_stream_;
   AVCodecContext* audio_codec_ctx_;
   SwrContext* audio_resample_ctx_;
 
+  /**
+   * @brief Pixel format conversion, any number of frames at once
+   */
+  QThreadPool convert_pool_;
+
+  /**
+   * @brief Single thread that feeds frames to the video codec in the order they were received
+   */
+  QThreadPool encode_pool_;
+
+  /**
+   * @brief Single thread that writes packets to the file in the order they were encoded
+   */
+  QThreadPool mux_pool_;
+
+  /**
+   * @brief Bounds the number of packets waiting to be muxed
+   */
+  QSemaphore mux_queue_space_;
+
+  /**
+   * @brief Set once any pipeline stage has failed, later frames and packets are dropped rather than written
+   */
+  QAtomicInt pipeline_failed_;
+  QString pipeline_error_;
+  QMutex pipeline_error_lock_;
+
+  /**
+   * @brief Set while CloseInternal() runs so that errors reported during it don't close the encoder again
+   */
+  bool closing_;
+
 };
 
 OLIVE_NAMESPACE_EXIT
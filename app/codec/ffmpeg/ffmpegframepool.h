@@ -35,6 +35,8 @@ public:
                   int height,
                   AVPixelFormat format);
 
+  using MemoryPool::Get;
+
   ElementPtr Get(AVFrame* copy);
 
 protected:
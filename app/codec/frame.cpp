@@ -26,6 +26,9 @@
 OLIVE_NAMESPACE_ENTER
 
 Frame::Frame() :
+  buffer_(nullptr),
+  buffer_size_(0),
+  is_yuv_(false),
   timestamp_(0),
   sample_aspect_ratio_(1)
 {
@@ -71,7 +74,7 @@ Color Frame::get_pixel(int x, int y) const
 
   int byte_offset = PixelFormat::GetBufferSize(video_params().format(), pixel_index, 1);
 
-  return Color(data_.data() + byte_offset, video_params().format());
+  return Color(const_data() + byte_offset, video_params().format());
 }
 
 bool Frame::contains_pixel(int x, int y) const
@@ -111,16 +114,28 @@ void Frame::set_native_timestamp(const int64_t &timestamp)
 
 QByteArray Frame::ToByteArray() const
 {
+  if (buffer_owner_) {
+    return QByteArray(buffer_, buffer_size_);
+  }
+
   return data_;
 }
 
 char *Frame::data()
 {
+  if (buffer_owner_) {
+    return buffer_;
+  }
+
   return data_.data();
 }
 
 const char *Frame::const_data() const
 {
+  if (buffer_owner_) {
+    return buffer_;
+  }
+
   return data_.constData();
 }
 
@@ -132,21 +147,88 @@ void Frame::allocate()
     return;
   }
 
+  destroy();
+
   data_.resize(PixelFormat::GetBufferSize(params_.format(), params_.width(), params_.height()));
 }
 
+void Frame::set_buffer(char *data, int size, std::shared_ptr<void> owner)
+{
+  destroy();
+
+  buffer_ = data;
+  buffer_size_ = size;
+  buffer_owner_ = owner;
+}
+
+void Frame::set_yuv_layout(const Frame::YUVLayout &layout)
+{
+  is_yuv_ = true;
+  yuv_layout_ = layout;
+}
+
+bool Frame::is_yuv() const
+{
+  return is_yuv_;
+}
+
+const Frame::YUVLayout &Frame::yuv_layout() const
+{
+  return yuv_layout_;
+}
+
+int Frame::yuv_plane_width(int plane) const
+{
+  if (plane == 0) {
+    return width();
+  }
+
+  // Round up like FFmpeg does for odd sizes
+  return (width() + (1 << yuv_layout_.chroma_shift_x) - 1) >> yuv_layout_.chroma_shift_x;
+}
+
+int Frame::yuv_plane_height(int plane) const
+{
+  if (plane == 0) {
+    return height();
+  }
+
+  return (height() + (1 << yuv_layout_.chroma_shift_y) - 1) >> yuv_layout_.chroma_shift_y;
+}
+
+const char *Frame::yuv_plane(int plane) const
+{
+  const char* p = const_data();
+
+  for (int i=0; i<plane; i++) {
+    p += yuv_plane_width(i) * yuv_plane_height(i);
+  }
+
+  return p;
+}
+
 bool Frame::is_allocated() const
 {
-  return !data_.isEmpty();
+  return buffer_owner_ || !data_.isEmpty();
 }
 
 void Frame::destroy()
 {
   data_.clear();
+
+  buffer_owner_ = nullptr;
+  buffer_ = nullptr;
+  buffer_size_ = 0;
+
+  is_yuv_ = false;
 }
 
 int Frame::allocated_size() const
 {
+  if (buffer_owner_) {
+    return buffer_size_;
+  }
+
   return data_.size();
 }
 
@@ -40,6 +40,19 @@ using FramePtr = std::shared_ptr<Frame>;
 class Frame
 {
 public:
+  /**
+   * @brief Describes a buffer holding planar 8-bit Y'CbCr (Y, Cb, then Cr planes packed one after another)
+   *
+   * Chroma planes are the frame's width and height shifted right (rounding up) by `chroma_shift_x` and
+   * `chroma_shift_y`, e.g. 1 and 1 for 4:2:0 or 1 and 0 for 4:2:2.
+   */
+  struct YUVLayout {
+    int chroma_shift_x;
+    int chroma_shift_y;
+    bool rec709;
+    bool full_range;
+  };
+
   Frame();
 
   static FramePtr Create();
@@ -94,6 +107,45 @@ public:
    */
   void allocate();
 
+  /**
+   * @brief Use memory owned by something else as this frame's buffer instead of allocating one
+   *
+   * `owner` is kept alive for as long as this frame uses `data`, which lets pooled memory (e.g. a decoder's frame
+   * pool) be handed to the rest of the pipeline without copying it. `data` must be laid out exactly as allocate() would
+   * lay it out for this frame's video parameters. Since the owner may share this memory with others, the frame should
+   * be treated as read-only.
+   *
+   * Any buffer previously allocated with allocate() is destroyed.
+   */
+  void set_buffer(char* data, int size, std::shared_ptr<void> owner);
+
+  /**
+   * @brief Mark this frame's buffer as planar Y'CbCr laid out as `layout` describes rather than the packed RGB(A)
+   * format() would suggest
+   *
+   * Backends that can convert to RGB themselves (e.g. in a shader) can use this to avoid a CPU conversion. format()
+   * is then the format the frame should be converted into. Cleared by destroy().
+   */
+  void set_yuv_layout(const YUVLayout& layout);
+
+  /**
+   * @brief Returns whether this frame holds planar Y'CbCr, see set_yuv_layout()
+   */
+  bool is_yuv() const;
+
+  const YUVLayout& yuv_layout() const;
+
+  /**
+   * @brief Width and height in pixels of a Y'CbCr plane (0 = Y, 1 = Cb, 2 = Cr)
+   */
+  int yuv_plane_width(int plane) const;
+  int yuv_plane_height(int plane) const;
+
+  /**
+   * @brief Get the start of a Y'CbCr plane (0 = Y, 1 = Cb, 2 = Cr) within const_data()
+   */
+  const char* yuv_plane(int plane) const;
+
   /**
    * @brief Return whether the frame is allocated or not
    */
@@ -116,6 +168,16 @@ private:
 
   QByteArray data_;
 
+  std::shared_ptr<void> buffer_owner_;
+
+  char* buffer_;
+
+  int buffer_size_;
+
+  bool is_yuv_;
+
+  YUVLayout yuv_layout_;
+
   rational timestamp_;
 
   int64_t native_timestamp_;
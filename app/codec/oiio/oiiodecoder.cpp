@@ -165,7 +165,7 @@ Decoder::RetrieveState OIIODecoder::GetRetrieveState(const rational &time)
   return kReady;
 }
 
-FramePtr OIIODecoder::RetrieveVideo(const rational &timecode, const int& divider)
+FramePtr OIIODecoder::RetrieveVideo(const rational &timecode, const int& divider, bool /*allow_yuv*/)
 {
   QMutexLocker locker(&mutex_);
 
@@ -41,7 +41,7 @@ public:
 
   virtual bool Open() override;
   virtual RetrieveState GetRetrieveState(const rational &time) override;
-  virtual FramePtr RetrieveVideo(const rational &timecode, const int& divider) override;
+  virtual FramePtr RetrieveVideo(const rational &timecode, const int& divider, bool allow_yuv = false) override;
   virtual void Close() override;
 
   virtual bool SupportsVideo() override;
@@ -50,18 +50,23 @@ SampleBufferPtr SampleBuffer::CreateAllocated(const AudioRenderingParams &audio_
 }
 
 SampleBufferPtr SampleBuffer::CreateFromPackedData(const AudioRenderingParams &audio_params, const QByteArray &bytes)
+{
+  return CreateFromPackedData(audio_params, bytes.constData(), bytes.size());
+}
+
+SampleBufferPtr SampleBuffer::CreateFromPackedData(const AudioRenderingParams &audio_params, const char *data, int size)
 {
   if (!audio_params.is_valid()) {
     qWarning() << "Tried to create from packed data with invalid parameters";
     return nullptr;
   }
 
-  int samples_per_channel = audio_params.bytes_to_samples(bytes.size());
+  int samples_per_channel = audio_params.bytes_to_samples(size);
   SampleBufferPtr buffer = CreateAllocated(audio_params, samples_per_channel);
 
   int total_samples = samples_per_channel * audio_params.channel_count();
 
-  const float* packed_data = reinterpret_cast<const float*>(bytes.constData());
+  const float* packed_data = reinterpret_cast<const float*>(data);
 
   for (int i=0;i<total_samples;i++) {
     int channel = i % audio_params.channel_count();
@@ -166,33 +171,6 @@ void SampleBuffer::reverse()
   }
 }
 
-void SampleBuffer::speed(double speed)
-{
-  if (!is_allocated()) {
-    qWarning() << "Tried to speed an unallocated sample buffer";
-    return;
-  }
-
-  int max_adjusted_nb_samples = qRound(static_cast<double>(sample_count_per_channel_) * speed);
-
-  float** input_data = data_;
-  float** output_data;
-
-  allocate_sample_buffer(&output_data, audio_params_.channel_count(), max_adjusted_nb_samples);
-
-  for (int i=0;i<max_adjusted_nb_samples;i++) {
-    int input_index = qRound(static_cast<double>(i) * speed);
-
-    for (int j=0;j<audio_params_.channel_count();j++) {
-      output_data[j][i] = input_data[j][input_index];
-    }
-  }
-
-  destroy_sample_buffer(&input_data, audio_params_.channel_count());
-
-  data_ = output_data;
-}
-
 void SampleBuffer::fill(const float &f)
 {
   fill(f, 0, sample_count_per_channel_);
@@ -48,6 +48,7 @@ public:
   static SampleBufferPtr Create();
   static SampleBufferPtr CreateAllocated(const AudioRenderingParams& audio_params, int samples_per_channel);
   static SampleBufferPtr CreateFromPackedData(const AudioRenderingParams& audio_params, const QByteArray& bytes);
+  static SampleBufferPtr CreateFromPackedData(const AudioRenderingParams& audio_params, const char* data, int size);
 
   DISABLE_COPY_MOVE(SampleBuffer)
 
@@ -67,7 +68,6 @@ public:
   void destroy();
 
   void reverse();
-  void speed(double speed);
 
   void fill(const float& f);
   void fill(const float& f, int start_sample, int end_sample);
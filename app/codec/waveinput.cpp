@@ -27,10 +27,16 @@ extern "C" {
 #include <QDataStream>
 #include <QtMath>
 
+#include "common/filefunctions.h"
+
 OLIVE_NAMESPACE_ENTER
 
 WaveInput::WaveInput(const QString &f) :
-  file_(f)
+  file_(f),
+  data_position_(0),
+  data_size_(0),
+  mapped_data_(nullptr),
+  mapped_size_(0)
 {
 }
 
@@ -187,6 +193,58 @@ qint64 WaveInput::read(int offset, char *buffer, int length)
   return file_.read(buffer, qMin(calculate_max_read(), static_cast<qint64>(length)));
 }
 
+bool WaveInput::map()
+{
+  if (!is_open()) {
+    return false;
+  }
+
+  if (mapped_data_) {
+    return true;
+  }
+
+  // Don't map past the end of the file if the header claims more data than was written
+  mapped_size_ = qMin(static_cast<qint64>(data_size_), file_.size() - data_position_);
+
+  if (mapped_size_ <= 0) {
+    mapped_size_ = 0;
+    return false;
+  }
+
+  mapped_data_ = file_.map(data_position_, mapped_size_);
+
+  if (!mapped_data_) {
+    mapped_size_ = 0;
+    return false;
+  }
+
+  AdviseSequentialAccess(mapped_data_, mapped_size_);
+
+  return true;
+}
+
+bool WaveInput::is_mapped() const
+{
+  return mapped_data_ != nullptr;
+}
+
+const char *WaveInput::data(int offset, int *length) const
+{
+  if (!mapped_data_) {
+    return nullptr;
+  }
+
+  qint64 start = qBound(static_cast<qint64>(0), static_cast<qint64>(offset), mapped_size_);
+
+  *length = static_cast<int>(qBound(static_cast<qint64>(0), static_cast<qint64>(*length), mapped_size_ - start));
+
+  // Playback will most likely want the next range too
+  qint64 next = start + *length;
+  AdviseWillNeed(mapped_data_ + next, qMin(static_cast<qint64>(*length), mapped_size_ - next));
+
+  return reinterpret_cast<const char*>(mapped_data_ + start);
+}
+
 bool WaveInput::seek(qint64 pos)
 {
   return file_.seek(data_position_ + qMin(pos, static_cast<qint64>(data_size_)));
@@ -204,6 +262,12 @@ const AudioRenderingParams &WaveInput::params() const
 
 void WaveInput::close()
 {
+  if (mapped_data_) {
+    file_.unmap(mapped_data_);
+    mapped_data_ = nullptr;
+    mapped_size_ = 0;
+  }
+
   if (file_.isOpen()) {
     file_.close();
   }
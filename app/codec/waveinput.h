@@ -44,6 +44,24 @@ public:
   QByteArray read(int offset, int length);
   qint64 read(int offset, char *buffer, int length);
 
+  /**
+   * @brief Map the audio data into memory so it can be read with data() instead of being copied by read()
+   *
+   * Must be called after open(). Returns false if the file couldn't be mapped, in which case read() still works.
+   */
+  bool map();
+
+  bool is_mapped() const;
+
+  /**
+   * @brief Zero-copy equivalent of read(offset, length) for a mapped file
+   *
+   * Returns a pointer into the mapping and clamps `length` to the data that's available, or nullptr if the file isn't
+   * mapped. The pointer is valid until close(). The OS is asked to start loading the range after this one so
+   * sequential reads don't wait on the disk.
+   */
+  const char* data(int offset, int* length) const;
+
   bool seek(qint64 pos);
 
   bool at_end() const;
@@ -68,6 +86,10 @@ private:
   qint64 data_position_;
 
   quint32 data_size_;
+
+  uchar* mapped_data_;
+
+  qint64 mapped_size_;
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -31,7 +31,9 @@ double Bezier::QuadraticXtoT(double x, double a, double b, double c)
 
 double Bezier::QuadraticTtoY(double a, double b, double c, double t)
 {
-  return qPow(1.0 - t, 2)*a + 2*(1.0 - t)*t*b + qPow(t, 2)*c;
+  double inv_t = 1.0 - t;
+
+  return inv_t*inv_t*a + 2*inv_t*t*b + t*t*c;
 }
 
 double Bezier::CubicXtoT(double x_target, double a, double b, double c, double d)
@@ -58,9 +60,43 @@ double Bezier::CubicXtoT(double x_target, double a, double b, double c, double d
   return percent;
 }
 
+double Bezier::CubicXtoT(double x_target, double a, double b, double c, double d, double t_guess)
+{
+  double tolerance = 0.0001;
+
+  double t = qBound(0.0, t_guess, 1.0);
+
+  // Newton-Raphson using the curve's derivative
+  for (int i=0;i<8;i++) {
+    double x = CubicTtoY(a, b, c, d, t);
+
+    if (qAbs(x_target - x) <= tolerance) {
+      return t;
+    }
+
+    double inv_t = 1.0 - t;
+    double slope = 3*inv_t*inv_t*(b - a) + 6*inv_t*t*(c - b) + 3*t*t*(d - c);
+
+    if (qFuzzyIsNull(slope)) {
+      break;
+    }
+
+    t -= (x - x_target) / slope;
+
+    if (t < 0.0 || t > 1.0) {
+      break;
+    }
+  }
+
+  // Didn't converge, fall back to bisection which always will
+  return CubicXtoT(x_target, a, b, c, d);
+}
+
 double Bezier::CubicTtoY(double a, double b, double c, double d, double t)
 {
-  return qPow(1.0 - t, 3)*a + 3*qPow(1.0 - t, 2)*t*b + 3*(1.0 - t)*qPow(t, 2)*c + qPow(t, 3)*d;
+  double inv_t = 1.0 - t;
+
+  return inv_t*inv_t*inv_t*a + 3*inv_t*inv_t*t*b + 3*inv_t*t*t*c + t*t*t*d;
 }
 
 OLIVE_NAMESPACE_EXIT
@@ -34,6 +34,13 @@ public:
 
   static double CubicXtoT(double x_target, double a, double b, double c, double d);
 
+  /**
+   * @brief Solve for T starting from a guess, which converges in a couple of iterations if the guess is close
+   *
+   * Useful when sampling a curve at increasing X, since each solution is a good guess for the next one.
+   */
+  static double CubicXtoT(double x_target, double a, double b, double c, double d, double t_guess);
+
   static double CubicTtoY(double a, double b, double c, double d, double t);
 };
 
@@ -0,0 +1,183 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "fasthash.h"
+
+#include <cstring>
+
+#include <QtEndian>
+
+OLIVE_NAMESPACE_ENTER
+
+static const quint64 kMurmurC1 = Q_UINT64_C(0x87c37b91114253d5);
+static const quint64 kMurmurC2 = Q_UINT64_C(0x4cf5ad432745937f);
+
+static inline quint64 RotateLeft64(quint64 x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline quint64 FinalMix64(quint64 k)
+{
+  k ^= k >> 33;
+  k *= Q_UINT64_C(0xff51afd7ed558ccd);
+  k ^= k >> 33;
+  k *= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+  k ^= k >> 33;
+
+  return k;
+}
+
+FastHash::FastHash()
+{
+  reset();
+}
+
+void FastHash::addData(const char *data, int length)
+{
+  const uchar* bytes = reinterpret_cast<const uchar*>(data);
+
+  total_length_ += length;
+
+  // Fill up any partial block left over from the last call first
+  if (tail_length_ > 0) {
+    int copy_length = qMin(16 - tail_length_, length);
+
+    memcpy(tail_ + tail_length_, bytes, copy_length);
+    tail_length_ += copy_length;
+    bytes += copy_length;
+    length -= copy_length;
+
+    if (tail_length_ < 16) {
+      return;
+    }
+
+    ProcessBlock(tail_);
+    tail_length_ = 0;
+  }
+
+  while (length >= 16) {
+    ProcessBlock(bytes);
+    bytes += 16;
+    length -= 16;
+  }
+
+  if (length > 0) {
+    memcpy(tail_, bytes, length);
+    tail_length_ = length;
+  }
+}
+
+void FastHash::addData(const QByteArray &data)
+{
+  addData(data.constData(), data.size());
+}
+
+void FastHash::reset()
+{
+  h1_ = 0;
+  h2_ = 0;
+  tail_length_ = 0;
+  total_length_ = 0;
+}
+
+QByteArray FastHash::result() const
+{
+  quint64 h1 = h1_;
+  quint64 h2 = h2_;
+
+  // Mix in the remaining bytes that didn't make up a full block
+  quint64 k1 = 0;
+  quint64 k2 = 0;
+
+  for (int i=tail_length_-1;i>=8;i--) {
+    k2 ^= quint64(tail_[i]) << ((i - 8) * 8);
+  }
+
+  if (tail_length_ > 8) {
+    k2 *= kMurmurC2;
+    k2 = RotateLeft64(k2, 33);
+    k2 *= kMurmurC1;
+    h2 ^= k2;
+  }
+
+  for (int i=qMin(tail_length_, 8)-1;i>=0;i--) {
+    k1 ^= quint64(tail_[i]) << (i * 8);
+  }
+
+  if (tail_length_ > 0) {
+    k1 *= kMurmurC1;
+    k1 = RotateLeft64(k1, 31);
+    k1 *= kMurmurC2;
+    h1 ^= k1;
+  }
+
+  // Finalize
+  h1 ^= total_length_;
+  h2 ^= total_length_;
+
+  h1 += h2;
+  h2 += h1;
+
+  h1 = FinalMix64(h1);
+  h2 = FinalMix64(h2);
+
+  h1 += h2;
+  h2 += h1;
+
+  QByteArray out(16, Qt::Uninitialized);
+  qToLittleEndian(h1, reinterpret_cast<uchar*>(out.data()));
+  qToLittleEndian(h2, reinterpret_cast<uchar*>(out.data() + 8));
+
+  return out;
+}
+
+QByteArray FastHash::hash(const QByteArray &data)
+{
+  FastHash hasher;
+  hasher.addData(data);
+  return hasher.result();
+}
+
+void FastHash::ProcessBlock(const uchar *block)
+{
+  quint64 k1 = qFromLittleEndian<quint64>(block);
+  quint64 k2 = qFromLittleEndian<quint64>(block + 8);
+
+  k1 *= kMurmurC1;
+  k1 = RotateLeft64(k1, 31);
+  k1 *= kMurmurC2;
+  h1_ ^= k1;
+
+  h1_ = RotateLeft64(h1_, 27);
+  h1_ += h2_;
+  h1_ = h1_ * 5 + 0x52dce729;
+
+  k2 *= kMurmurC2;
+  k2 = RotateLeft64(k2, 33);
+  k2 *= kMurmurC1;
+  h2_ ^= k2;
+
+  h2_ = RotateLeft64(h2_, 31);
+  h2_ += h1_;
+  h2_ = h2_ * 5 + 0x38495ab5;
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,74 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef FASTHASH_H
+#define FASTHASH_H
+
+#include <QByteArray>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Fast non-cryptographic 128-bit streaming hash (MurmurHash3 x64_128)
+ *
+ * Drop-in for QCryptographicHash where we only need to identify data rather than protect it. Data can be added in
+ * any number of chunks and will produce the same result as adding it all at once.
+ */
+class FastHash
+{
+public:
+  FastHash();
+
+  void addData(const char* data, int length);
+
+  void addData(const QByteArray& data);
+
+  void reset();
+
+  /**
+   * @brief Returns the 16 byte hash of all data added so far
+   */
+  QByteArray result() const;
+
+  /**
+   * @brief Convenience function for hashing a single block of data
+   */
+  static QByteArray hash(const QByteArray& data);
+
+private:
+  void ProcessBlock(const uchar* block);
+
+  quint64 h1_;
+
+  quint64 h2_;
+
+  uchar tail_[16];
+
+  int tail_length_;
+
+  quint64 total_length_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // FASTHASH_H
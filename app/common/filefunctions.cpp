@@ -29,6 +29,11 @@
 
 #include "config/config.h"
 
+#if defined(Q_OS_MAC) || defined(Q_OS_LINUX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 OLIVE_NAMESPACE_ENTER
 
 QString GetUniqueFileIdentifier(const QString &filename)
@@ -98,4 +103,41 @@ QString GetApplicationPath()
   return QCoreApplication::applicationDirPath();
 }
 
+#if defined(Q_OS_MAC) || defined(Q_OS_LINUX)
+static void MappedAdvise(const void* data, qint64 size, int advice)
+{
+  if (!data || size <= 0) {
+    return;
+  }
+
+  // madvise() needs a page-aligned address. QFile::map() maps from the start of the page so the aligned address is
+  // still inside the mapping.
+  quintptr page_size = static_cast<quintptr>(sysconf(_SC_PAGESIZE));
+  quintptr address = reinterpret_cast<quintptr>(data);
+  quintptr aligned = address & ~(page_size - 1);
+
+  madvise(reinterpret_cast<void*>(aligned), static_cast<size_t>(size) + (address - aligned), advice);
+}
+#endif
+
+void AdviseSequentialAccess(const void *data, qint64 size)
+{
+#if defined(Q_OS_MAC) || defined(Q_OS_LINUX)
+  MappedAdvise(data, size, MADV_SEQUENTIAL);
+#else
+  Q_UNUSED(data)
+  Q_UNUSED(size)
+#endif
+}
+
+void AdviseWillNeed(const void *data, qint64 size)
+{
+#if defined(Q_OS_MAC) || defined(Q_OS_LINUX)
+  MappedAdvise(data, size, MADV_WILLNEED);
+#else
+  Q_UNUSED(data)
+  Q_UNUSED(size)
+#endif
+}
+
 OLIVE_NAMESPACE_EXIT
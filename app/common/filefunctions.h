@@ -41,6 +41,16 @@ QString GetConfigurationLocation();
 
 QString GetApplicationPath();
 
+/**
+ * @brief Hint that a memory-mapped file will be read from start to finish so the OS reads ahead aggressively
+ */
+void AdviseSequentialAccess(const void* data, qint64 size);
+
+/**
+ * @brief Hint that a range of a memory-mapped file is about to be read so the OS can start loading it now
+ */
+void AdviseWillNeed(const void* data, qint64 size);
+
 OLIVE_NAMESPACE_EXIT
 
 #endif // FILEFUNCTIONS_H
@@ -21,11 +21,12 @@
 #ifndef MEMORYPOOL_H
 #define MEMORYPOOL_H
 
+#include <chrono>
 #include <memory>
-#include <QDateTime>
+#include <QAtomicInteger>
 #include <QDebug>
 #include <QLinkedList>
-#include <QMutex>
+#include <QReadWriteLock>
 #include <stdint.h>
 
 #include "common/define.h"
@@ -45,6 +46,9 @@ template <typename T>
  *
  * `Get()` will return an ElementPtr. The original desired data can be accessed through ElementPtr::data(). This data
  * will belong to the caller until ElementPtr goes out of scope and the memory is freed back into the pool.
+ *
+ * Getting and releasing elements is lock-free and O(1) within an arena. The pool only takes an exclusive lock when
+ * arenas are created or destroyed.
  */
 class MemoryPool
 {
@@ -84,6 +88,17 @@ public:
     return arenas_.size();
   }
 
+  /**
+   * @brief The clock used by Element::access() and Element::last_accessed(), in milliseconds
+   *
+   * Monotonic and much cheaper to query than the wall clock, but only meaningful relative to other values from here.
+   */
+  static inline int64_t AccessClock() {
+    std::chrono::steady_clock::duration now = std::chrono::steady_clock::now().time_since_epoch();
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+  }
+
   class Arena;
 
   /**
@@ -103,7 +118,8 @@ public:
     Element(Arena* parent, T* data) {
       parent_ = parent;
       data_ = data;
-      accessed_ = QDateTime::currentMSecsSinceEpoch();
+      accessed_ = AccessClock();
+      used_ = false;
     }
 
     /**
@@ -138,14 +154,23 @@ public:
      * \see last_accessed()
      */
     inline void access() {
-      accessed_ = QDateTime::currentMSecsSinceEpoch();
+      accessed_ = AccessClock();
+      used_ = true;
+    }
+
+    /**
+     * @brief Returns true if `access()` has been called since this element was retrieved from the pool
+     */
+    inline bool has_been_accessed() const {
+      return used_;
     }
 
     /**
      * @brief Returns the last time `access()` was called on this function
      *
      * Useful for determining the relative age of an element (i.e. if it hasn't been accessed for a certain amount of
-     * time, it can probably be freed back into the pool). This requires all usages to call `access()`.
+     * time, it can probably be freed back into the pool). This requires all usages to call `access()`. The value is
+     * in terms of AccessClock().
      */
     inline const int64_t& last_accessed() const {
       return accessed_;
@@ -160,6 +185,8 @@ public:
 
     int64_t accessed_;
 
+    bool used_;
+
   };
 
   using ElementPtr = std::shared_ptr<Element>;
@@ -170,19 +197,24 @@ public:
    * The pool itself does not store memory, it stores "arenas". This is so that the pool can handle the situation of
    * an arena becoming full with no more memory to lend. A pool can automatically allocate another arena and continue
    * providing memory (and freeing arenas when they're no longer in use).
+   *
+   * Free elements are kept in an intrusive lock-free stack of indices. The head of the stack is stored alongside a
+   * counter that changes on every pop so a stale head can never be swapped in (the ABA problem).
    */
   class Arena {
   public:
     Arena(MemoryPool* parent) {
       parent_ = parent;
       data_ = nullptr;
-      use_count_ = 0;
+      next_ = nullptr;
+      element_count_ = 0;
     }
 
     ~Arena() {
       // FIXME: Invalidate elements that have been lent out?
 
       delete [] data_;
+      delete [] next_;
     }
 
     DISABLE_COPY_MOVE(Arena)
@@ -191,41 +223,53 @@ public:
      * @brief Returns an element if there is free memory to do so
      */
     ElementPtr Get() {
-      QMutexLocker locker(&lock_);
-
-      for (int i=0;i<available_.size();i++) {
-        if (available_.at(i)) {
-          // This buffer is available
-          available_.replace(i, false);
-          use_count_++;
-          return std::make_shared<Element>(this, reinterpret_cast<T*>(data_ + i * element_sz_));
+      quint64 head = free_head_.loadAcquire();
+
+      while (true) {
+        quint32 index = HeadIndex(head);
+
+        if (index == kNoElement) {
+          return nullptr;
         }
-      }
 
-      return nullptr;
+        // If another thread pops this index first, the tag will have changed and the swap below will fail
+        quint64 new_head = MakeHead(static_cast<quint32>(next_[index].loadAcquire()), HeadTag(head) + 1);
+
+        if (free_head_.testAndSetOrdered(head, new_head, head)) {
+          use_count_.fetchAndAddOrdered(1);
+          return std::make_shared<Element>(this, reinterpret_cast<T*>(data_ + index * element_sz_));
+        }
+      }
     }
 
     /**
      * @brief Releases an element back into the pool for use elsewhere
      */
     void Release(Element* e) {
-      QMutexLocker locker(&lock_);
+      // This arena may be deleted as soon as the use count reaches zero so grab what we need beforehand
+      MemoryPool* parent = parent_;
+
       quintptr diff = reinterpret_cast<quintptr>(e->data()) - reinterpret_cast<quintptr>(data_);
 
-      int index = diff / element_sz_;
+      quint32 index = static_cast<quint32>(diff / element_sz_);
+
+      quint64 head = free_head_.loadAcquire();
 
-      available_.replace(index, true);
-      use_count_--;
+      while (true) {
+        next_[index].storeRelease(static_cast<int>(HeadIndex(head)));
 
-      if (!use_count_) {
-        locker.unlock();
-        parent_->ArenaIsEmpty(this);
+        if (free_head_.testAndSetOrdered(head, MakeHead(index, HeadTag(head)), head)) {
+          break;
+        }
+      }
+
+      if (use_count_.fetchAndAddOrdered(-1) == 1) {
+        parent->ArenaIsEmpty(this);
       }
     }
 
-    const int& GetUsageCount() {
-      QMutexLocker locker(&lock_);
-      return use_count_;
+    int GetUsageCount() const {
+      return use_count_.loadAcquire();
     }
 
     bool Allocate(size_t ele_sz, size_t nb_elements) {
@@ -236,12 +280,18 @@ public:
       element_sz_ = ele_sz;
 
       if ((data_ = new char[element_sz_ * nb_elements])) {
-        available_.resize(nb_elements);
-        available_.fill(true);
+        element_count_ = static_cast<int>(nb_elements);
+
+        // Chain every element into the free list
+        next_ = new QAtomicInt[nb_elements];
+        for (int i=0;i<element_count_;i++) {
+          next_[i].storeRelease(i + 1 < element_count_ ? i + 1 : static_cast<int>(kNoElement));
+        }
+
+        free_head_.storeRelease(MakeHead(0, 0));
 
         return true;
       } else {
-        available_.clear();
         data_ = nullptr;
 
         return false;
@@ -249,7 +299,7 @@ public:
     }
 
     inline int GetElementCount() const {
-      return available_.size();
+      return element_count_;
     }
 
     inline bool IsAllocated() const {
@@ -257,17 +307,36 @@ public:
     }
 
   private:
+    static const quint32 kNoElement = 0xFFFFFFFF;
+
+    static inline quint64 MakeHead(quint32 index, quint32 tag) {
+      return (static_cast<quint64>(tag) << 32) | index;
+    }
+
+    static inline quint32 HeadIndex(quint64 head) {
+      return static_cast<quint32>(head);
+    }
+
+    static inline quint32 HeadTag(quint64 head) {
+      return static_cast<quint32>(head >> 32);
+    }
+
     MemoryPool* parent_;
 
     char* data_;
 
-    QVector<bool> available_;
+    /**
+     * @brief For each free element, the index of the next free element (or kNoElement)
+     */
+    QAtomicInt* next_;
+
+    QAtomicInteger<quint64> free_head_;
 
-    QMutex lock_;
+    QAtomicInt use_count_;
 
     size_t element_sz_;
 
-    int use_count_;
+    int element_count_;
 
   };
 
@@ -275,17 +344,26 @@ public:
    * @brief Retrieves an element from an available arena
    */
   ElementPtr Get() {
-    QMutexLocker locker(&lock_);
+    {
+      QReadLocker locker(&lock_);
 
-    // Attempt to get an element from an arena
-    foreach (Arena* a, arenas_) {
-      ElementPtr e = a->Get();
+      // Attempt to get an element from an arena
+      ElementPtr e = GetFromArenas();
 
       if (e) {
         return e;
       }
     }
 
+    QWriteLocker locker(&lock_);
+
+    // Another thread may have created an arena (or released an element) while we were waiting for the lock
+    ElementPtr e = GetFromArenas();
+
+    if (e) {
+      return e;
+    }
+
     // All arenas were empty, we'll need to create a new one
     if (arenas_.isEmpty()) {
       qDebug() << "No arenas, creating new...";
@@ -312,14 +390,17 @@ public:
       return nullptr;
     }
 
-    arenas_.append(a);
+    // New arenas go first since they're the ones with free elements
+    arenas_.prepend(a);
     return a->Get();
   }
 
   void ArenaIsEmpty(Arena* a) {
-    QMutexLocker locker(&lock_);
+    QWriteLocker locker(&lock_);
 
-    if (!a->GetUsageCount()) {
+    // By the time we have the lock, another release may have already deleted this arena, or a Get() may have started
+    // using it again
+    if (arenas_.contains(a) && !a->GetUsageCount()) {
       qDebug() << "Removing an empty arena";
       arenas_.removeOne(a);
       delete a;
@@ -337,11 +418,28 @@ protected:
   }
 
 private:
+  /**
+   * @brief Attempt to get an element from any existing arena
+   *
+   * NOTE: Assumes lock_ is held by the caller (for reading or writing)
+   */
+  ElementPtr GetFromArenas() {
+    foreach (Arena* a, arenas_) {
+      ElementPtr e = a->Get();
+
+      if (e) {
+        return e;
+      }
+    }
+
+    return nullptr;
+  }
+
   int element_count_;
 
   QLinkedList<Arena*> arenas_;
 
-  QMutex lock_;
+  QReadWriteLock lock_;
 
 };
 
@@ -3,6 +3,8 @@
 
 #include "rational.h"
 
+#include <cmath>
+
 OLIVE_NAMESPACE_ENTER
 
 rational::rational(const AVRational &r) :
@@ -14,6 +16,11 @@ rational::rational(const AVRational &r) :
 
 rational rational::fromDouble(const double &flt)
 {
+  // Whole numbers (common for seconds and frame counts) don't need an approximation
+  if (flt == std::floor(flt) && flt >= INT32_MIN && flt <= INT32_MAX) {
+    return rational(static_cast<intType>(flt));
+  }
+
   // Use FFmpeg function for the time being
   return av_d2q(flt, INT_MAX);
 }
@@ -82,16 +89,15 @@ void rational::reduce()
 
 //Function: finds greatest common denominator
 
-intType rational::gcd(intType &x, intType &y)
+intType rational::gcd(intType x, intType y)
 {
-  if(y == 0)
-    return x;
-  else
-    {
-      intType tmp = x % y;
+  while (y != 0) {
+    intType tmp = x % y;
+    x = y;
+    y = tmp;
+  }
 
-      return gcd(y, tmp);
-    }
+  return x;
 }
 
 //Function: convert to double
@@ -139,6 +145,51 @@ QString rational::toString() const
   return QStringLiteral("%1/%2").arg(QString::number(numer), QString::number(denom));
 }
 
+void rational::addInternal(const intType &n, const intType &d)
+{
+  // Both operands are already in lowest terms, so we only need to reduce by factors the denominators share
+  // (Knuth, TAOCP Vol. 2, 4.5.1). Same-timebase arithmetic skips the multiplication altogether.
+  if (denom == d) {
+    numer += n;
+    if (denom != 1) {
+      reduce();
+    }
+  } else {
+    intType g = gcd(denom, d);
+
+    if (g == 1) {
+      numer = numer * d + n * denom;
+      denom = denom * d;
+    } else {
+      intType t = numer * (d / g) + n * (denom / g);
+      intType g2 = gcd(qAbs(t), g);
+
+      numer = t / g2;
+      denom = (denom / g) * (d / g2);
+    }
+  }
+
+  fixSigns();
+}
+
+void rational::multiplyInternal(const intType &n, const intType &d)
+{
+  if (numer == 0 || denom == 0 || n == 0 || d == 0) {
+    numer = 0;
+    denom = 0;
+    return;
+  }
+
+  // Cross-reduce before multiplying so the result is already in lowest terms and the intermediate values stay small
+  intType g1 = gcd(qAbs(numer), d);
+  intType g2 = gcd(qAbs(n), denom);
+
+  numer = (numer / g1) * (n / g2);
+  denom = (denom / g2) * (d / g1);
+
+  fixSigns();
+}
+
 void rational::validateConstructor()
 {
   if(denom != intType(0))
@@ -186,12 +237,7 @@ const rational& rational::operator+=(const rational &rhs)
           denom = rhs.denom;
         }
       else
-        {
-          numer = (numer * rhs.denom) + (rhs.numer * denom);
-          denom = denom * rhs.denom;
-          fixSigns();
-          reduce();
-        }
+        addInternal(rhs.numer, rhs.denom);
   return *this;
 }
 
@@ -214,30 +260,24 @@ const rational& rational::operator-=(const rational &rhs)
           denom = rhs.denom;
         }
       else
-        {
-          numer = (numer * rhs.denom) - (rhs.numer * denom);
-          denom = denom * rhs.denom;
-          fixSigns();
-          reduce();
-        }
+        addInternal(-rhs.numer, rhs.denom);
   return *this;
 }
 
 const rational& rational::operator/=(const rational &rhs)
 {
-  numer = numer * rhs.denom;
-  denom = denom * rhs.numer;
-  fixSigns();
-  reduce();
+  // Multiply by the reciprocal, keeping the denominator positive
+  if (rhs.numer < 0) {
+    multiplyInternal(-rhs.denom, -rhs.numer);
+  } else {
+    multiplyInternal(rhs.denom, rhs.numer);
+  }
   return *this;
 }
 
 const rational& rational::operator*=(const rational &rhs)
 {
-  numer = numer * rhs.numer;
-  denom = denom * rhs.denom;
-  fixSigns();
-  reduce();
+  multiplyInternal(rhs.numer, rhs.denom);
   return *this;
 }
 
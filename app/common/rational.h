@@ -115,7 +115,13 @@ private:
   //Function: ensures lowest form
   void reduce();
   //Function: finds greatest common denominator
-  intType gcd(intType &x, intType &y);
+  static intType gcd(intType x, intType y);
+
+  //Function: adds n/d (in lowest terms) to this rational
+  void addInternal(const intType& n, const intType& d);
+
+  //Function: multiplies this rational by n/d (in lowest terms)
+  void multiplyInternal(const intType& n, const intType& d);
 };
 
 // We define these limits at 32-bit to try avoiding integer overflow
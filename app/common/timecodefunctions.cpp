@@ -20,6 +20,7 @@
 
 #include "timecodefunctions.h"
 
+#include <cmath>
 #include <QtMath>
 
 #include "config/config.h"
@@ -243,7 +244,7 @@ rational Timecode::snap_time_to_timebase(const rational &time, const rational &t
 
 rational Timecode::timestamp_to_time(const int64_t &timestamp, const rational &timebase)
 {
-  return rational(timestamp) * timebase;
+  return rational(timestamp * timebase.numerator(), timebase.denominator());
 }
 
 QString Timecode::time_to_timecode(const rational &time, const rational &timebase, const Timecode::Display &display, bool show_plus_if_positive)
@@ -258,22 +259,38 @@ bool Timecode::TimebaseIsDropFrame(const rational &timebase)
 
 int64_t Timecode::time_to_timestamp(const rational &time, const rational &timebase)
 {
-  return time_to_timestamp(time.toDouble(), timebase);
+  // Stay in integers so this is exact, any frame time maps back to its own timestamp
+  rational timestamp = time / timebase;
+
+  if (timestamp.isNull()) {
+    return 0;
+  }
+
+  return av_rescale_rnd(timestamp.numerator(), 1, timestamp.denominator(), AV_ROUND_NEAR_INF);
 }
 
 int64_t Timecode::time_to_timestamp(const double &time, const rational &timebase)
 {
-  return qRound64(time * timebase.flipped().toDouble());
+  // Round halfway cases away from zero, the same as the rational overload
+  return std::llround(time * timebase.flipped().toDouble());
 }
 
 int64_t Timecode::rescale_timestamp(const int64_t &ts, const rational &source, const rational &dest)
 {
-  return qRound64(static_cast<double>(ts) * source.toDouble() / dest.toDouble());
+  if (source.isNull() || dest.isNull()) {
+    return 0;
+  }
+
+  return av_rescale_q_rnd(ts, source.toAVRational(), dest.toAVRational(), AV_ROUND_NEAR_INF);
 }
 
 int64_t Timecode::rescale_timestamp_ceil(const int64_t &ts, const rational &source, const rational &dest)
 {
-  return qCeil(static_cast<double>(ts) * source.toDouble() / dest.toDouble());
+  if (source.isNull() || dest.isNull()) {
+    return 0;
+  }
+
+  return av_rescale_q_rnd(ts, source.toAVRational(), dest.toAVRational(), AV_ROUND_UP);
 }
 
 OLIVE_NAMESPACE_EXIT
@@ -104,6 +104,12 @@ TimeRange TimeRange::Combine(const TimeRange &a, const TimeRange &b)
                    qMax(a.out(), b.out()));
 }
 
+TimeRange TimeRange::Intersected(const TimeRange &a) const
+{
+  return TimeRange(qMax(in(), a.in()),
+                   qMin(out(), a.out()));
+}
+
 void TimeRange::normalize()
 {
   // If `out` is earlier than `in`, swap them
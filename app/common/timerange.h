@@ -47,6 +47,13 @@ public:
   TimeRange CombineWith(const TimeRange& a) const;
   static TimeRange Combine(const TimeRange &a, const TimeRange &b);
 
+  /**
+   * @brief Returns the range covered by both this range and `a`
+   *
+   * Assumes the two ranges overlap.
+   */
+  TimeRange Intersected(const TimeRange& a) const;
+
 private:
   void normalize();
 
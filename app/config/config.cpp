@@ -88,6 +88,10 @@ void Config::SetDefaults()
   config_map_["DiskCacheBehind"] = QVariant::fromValue(rational(2));
   config_map_["DiskCacheAhead"] = QVariant::fromValue(rational(10));
   config_map_["ClearDiskCacheOnClose"] = false;
+  config_map_["MemoryCacheSize"] = 2.0;
+  config_map_["UseCPURenderer"] = false;
+  config_map_["DecoderThreads"] = 0;
+  config_map_["StreamAudioFromSource"] = true;
 
   config_map_["DefaultSequenceWidth"] = 1920;
   config_map_["DefaultSequenceHeight"] = 1080;
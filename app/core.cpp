@@ -51,6 +51,7 @@
 #include "render/backend/opengl/opengltexturecache.h"
 #include "render/colormanager.h"
 #include "render/diskmanager.h"
+#include "render/memorymanager.h"
 #include "render/pixelformat.h"
 #include "task/taskmanager.h"
 #include "ui/style/style.h"
@@ -189,6 +190,8 @@ void Core::Stop()
 
   AudioManager::DestroyInstance();
 
+  MemoryManager::DestroyInstance();
+
   DiskManager::DestroyInstance();
 
   PixelFormat::DestroyInstance();
@@ -528,6 +531,9 @@ void Core::StartGUI(bool full_screen)
   // Initialize disk service
   DiskManager::CreateInstance();
 
+  // Initialize memory cache in front of the disk service
+  MemoryManager::CreateInstance();
+
   // Initialize task manager
   TaskManager::CreateInstance();
 
@@ -65,6 +65,16 @@ PreferencesDiskTab::PreferencesDiskTab()
 
   row++;
 
+  disk_management_layout->addWidget(new QLabel(tr("Maximum Memory Cache:")), row, 0);
+
+  maximum_memory_slider_ = new FloatSlider();
+  maximum_memory_slider_->SetSuffix(QStringLiteral(" GB"));
+  maximum_memory_slider_->SetMinimum(0.0);
+  maximum_memory_slider_->SetValue(Config::Current()["MemoryCacheSize"].toDouble());
+  disk_management_layout->addWidget(maximum_memory_slider_, row, 1, 1, 2);
+
+  row++;
+
   clear_cache_btn_ = new QPushButton(tr("Clear Disk Cache"));
   connect(clear_cache_btn_, &QPushButton::clicked, this, &PreferencesDiskTab::ClearDiskCache);
   disk_management_layout->addWidget(clear_cache_btn_, row, 1, 1, 2);
@@ -75,6 +85,12 @@ PreferencesDiskTab::PreferencesDiskTab()
   clear_disk_cache_->setChecked(Config::Current()["ClearDiskCacheOnClose"].toBool());
   disk_management_layout->addWidget(clear_disk_cache_, row, 1, 1, 2);
 
+  row++;
+
+  stream_audio_ = new QCheckBox(tr("Decode audio from the source instead of caching it to disk"));
+  stream_audio_->setChecked(Config::Current()["StreamAudioFromSource"].toBool());
+  disk_management_layout->addWidget(stream_audio_, row, 1, 1, 2);
+
   QGroupBox* cache_behavior = new QGroupBox(tr("Cache Behavior"));
   outer_layout->addWidget(cache_behavior);
   QGridLayout* cache_behavior_layout = new QGridLayout(cache_behavior);
@@ -102,7 +118,9 @@ void PreferencesDiskTab::Accept()
 {
   Config::Current()["DiskCachePath"] = disk_cache_location_->text();
   Config::Current()["DiskCacheSize"] = maximum_cache_slider_->GetValue();
+  Config::Current()["MemoryCacheSize"] = maximum_memory_slider_->GetValue();
   Config::Current()["ClearDiskCacheOnClose"] = clear_disk_cache_->isChecked();
+  Config::Current()["StreamAudioFromSource"] = stream_audio_->isChecked();
   Config::Current()["DiskCacheBehind"] = QVariant::fromValue(rational::fromDouble(cache_behind_slider_->GetValue()));
   Config::Current()["DiskCacheAhead"] = QVariant::fromValue(rational::fromDouble(cache_ahead_slider_->GetValue()));
 }
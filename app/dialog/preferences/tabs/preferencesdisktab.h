@@ -43,12 +43,16 @@ private:
 
   FloatSlider* maximum_cache_slider_;
 
+  FloatSlider* maximum_memory_slider_;
+
   FloatSlider* cache_ahead_slider_;
 
   FloatSlider* cache_behind_slider_;
 
   QCheckBox* clear_disk_cache_;
 
+  QCheckBox* stream_audio_;
+
   QPushButton* clear_cache_btn_;
 
 private slots:
@@ -25,6 +25,7 @@
 #include <QVBoxLayout>
 
 #include "audio/sampleformat.h"
+#include "config/config.h"
 #include "render/colormanager.h"
 #include "render/pixelformat.h"
 
@@ -46,6 +47,34 @@ PreferencesQualityTab::PreferencesQualityTab()
 
   layout->addLayout(profile_layout);
 
+  QHBoxLayout* renderer_layout = new QHBoxLayout();
+  renderer_layout->setMargin(0);
+
+  // Viewers create their backend on startup so this only applies to exports until Olive is restarted
+  renderer_layout->addWidget(new QLabel(tr("Renderer (requires restart):")));
+
+  renderer_combobox_ = new QComboBox();
+  renderer_combobox_->addItem(tr("OpenGL"));
+  renderer_combobox_->addItem(tr("CPU"));
+  renderer_combobox_->setCurrentIndex(Config::Current()["UseCPURenderer"].toBool() ? 1 : 0);
+  renderer_layout->addWidget(renderer_combobox_);
+
+  layout->addLayout(renderer_layout);
+
+  QHBoxLayout* decoder_threads_layout = new QHBoxLayout();
+  decoder_threads_layout->setMargin(0);
+
+  // Only applies to footage opened after this is changed
+  decoder_threads_layout->addWidget(new QLabel(tr("Decoder Threads:")));
+
+  decoder_threads_spinbox_ = new QSpinBox();
+  decoder_threads_spinbox_->setRange(0, 64);
+  decoder_threads_spinbox_->setSpecialValueText(tr("Automatic"));
+  decoder_threads_spinbox_->setValue(Config::Current()["DecoderThreads"].toInt());
+  decoder_threads_layout->addWidget(decoder_threads_spinbox_);
+
+  layout->addLayout(decoder_threads_layout);
+
   quality_stack_ = new QStackedWidget();
 
   offline_group_ = new PreferencesQualityGroup(tr("Offline Quality"));
@@ -67,6 +96,8 @@ PreferencesQualityTab::PreferencesQualityTab()
 
 void PreferencesQualityTab::Accept()
 {
+  Config::Current()["UseCPURenderer"] = (renderer_combobox_->currentIndex() == 1);
+  Config::Current()["DecoderThreads"] = decoder_threads_spinbox_->value();
   ColorManager::SetOCIOMethodForMode(RenderMode::kOffline, static_cast<ColorManager::OCIOMethod>(offline_group_->ocio_method()->currentIndex()));
   ColorManager::SetOCIOMethodForMode(RenderMode::kOnline, static_cast<ColorManager::OCIOMethod>(online_group_->ocio_method()->currentIndex()));
   PixelFormat::instance()->SetConfiguredFormatForMode(RenderMode::kOffline, static_cast<PixelFormat::Format>(offline_group_->bit_depth_combobox()->currentData().toInt()));
@@ -24,6 +24,7 @@
 #include <QComboBox>
 #include <QDoubleSpinBox>
 #include <QGroupBox>
+#include <QSpinBox>
 #include <QStackedWidget>
 
 #include "preferencestab.h"
@@ -60,6 +61,10 @@ public:
   virtual void Accept() override;
 
 private:
+  QComboBox* renderer_combobox_;
+
+  QSpinBox* decoder_threads_spinbox_;
+
   QStackedWidget* quality_stack_;
 
   PreferencesQualityGroup* offline_group_;
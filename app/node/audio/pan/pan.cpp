@@ -69,23 +69,39 @@ NodeInput *PanNode::ProcessesSamplesFrom(const NodeValueDatabase &value) const
   return samples_input_;
 }
 
-void PanNode::ProcessSamples(const NodeValueDatabase &values, const AudioRenderingParams &params, const SampleBufferPtr input, SampleBufferPtr output, int index) const
+void PanNode::ProcessSamples(const NodeValueDatabase &, const SampleAutomationMap& automation, const AudioRenderingParams &params, const SampleBufferPtr input, SampleBufferPtr output) const
 {
+  int sample_count = input->sample_count_per_channel();
+
   if (params.channel_count() != 2) {
-    // This node currently only works for stereo audio
+    // This node currently only works for stereo audio so pass everything else through untouched
+    output->set(input->const_data(), sample_count);
     return;
   }
 
-  float pan_val = values[panning_input_].Get(NodeParam::kFloat).toFloat();
-
-  for (int i=0;i<params.channel_count();i++) {
-    output->data()[i][index] = input->data()[i][index];
-  }
-
-  if (pan_val > 0) {
-    output->data()[0][index] *= (1.0F - pan_val);
-  } else if (pan_val < 0) {
-    output->data()[1][index] *= (1.0F - qAbs(pan_val));
+  SampleAutomation pan = automation.value(panning_input_);
+
+  const float* in_left = input->data()[0];
+  const float* in_right = input->data()[1];
+  float* out_left = output->data()[0];
+  float* out_right = output->data()[1];
+
+  if (pan.is_constant()) {
+    // Panning right attenuates the left channel and vice versa
+    float left_val = 1.0F - qMax(pan.constant(), 0.0F);
+    float right_val = 1.0F + qMin(pan.constant(), 0.0F);
+
+    for (int j=0;j<sample_count;j++) {
+      out_left[j] = in_left[j] * left_val;
+      out_right[j] = in_right[j] * right_val;
+    }
+  } else {
+    const float* pan_val = pan.curve();
+
+    for (int j=0;j<sample_count;j++) {
+      out_left[j] = in_left[j] * (1.0F - qMax(pan_val[j], 0.0F));
+      out_right[j] = in_right[j] * (1.0F + qMin(pan_val[j], 0.0F));
+    }
   }
 }
 
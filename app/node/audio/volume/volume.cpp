@@ -68,12 +68,28 @@ NodeInput *VolumeNode::ProcessesSamplesFrom(const NodeValueDatabase &) const
   return samples_input_;
 }
 
-void VolumeNode::ProcessSamples(const NodeValueDatabase &values, const AudioRenderingParams& params, const SampleBufferPtr input, SampleBufferPtr output, int index) const
+void VolumeNode::ProcessSamples(const NodeValueDatabase &, const SampleAutomationMap& automation, const AudioRenderingParams& params, const SampleBufferPtr input, SampleBufferPtr output) const
 {
-  float volume_val = values[volume_input_].Get(NodeParam::kFloat).toFloat();
+  SampleAutomation volume = automation.value(volume_input_);
+  int sample_count = input->sample_count_per_channel();
 
   for (int i=0;i<params.channel_count();i++) {
-    output->data()[i][index] = input->data()[i][index] * volume_val;
+    const float* in = input->data()[i];
+    float* out = output->data()[i];
+
+    if (volume.is_constant()) {
+      float volume_val = volume.constant();
+
+      for (int j=0;j<sample_count;j++) {
+        out[j] = in[j] * volume_val;
+      }
+    } else {
+      const float* volume_val = volume.curve();
+
+      for (int j=0;j<sample_count;j++) {
+        out[j] = in[j] * volume_val[j];
+      }
+    }
   }
 }
 
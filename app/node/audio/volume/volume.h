@@ -39,7 +39,7 @@ public:
 
   virtual Capabilities GetCapabilities(const NodeValueDatabase&) const override;
   virtual NodeInput* ProcessesSamplesFrom(const NodeValueDatabase &value) const override;
-  virtual void ProcessSamples(const NodeValueDatabase& values, const AudioRenderingParams& params, const SampleBufferPtr input, SampleBufferPtr output, int index) const override;
+  virtual void ProcessSamples(const NodeValueDatabase& values, const SampleAutomationMap& automation, const AudioRenderingParams& params, const SampleBufferPtr input, SampleBufferPtr output) const override;
 
   virtual void Retranslate() override;
 
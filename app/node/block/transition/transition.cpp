@@ -64,6 +64,12 @@ void TransitionBlock::Retranslate()
   in_block_input_->set_name(tr("To"));
 }
 
+bool TransitionBlock::IsTimeDependent() const
+{
+  // Transitions use their progress through the transition, which is derived from the current time
+  return true;
+}
+
 rational TransitionBlock::in_offset() const
 {
   // If no in block is connected, there's no in offset
@@ -37,6 +37,8 @@ public:
 
   virtual void Retranslate() override;
 
+  virtual bool IsTimeDependent() const override;
+
   rational in_offset() const;
   rational out_offset() const;
 
@@ -20,6 +20,7 @@
 
 #include "input.h"
 
+#include <algorithm>
 #include <QMatrix4x4>
 #include <QVector2D>
 #include <QVector3D>
@@ -369,6 +370,45 @@ Node *NodeInput::get_connected_node() const
   return nullptr;
 }
 
+int NodeInput::GetIndexAfterTime(const rational &start, const rational &interval, const rational &time, bool inclusive)
+{
+  // Solve `start + interval * index = time` for index
+  rational index = (time - start) / interval;
+
+  intType num = index.numerator();
+  intType den = index.denominator();
+
+  if (num == 0) {
+    // NOTE: rational represents 0 as 0/0
+    return inclusive ? 1 : 0;
+  }
+
+  if (den < 0) {
+    num = -num;
+    den = -den;
+  }
+
+  intType floor_index = num / den;
+  bool exact = (num % den == 0);
+
+  if (!exact && num < 0) {
+    floor_index--;
+  }
+
+  if (inclusive || !exact) {
+    return static_cast<int>(floor_index + 1);
+  } else {
+    return static_cast<int>(floor_index);
+  }
+}
+
+void NodeInput::FillValues(float *out, int start, int end, float value)
+{
+  for (int i=start;i<end;i++) {
+    out[i] = value;
+  }
+}
+
 bool NodeInput::type_can_be_interpolated(NodeParam::DataType type)
 {
   return type == kFloat
@@ -418,13 +458,18 @@ QVariant NodeInput::get_value_at_time_for_track(const rational& time, int track)
       NodeKeyframePtr before = key_track.at(i);
       NodeKeyframePtr after = key_track.at(i+1);
 
-      if (before->time() == time
-          || !type_can_be_interpolated(data_type())
-          || (before->time() < time && before->type() == NodeKeyframe::kHold)) {
+      if (before->time() == time) {
 
         // Time == keyframe time, so value is precise
         return before->value();
 
+      } else if (before->time() < time
+                 && after->time() > time
+                 && (!type_can_be_interpolated(data_type()) || before->type() == NodeKeyframe::kHold)) {
+
+        // Values that don't interpolate stay at the previous keyframe until the next one
+        return before->value();
+
       } else if (after->time() == time) {
 
         // Time == keyframe time, so value is precise
@@ -488,6 +533,123 @@ QVariant NodeInput::get_value_at_time_for_track(const rational& time, int track)
   return standard_value_.at(track);
 }
 
+void NodeInput::get_values_at_interval_for_track(const rational &start, const rational &interval, int count, int track, float *out) const
+{
+  if (is_using_standard_value(track)) {
+    FillValues(out, 0, count, standard_value_.at(track).toFloat());
+    return;
+  }
+
+  const KeyframeTrack& key_track = keyframe_tracks_.at(track);
+
+  double start_dbl = start.toDouble();
+  double interval_dbl = interval.toDouble();
+
+  int i = 0;
+
+  while (i < count) {
+    rational time = start + interval * rational(i);
+
+    int end;
+
+    if (key_track.first()->time() >= time) {
+
+      // Every time up to and including the first keyframe is the first value
+      end = qMin(count, GetIndexAfterTime(start, interval, key_track.first()->time(), true));
+
+      FillValues(out, i, end, key_track.first()->value().toFloat());
+
+    } else if (key_track.last()->time() <= time) {
+
+      // Every time after the last keyframe is the last value
+      end = count;
+
+      FillValues(out, i, end, key_track.last()->value().toFloat());
+
+    } else {
+
+      // Find the first keyframe after this time, which ends the segment we're in
+      KeyframeTrack::const_iterator after_it = std::upper_bound(key_track.constBegin(),
+                                                                key_track.constEnd(),
+                                                                time,
+                                                                [](const rational& t, const NodeKeyframePtr& key){
+        return t < key->time();
+      });
+
+      NodeKeyframePtr before = *(after_it - 1);
+      NodeKeyframePtr after = *after_it;
+
+      // The segment runs from `before` up to but not including `after`, a time exactly on `after` starts the next one
+      end = qMin(count, GetIndexAfterTime(start, interval, after->time(), false));
+
+      double before_time = before->time().toDouble();
+      double after_time = after->time().toDouble();
+      double before_val = before->value().toDouble();
+      double after_val = after->value().toDouble();
+
+      if (!type_can_be_interpolated(data_type()) || before->type() == NodeKeyframe::kHold) {
+
+        FillValues(out, i, end, static_cast<float>(before_val));
+
+      } else if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
+
+        // Perform a cubic bezier with two control points
+        double control_out_time = before_time + before->bezier_control_out().x();
+        double control_in_time = after_time + after->bezier_control_in().x();
+        double control_out_val = before_val + before->bezier_control_out().y();
+        double control_in_val = after_val + after->bezier_control_in().y();
+
+        // Times only move forward, so each solution is a good guess for the next one
+        double t = 0.0;
+
+        for (int j=i;j<end;j++) {
+          t = Bezier::CubicXtoT(start_dbl + interval_dbl * j, before_time, control_out_time, control_in_time, after_time, t);
+
+          out[j] = static_cast<float>(Bezier::CubicTtoY(before_val, control_out_val, control_in_val, after_val, t));
+        }
+
+      } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
+
+        // Perform a quadratic bezier with only one control point
+        double control_point_time;
+        double control_point_value;
+
+        if (before->type() == NodeKeyframe::kBezier) {
+          control_point_time = before_time + before->bezier_control_out().x();
+          control_point_value = before_val + before->bezier_control_out().y();
+        } else {
+          control_point_time = after_time + after->bezier_control_in().x();
+          control_point_value = after_val + after->bezier_control_in().y();
+        }
+
+        for (int j=i;j<end;j++) {
+          double t = Bezier::QuadraticXtoT(start_dbl + interval_dbl * j, before_time, control_point_time, after_time);
+
+          out[j] = static_cast<float>(Bezier::QuadraticTtoY(before_val, control_point_value, after_val, t));
+        }
+
+      } else {
+
+        // To have arrived here, the keyframes must both be linear
+        double slope = (after_val - before_val) / (after_time - before_time);
+
+        for (int j=i;j<end;j++) {
+          out[j] = static_cast<float>(before_val + slope * (start_dbl + interval_dbl * j - before_time));
+        }
+
+      }
+
+      if (before->time() == time) {
+        // Time == keyframe time, so value is precise
+        out[i] = static_cast<float>(before_val);
+      }
+
+    }
+
+    i = end;
+  }
+}
+
 QList<NodeKeyframePtr> NodeInput::get_keyframe_at_time(const rational &time) const
 {
   QList<NodeKeyframePtr> keys;
@@ -886,10 +1048,41 @@ const QVector<QVariant> &NodeInput::get_split_standard_value() const
   return standard_value_;
 }
 
+QByteArray NodeInput::get_standard_value_bytes() const
+{
+  QMutexLocker locker(&standard_value_bytes_lock_);
+
+  if (standard_value_bytes_.isNull()) {
+    standard_value_bytes_ = ValueToBytes(data_type(), get_standard_value());
+
+    // Distinguish "not cached" from a value that converts to no bytes
+    if (standard_value_bytes_.isNull()) {
+      standard_value_bytes_ = QByteArray("");
+    }
+  }
+
+  return standard_value_bytes_;
+}
+
+bool NodeInput::is_animated() const
+{
+  for (int i=0;i<get_number_of_keyframe_tracks();i++) {
+    if (!is_using_standard_value(i)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 void NodeInput::set_standard_value(const QVariant &value, int track)
 {
   standard_value_.replace(track, value);
 
+  standard_value_bytes_lock_.lock();
+  standard_value_bytes_.clear();
+  standard_value_bytes_lock_.unlock();
+
   if (is_using_standard_value(track)) {
     // If this standard value is being used, we need to send a value changed signal
     emit ValueChanged(RATIONAL_MIN, RATIONAL_MAX);
@@ -913,6 +1106,10 @@ void NodeInput::CopyValues(NodeInput *source, NodeInput *dest, bool include_conn
   // Copy standard value
   dest->standard_value_ = source->standard_value_;
 
+  dest->standard_value_bytes_lock_.lock();
+  dest->standard_value_bytes_.clear();
+  dest->standard_value_bytes_lock_.unlock();
+
   // Copy keyframes
   for (int i=0;i<source->keyframe_tracks_.size();i++) {
     dest->keyframe_tracks_[i].clear();
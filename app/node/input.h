@@ -21,6 +21,8 @@
 #ifndef NODEINPUT_H
 #define NODEINPUT_H
 
+#include <QMutex>
+
 #include "common/timerange.h"
 #include "keyframe.h"
 #include "param.h"
@@ -103,6 +105,16 @@ public:
    */
   QVariant get_value_at_time_for_track(const rational& time, int track) const;
 
+  /**
+   * @brief Render a numeric track's values at regular intervals
+   *
+   * Writes `count` values to `out`, the first at `start` and each following one `interval` after the last. Produces
+   * the same values as calling get_value_at_time_for_track() for each time (to within the Bezier solver's tolerance),
+   * but finds the first keyframe with a binary search and then walks forward through the track, reusing each Bezier
+   * solution as the starting point for the next.
+   */
+  void get_values_at_interval_for_track(const rational& start, const rational& interval, int count, int track, float* out) const;
+
   /**
    * @brief Retrieve a list of keyframe objects for all tracks at a given time
    *
@@ -203,6 +215,18 @@ public:
    */
   const QVector<QVariant>& get_split_standard_value() const;
 
+  /**
+   * @brief Get non-keyframed value converted to bytes for hashing
+   *
+   * The result is cached until the standard value changes. Thread-safe.
+   */
+  QByteArray get_standard_value_bytes() const;
+
+  /**
+   * @brief Return whether this input's value changes over time, i.e. keyframing is enabled and there are keyframes
+   */
+  bool is_animated() const;
+
   /**
    * @brief Set non-keyframed value
    */
@@ -296,6 +320,15 @@ private:
    */
   static bool type_can_be_interpolated(DataType type);
 
+  /**
+   * @brief Returns the index of the first time in `start + interval * index` that's after `time`
+   *
+   * If `inclusive` is false, returns the index of the first time that's at or after `time` instead.
+   */
+  static int GetIndexAfterTime(const rational& start, const rational& interval, const rational& time, bool inclusive);
+
+  static void FillValues(float* out, int start, int end, float value);
+
   /**
    * @brief We use Qt signals/slots for keyframe communication but store them as shared ptrs. This function converts
    * a raw ptr to a list index
@@ -349,6 +382,13 @@ private:
    */
   QVector<QVariant> standard_value_;
 
+  /**
+   * @brief Cached result of get_standard_value_bytes()
+   */
+  mutable QByteArray standard_value_bytes_;
+
+  mutable QMutex standard_value_bytes_lock_;
+
   /**
    * @brief Internal keyframe array
    *
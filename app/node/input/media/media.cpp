@@ -63,7 +63,7 @@ NodeValueTable MediaInput::Value(NodeValueDatabase &value) const
     rational media_duration = Timecode::timestamp_to_time(connected_footage_->duration(),
                                                           connected_footage_->timebase());
 
-    table.Push(NodeInput::kRational, QVariant::fromValue(media_duration), "length");
+    table.Push(NodeInput::kRational, QVariant::fromValue(media_duration), NodeValue::kTagLength);
   }
 
   // Push buffer to the top of the stack
@@ -51,12 +51,17 @@ QString TimeInput::Description() const
   return tr("Generates the time (in seconds) at this frame");
 }
 
+bool TimeInput::IsTimeDependent() const
+{
+  return true;
+}
+
 NodeValueTable TimeInput::Value(NodeValueDatabase &value) const
 {
   NodeValueTable table = value.Merge();
 
   table.Push(NodeParam::kFloat,
-             value[QStringLiteral("global")].Get(NodeParam::kFloat, QStringLiteral("time_in")),
+             value[QStringLiteral("global")].Get(NodeParam::kFloat, NodeValue::kTagTimeIn),
              QStringLiteral("time"));
 
   return table;
@@ -38,6 +38,8 @@ public:
   virtual QString Category() const override;
   virtual QString Description() const override;
 
+  virtual bool IsTimeDependent() const override;
+
   virtual NodeValueTable Value(NodeValueDatabase& value) const override;
 
 };
@@ -349,15 +349,57 @@ NodeInput *MathNode::ProcessesSamplesFrom(const NodeValueDatabase &value) const
   return nullptr;
 }
 
-void MathNode::ProcessSamples(const NodeValueDatabase &values, const AudioRenderingParams &params, const SampleBufferPtr input, SampleBufferPtr output, int index) const
+void MathNode::ProcessSamples(const NodeValueDatabase &values, const SampleAutomationMap& automation, const AudioRenderingParams &params, const SampleBufferPtr input, SampleBufferPtr output) const
 {
   // This function is only used for sample+number pairing
   NodeInput* number_input = (ProcessesSamplesFrom(values) == param_a_in_) ? param_b_in_ : param_a_in_;
-  NodeValue number_val = values[number_input].GetWithMeta(NodeParam::kNumber);
-  float number_flt = RetrieveNumber(number_val);
+  SampleAutomation number = automation.value(number_input);
+  int sample_count = input->sample_count_per_channel();
+
+  // Expand constants so every operation below is a straight loop over two arrays
+  QVector<float> number_fill;
+  const float* number_val;
+
+  if (number.is_constant()) {
+    number_fill.fill(number.constant(), sample_count);
+    number_val = number_fill.constData();
+  } else {
+    number_val = number.curve();
+  }
+
+  Operation op = GetOperation();
 
   for (int i=0;i<params.channel_count();i++) {
-    output->data()[i][index] = PerformAll<float, float>(input->data()[i][index], number_flt);
+    const float* in = input->data()[i];
+    float* out = output->data()[i];
+
+    switch (op) {
+    case kOpAdd:
+      for (int j=0;j<sample_count;j++) {
+        out[j] = in[j] + number_val[j];
+      }
+      break;
+    case kOpSubtract:
+      for (int j=0;j<sample_count;j++) {
+        out[j] = in[j] - number_val[j];
+      }
+      break;
+    case kOpMultiply:
+      for (int j=0;j<sample_count;j++) {
+        out[j] = in[j] * number_val[j];
+      }
+      break;
+    case kOpDivide:
+      for (int j=0;j<sample_count;j++) {
+        out[j] = in[j] / number_val[j];
+      }
+      break;
+    case kOpPower:
+      for (int j=0;j<sample_count;j++) {
+        out[j] = qPow(in[j], number_val[j]);
+      }
+      break;
+    }
   }
 }
 
@@ -48,7 +48,7 @@ public:
   virtual NodeValueTable Value(NodeValueDatabase &value) const override;
 
   virtual NodeInput* ProcessesSamplesFrom(const NodeValueDatabase &value) const override;
-  virtual void ProcessSamples(const NodeValueDatabase &values, const AudioRenderingParams& params, const SampleBufferPtr input, SampleBufferPtr output, int index) const override;
+  virtual void ProcessSamples(const NodeValueDatabase &values, const SampleAutomationMap& automation, const AudioRenderingParams& params, const SampleBufferPtr input, SampleBufferPtr output) const override;
 
   NodeInput* param_a_in() const;
   NodeInput* param_b_in() const;
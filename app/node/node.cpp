@@ -23,6 +23,7 @@
 #include <QApplication>
 #include <QDebug>
 #include <QFile>
+#include <QHash>
 
 #include "common/xmlutils.h"
 
@@ -157,6 +158,8 @@ void Node::InvalidateCache(const rational &start_range, const rational &end_rang
 {
   Q_UNUSED(from)
 
+  ClearCachedHash();
+
   SendInvalidateCache(start_range, end_range);
 }
 
@@ -198,6 +201,10 @@ void Node::SendInvalidateCache(const rational &start_range, const rational &end_
         NodeInput* connected_input = edge->input();
         Node* connected_node = connected_input->parentNode();
 
+        // Some overrides only relay invalidations within their own range, but any upstream change makes a memoized
+        // hash stale regardless
+        connected_node->ClearCachedHash();
+
         // Send clear cache signal to the Node
         connected_node->InvalidateCache(start_range, end_range, connected_input);
       }
@@ -300,7 +307,7 @@ void Node::CopyInputs(Node *source, Node *destination, bool include_connections)
   }
 }
 
-void DuplicateConnectionsBetweenListsInternal(const QList<Node *> &source, const QList<Node *> &destination, NodeInput* source_input, NodeInput* dest_input)
+void DuplicateConnectionsBetweenListsInternal(const QHash<Node *, Node *> &copies, NodeInput* source_input, NodeInput* dest_input)
 {
   if (source_input->IsConnected()) {
     // Get this input's connected outputs
@@ -308,7 +315,7 @@ void DuplicateConnectionsBetweenListsInternal(const QList<Node *> &source, const
     Node* source_output_node = source_output->parentNode();
 
     // Find equivalent in destination list
-    Node* dest_output_node = destination.at(source.indexOf(source_output_node));
+    Node* dest_output_node = copies.value(source_output_node);
 
     Q_ASSERT(dest_output_node->id() == source_output_node->id());
 
@@ -323,7 +330,7 @@ void DuplicateConnectionsBetweenListsInternal(const QList<Node *> &source, const
     NodeInputArray* dest_array = static_cast<NodeInputArray*>(dest_input);
 
     for (int i=0;i<source_array->GetSize();i++) {
-      DuplicateConnectionsBetweenListsInternal(source, destination, source_array->At(i), dest_array->At(i));
+      DuplicateConnectionsBetweenListsInternal(copies, source_array->At(i), dest_array->At(i));
     }
   }
 }
@@ -332,6 +339,14 @@ void Node::DuplicateConnectionsBetweenLists(const QList<Node *> &source, const Q
 {
   Q_ASSERT(source.size() == destination.size());
 
+  // Map each node to its equivalent so connections can be looked up without searching the lists
+  QHash<Node*, Node*> copies;
+  copies.reserve(source.size());
+
+  for (int i=0;i<source.size();i++) {
+    copies.insert(source.at(i), destination.at(i));
+  }
+
   for (int i=0;i<source.size();i++) {
     Node* source_input_node = source.at(i);
     Node* dest_input_node = destination.at(i);
@@ -345,7 +360,7 @@ void Node::DuplicateConnectionsBetweenLists(const QList<Node *> &source, const Q
         NodeInput* source_input = static_cast<NodeInput*>(source_param);
         NodeInput* dest_input = static_cast<NodeInput*>(dest_input_node->params_.at(j));
 
-        DuplicateConnectionsBetweenListsInternal(source, destination, source_input, dest_input);
+        DuplicateConnectionsBetweenListsInternal(copies, source_input, dest_input);
       }
     }
   }
@@ -371,6 +386,25 @@ bool Node::IsTrack() const
   return false;
 }
 
+bool Node::IsTimeDependent() const
+{
+  return false;
+}
+
+QByteArray Node::GetCachedHash() const
+{
+  QMutexLocker locker(&cached_hash_lock_);
+
+  return cached_hash_;
+}
+
+void Node::SetCachedHash(const QByteArray &hash) const
+{
+  QMutexLocker locker(&cached_hash_lock_);
+
+  cached_hash_ = hash;
+}
+
 const QList<NodeParam *>& Node::parameters() const
 {
   return params_;
@@ -484,7 +518,7 @@ NodeInput* Node::ProcessesSamplesFrom(const NodeValueDatabase &value) const
   return nullptr;
 }
 
-void Node::ProcessSamples(const NodeValueDatabase &, const AudioRenderingParams&, const SampleBufferPtr, SampleBufferPtr, int) const
+void Node::ProcessSamples(const NodeValueDatabase &, const SampleAutomationMap &, const AudioRenderingParams&, const SampleBufferPtr, SampleBufferPtr) const
 {
 }
 
@@ -674,13 +708,28 @@ void Node::DisconnectInput(NodeInput *input)
   disconnect(input, &NodeInput::EdgeRemoved, this, &Node::InputConnectionChanged);
 }
 
+void Node::ClearCachedHash()
+{
+  QMutexLocker locker(&cached_hash_lock_);
+
+  cached_hash_.clear();
+}
+
 void Node::InputChanged(rational start, rational end)
 {
-  InvalidateCache(start, end, static_cast<NodeInput*>(sender()));
+  NodeInput* input = static_cast<NodeInput*>(sender());
+
+  ClearCachedHash();
+
+  emit InputValueChanged(input);
+
+  InvalidateCache(start, end, input);
 }
 
 void Node::InputConnectionChanged(NodeEdgePtr edge)
 {
+  ClearCachedHash();
+
   DependentEdgeChanged(edge->input());
 
   InvalidateCache(RATIONAL_MIN, RATIONAL_MAX, static_cast<NodeInput*>(sender()));
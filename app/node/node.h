@@ -22,6 +22,7 @@
 #define NODE_H
 
 #include <QCryptographicHash>
+#include <QMutex>
 #include <QObject>
 #include <QPointF>
 #include <QXmlStreamWriter>
@@ -33,6 +34,7 @@
 #include "node/input.h"
 #include "node/inputarray.h"
 #include "node/output.h"
+#include "node/sampleautomation.h"
 #include "node/value.h"
 #include "render/audioparams.h"
 
@@ -191,9 +193,12 @@ public:
   virtual NodeInput* ProcessesSamplesFrom(const NodeValueDatabase &value) const;
 
   /**
-   * @brief If ProcessesSamples() is true, this is the function that will process them.
+   * @brief If ProcessesSamplesFrom() returns an input, this is the function that will process its samples
+   *
+   * Called once for the whole buffer. `automation` contains the value of every numeric input at each sample so
+   * keyframes and connected inputs remain sample-accurate.
    */
-  virtual void ProcessSamples(const NodeValueDatabase &values, const AudioRenderingParams& params, const SampleBufferPtr input, SampleBufferPtr output, int index) const;
+  virtual void ProcessSamples(const NodeValueDatabase &values, const SampleAutomationMap& automation, const AudioRenderingParams& params, const SampleBufferPtr input, SampleBufferPtr output) const;
 
   /**
    * @brief Returns the parameter with the specified ID (or nullptr if it doesn't exist)
@@ -319,6 +324,29 @@ public:
    */
   virtual bool IsTrack() const;
 
+  /**
+   * @brief Returns whether this Node's output can change over time even if none of its inputs do
+   *
+   * Nodes that use the current time directly (rather than through keyframes or upstream nodes) should override this
+   * and return true. The renderer uses this to determine which parts of the graph have hashes that can be memoized.
+   */
+  virtual bool IsTimeDependent() const;
+
+  /**
+   * @brief Retrieve the hash of this Node and everything upstream of it stored with SetCachedHash()
+   *
+   * Returns an empty QByteArray if no hash has been stored. The stored hash is cleared automatically whenever this
+   * Node or anything upstream of it is invalidated. Thread-safe.
+   */
+  QByteArray GetCachedHash() const;
+
+  /**
+   * @brief Store the hash of this Node and everything upstream of it
+   *
+   * Should only be used for hashes that are valid at any time. Thread-safe.
+   */
+  void SetCachedHash(const QByteArray& hash) const;
+
   /**
    * @brief The main processing function
    *
@@ -387,6 +415,13 @@ signals:
    */
   void EdgeRemoved(NodeEdgePtr edge);
 
+  /**
+   * @brief Signal emitted when the value (standard value or keyframes) of one of this node's inputs has changed
+   *
+   * For array inputs, `input` is the array rather than the element that changed.
+   */
+  void InputValueChanged(NodeInput* input);
+
 private:
   /**
    * @brief Add a parameter to this node
@@ -407,6 +442,8 @@ private:
 
   static void GetDependenciesInternal(const Node* n, QList<Node*>& list, bool traverse, bool exclusive_only);
 
+  void ClearCachedHash();
+
   QList<NodeParam *> params_;
 
   /**
@@ -424,6 +461,13 @@ private:
    */
   QPointF position_;
 
+  /**
+   * @brief Memoized hash of this Node's subgraph (see GetCachedHash())
+   */
+  mutable QByteArray cached_hash_;
+
+  mutable QMutex cached_hash_lock_;
+
 private slots:
   void InputChanged(rational start, rational end);
 
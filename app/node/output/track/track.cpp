@@ -20,6 +20,7 @@
 
 #include "track.h"
 
+#include <algorithm>
 #include <QApplication>
 #include <QDebug>
 #include <QFontMetrics>
@@ -132,11 +133,13 @@ void TrackOutput::SetIndex(const int &index)
 
 Block *TrackOutput::BlockContainingTime(const rational &time) const
 {
-  foreach (Block* block, block_cache_) {
-    if (block->in() < time && block->out() > time) {
+  int index = IndexOfFirstBlockEndingAfter(time);
+
+  if (index < sorted_blocks_.size()) {
+    Block* block = sorted_blocks_.at(index);
+
+    if (block->in() < time) {
       return block;
-    } else if (block->out() == time) {
-      break;
     }
   }
 
@@ -145,50 +148,49 @@ Block *TrackOutput::BlockContainingTime(const rational &time) const
 
 Block *TrackOutput::NearestBlockBefore(const rational &time) const
 {
-  foreach (Block* block, block_cache_) {
-    // Blocks are sorted by time, so the first Block who's out point is at/after this time is the correct Block
-    if (block->out() >= time) {
-      return block;
-    }
-  }
+  // Blocks are sorted by time, so the first Block who's out point is at/after this time is the correct Block
+  QVector<Block*>::const_iterator it = std::lower_bound(sorted_blocks_.constBegin(),
+                                                        sorted_blocks_.constEnd(),
+                                                        time,
+                                                        [](const Block* block, const rational& t){
+    return block->out() < t;
+  });
 
-  return nullptr;
+  return (it == sorted_blocks_.constEnd()) ? nullptr : *it;
 }
 
 Block *TrackOutput::NearestBlockBeforeOrAt(const rational &time) const
 {
-  foreach (Block* block, block_cache_) {
-    // Blocks are sorted by time, so the first Block who's out point is at/after this time is the correct Block
-    if (block->out() > time) {
-      return block;
-    }
-  }
+  // Blocks are sorted by time, so the first Block who's out point is after this time is the correct Block
+  int index = IndexOfFirstBlockEndingAfter(time);
 
-  return nullptr;
+  return (index < sorted_blocks_.size()) ? sorted_blocks_.at(index) : nullptr;
 }
 
 Block *TrackOutput::NearestBlockAfterOrAt(const rational &time) const
 {
-  foreach (Block* block, block_cache_) {
-    // Blocks are sorted by time, so the first Block after this time is the correct Block
-    if (block->in() >= time) {
-      return block;
-    }
-  }
+  // Blocks are sorted by time, so the first Block after this time is the correct Block
+  QVector<Block*>::const_iterator it = std::lower_bound(sorted_blocks_.constBegin(),
+                                                        sorted_blocks_.constEnd(),
+                                                        time,
+                                                        [](const Block* block, const rational& t){
+    return block->in() < t;
+  });
 
-  return nullptr;
+  return (it == sorted_blocks_.constEnd()) ? nullptr : *it;
 }
 
 Block *TrackOutput::NearestBlockAfter(const rational &time) const
 {
-  foreach (Block* block, block_cache_) {
-    // Blocks are sorted by time, so the first Block after this time is the correct Block
-    if (block->in() > time) {
-      return block;
-    }
-  }
+  // Blocks are sorted by time, so the first Block after this time is the correct Block
+  QVector<Block*>::const_iterator it = std::upper_bound(sorted_blocks_.constBegin(),
+                                                        sorted_blocks_.constEnd(),
+                                                        time,
+                                                        [](const rational& t, const Block* block){
+    return t < block->in();
+  });
 
-  return nullptr;
+  return (it == sorted_blocks_.constEnd()) ? nullptr : *it;
 }
 
 Block *TrackOutput::BlockAtTime(const rational &time) const
@@ -197,15 +199,13 @@ Block *TrackOutput::BlockAtTime(const rational &time) const
     return nullptr;
   }
 
-  foreach (Block* block, block_cache_) {
-    if (block
-        && block->in() <= time
-        && block->out() > time) {
-      if (block->is_enabled()) {
-        return block;
-      } else {
-        break;
-      }
+  int index = IndexOfFirstBlockEndingAfter(time);
+
+  if (index < sorted_blocks_.size()) {
+    Block* block = sorted_blocks_.at(index);
+
+    if (block->in() <= time && block->is_enabled()) {
+      return block;
     }
   }
 
@@ -220,12 +220,14 @@ QList<Block *> TrackOutput::BlocksAtTimeRange(const TimeRange &range) const
     return list;
   }
 
-  foreach (Block* block, block_cache_) {
-    if (block
-        && block->out() > range.in()
-        && block->in() < range.out()) {
-      list.append(block);
+  for (int i=IndexOfFirstBlockEndingAfter(range.in());i<sorted_blocks_.size();i++) {
+    Block* block = sorted_blocks_.at(i);
+
+    if (block->in() >= range.out()) {
+      break;
     }
+
+    list.append(block);
   }
 
   return list;
@@ -455,6 +457,8 @@ void TrackOutput::UpdateInOutFrom(int index)
     }
   }
 
+  RebuildSortedBlocks();
+
   // Update track length
   if (new_track_length != track_length_) {
     rational old_track_length = track_length_;
@@ -467,6 +471,30 @@ void TrackOutput::UpdateInOutFrom(int index)
   }
 }
 
+void TrackOutput::RebuildSortedBlocks()
+{
+  sorted_blocks_.clear();
+  sorted_blocks_.reserve(block_cache_.size());
+
+  foreach (Block* b, block_cache_) {
+    if (b) {
+      sorted_blocks_.append(b);
+    }
+  }
+}
+
+int TrackOutput::IndexOfFirstBlockEndingAfter(const rational &time) const
+{
+  QVector<Block*>::const_iterator it = std::upper_bound(sorted_blocks_.constBegin(),
+                                                        sorted_blocks_.constEnd(),
+                                                        time,
+                                                        [](const rational& t, const Block* block){
+    return t < block->out();
+  });
+
+  return static_cast<int>(it - sorted_blocks_.constBegin());
+}
+
 void TrackOutput::UpdatePreviousAndNextOfIndex(int index)
 {
   Block* ref = block_cache_.at(index);
@@ -561,6 +589,9 @@ void TrackOutput::BlockListSizeChanged(int size)
   for (int i=old_size;i<size;i++) {
     block_cache_.replace(i, nullptr);
   }
+
+  // Shrinking may have dropped blocks that are still in the search index
+  RebuildSortedBlocks();
 }
 
 void TrackOutput::BlockLengthChanged()
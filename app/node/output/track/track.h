@@ -190,8 +190,23 @@ private:
 
   void UpdatePreviousAndNextOfIndex(int index);
 
+  void RebuildSortedBlocks();
+
+  /**
+   * @brief Returns the index in sorted_blocks_ of the first block whose out point is after `time`
+   */
+  int IndexOfFirstBlockEndingAfter(const rational& time) const;
+
   QVector<Block*> block_cache_;
 
+  /**
+   * @brief Every non-null block in block_cache_, used for binary searching by time
+   *
+   * Blocks are laid end to end, so both in and out points are in ascending order. Rebuilt by RebuildSortedBlocks()
+   * whenever block_cache_ changes.
+   */
+  QVector<Block*> sorted_blocks_;
+
   NodeInputArray* block_input_;
 
   NodeInput* muted_input_;
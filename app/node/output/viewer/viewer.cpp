@@ -146,14 +146,14 @@ rational ViewerOutput::Length()
 
   if (texture_input_->IsConnected()) {
     NodeValueTable t = traverser.ProcessNode(NodeDependency(texture_input_->get_connected_node(), 0, 0));
-    video_length = t.Get(NodeParam::kNumber, "length").value<rational>();
+    video_length = t.Get(NodeParam::kNumber, NodeValue::kTagLength).value<rational>();
   }
 
   rational audio_length;
 
   if (samples_input_->IsConnected()) {
     NodeValueTable t = traverser.ProcessNode(NodeDependency(samples_input_->get_connected_node(), 0, 0));
-    audio_length = t.Get(NodeParam::kNumber, "length").value<rational>();
+    audio_length = t.Get(NodeParam::kNumber, NodeValue::kTagLength).value<rational>();
   }
 
   return qMax(video_length, qMax(audio_length, timeline_length_));
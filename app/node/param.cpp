@@ -104,7 +104,7 @@ void NodeParam::SetConnectable(bool connectable)
   connectable_ = connectable;
 }
 
-const QVector<NodeEdgePtr> &NodeParam::edges()
+const QVector<NodeEdgePtr> &NodeParam::edges() const
 {
   return edges_;
 }
@@ -287,7 +287,7 @@ public:
    *
    * This list can't be modified directly. Use ConnectEdge() and DisconnectEdge() instead for that.
    */
-  const QVector<NodeEdgePtr>& edges();
+  const QVector<NodeEdgePtr>& edges() const;
 
   /**
    * @brief Disconnect any edges connecting this parameter to other parameters
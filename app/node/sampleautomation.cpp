@@ -0,0 +1,61 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "sampleautomation.h"
+
+OLIVE_NAMESPACE_ENTER
+
+SampleAutomation::SampleAutomation() :
+  constant_(0.0f)
+{
+}
+
+SampleAutomation::SampleAutomation(float constant) :
+  constant_(constant)
+{
+}
+
+SampleAutomation::SampleAutomation(const QVector<float> &curve) :
+  constant_(curve.isEmpty() ? 0.0f : curve.first()),
+  curve_(curve)
+{
+}
+
+bool SampleAutomation::is_constant() const
+{
+  return curve_.isEmpty();
+}
+
+float SampleAutomation::constant() const
+{
+  return constant_;
+}
+
+const float *SampleAutomation::curve() const
+{
+  return curve_.constData();
+}
+
+float SampleAutomation::at(int sample) const
+{
+  return is_constant() ? constant_ : curve_.at(sample);
+}
+
+OLIVE_NAMESPACE_EXIT
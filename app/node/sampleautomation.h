@@ -0,0 +1,72 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef SAMPLEAUTOMATION_H
+#define SAMPLEAUTOMATION_H
+
+#include <QHash>
+#include <QVector>
+
+#include "node/input.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief The value of a numeric input at each sample of an audio buffer
+ *
+ * Inputs that don't change over the buffer are stored as a single constant so nodes can skip per-sample work
+ * entirely.
+ */
+class SampleAutomation
+{
+public:
+  SampleAutomation();
+  SampleAutomation(float constant);
+  SampleAutomation(const QVector<float>& curve);
+
+  /**
+   * @brief Returns true if this input has the same value at every sample
+   */
+  bool is_constant() const;
+
+  /**
+   * @brief The value at the first sample, which is the value at every sample if is_constant()
+   */
+  float constant() const;
+
+  /**
+   * @brief One value per sample, only valid if !is_constant()
+   */
+  const float* curve() const;
+
+  float at(int sample) const;
+
+private:
+  float constant_;
+
+  QVector<float> curve_;
+
+};
+
+using SampleAutomationMap = QHash<const NodeInput*, SampleAutomation>;
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // SAMPLEAUTOMATION_H
@@ -24,6 +24,11 @@
 
 OLIVE_NAMESPACE_ENTER
 
+NodeTraverser::NodeTraverser() :
+  traversal_depth_(0)
+{
+}
+
 NodeValueDatabase NodeTraverser::GenerateDatabase(const Node* node, const TimeRange &range)
 {
   NodeValueDatabase database;
@@ -48,8 +53,8 @@ NodeValueDatabase NodeTraverser::GenerateDatabase(const Node* node, const TimeRa
 
   // Insert global variables
   NodeValueTable global;
-  global.Push(NodeParam::kFloat, range.in().toDouble(), QStringLiteral("time_in"));
-  global.Push(NodeParam::kFloat, range.out().toDouble(), QStringLiteral("time_out"));
+  global.Push(NodeParam::kFloat, range.in().toDouble(), NodeValue::kTagTimeIn);
+  global.Push(NodeParam::kFloat, range.out().toDouble(), NodeValue::kTagTimeOut);
   database.Insert(QStringLiteral("global"), global);
 
   return database;
@@ -59,24 +64,67 @@ NodeValueTable NodeTraverser::ProcessNode(const NodeDependency& dep)
 {
   const Node* node = dep.node();
 
+  // If this node's output is shared by several inputs, we may have already processed it for this time
+  QHash<const Node*, QHash<TimeRange, NodeValueTable> >::const_iterator node_values = value_cache_.constFind(node);
+
+  if (node_values != value_cache_.constEnd()) {
+    QHash<TimeRange, NodeValueTable>::const_iterator cached = node_values->constFind(dep.range());
+
+    if (cached != node_values->constEnd()) {
+      return cached.value();
+    }
+  }
+
+  traversal_depth_++;
+
+  NodeValueTable table;
+
   if (node->IsTrack()) {
     // If the range is not wholly contained in this Block, we'll need to do some extra processing
-    return RenderBlock(static_cast<const TrackOutput*>(node), dep.range());
-  }
+    table = RenderBlock(static_cast<const TrackOutput*>(node), dep.range());
+  } else {
+    // Generate database of input values of node
+    NodeValueDatabase database = GenerateDatabase(node, dep.range());
 
-  // FIXME: Cache certain values here if we've already processed them before
+    // By this point, the node should have all the inputs it needs to render correctly
+    table = node->Value(database);
 
-  // Generate database of input values of node
-  NodeValueDatabase database = GenerateDatabase(node, dep.range());
+    ProcessNodeEvent(node, dep.range(), database, table);
+  }
 
-  // By this point, the node should have all the inputs it needs to render correctly
-  NodeValueTable table = node->Value(database);
+  traversal_depth_--;
 
-  ProcessNodeEvent(node, dep.range(), database, table);
+  if (traversal_depth_) {
+    // Only keep values that another input is going to ask for, holding onto every texture and sample buffer until
+    // the traversal finishes would just raise its peak memory usage
+    if (!IsCancelled() && OutputIsShared(node)) {
+      value_cache_[node].insert(dep.range(), table);
+    }
+  } else {
+    // The graph may have changed by the next traversal, so values are only reused within this one
+    value_cache_.clear();
+  }
 
   return table;
 }
 
+bool NodeTraverser::OutputIsShared(const Node *node)
+{
+  int edge_count = 0;
+
+  foreach (NodeParam* param, node->parameters()) {
+    if (param->type() == NodeParam::kOutput) {
+      edge_count += param->edges().size();
+
+      if (edge_count > 1) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
 NodeValueTable NodeTraverser::RenderBlock(const TrackOutput *track, const TimeRange &range)
 {
   // By default, don't bother traversing blocks
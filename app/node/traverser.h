@@ -33,8 +33,13 @@ OLIVE_NAMESPACE_ENTER
 class NodeTraverser : public CancelableObject
 {
 public:
-  NodeTraverser() = default;
+  NodeTraverser();
 
+  /**
+   * @brief Process a node and everything it depends on for a certain range of time
+   *
+   * Within one call, each node is only processed once per range no matter how many inputs it's connected to.
+   */
   NodeValueTable ProcessNode(const NodeDependency &dep);
 
 protected:
@@ -48,6 +53,25 @@ protected:
 
   virtual void ProcessNodeEvent(const Node*, const TimeRange&, NodeValueDatabase&, NodeValueTable&){}
 
+private:
+  /**
+   * @brief Returns true if this node's outputs are connected to more than one input
+   */
+  static bool OutputIsShared(const Node* node);
+
+  /**
+   * @brief Values of shared nodes that have already been processed in the current traversal
+   *
+   * Values may be handed to several consumers, so anything in them (e.g. a SampleBuffer) must be copied rather than
+   * modified in place.
+   */
+  QHash<const Node*, QHash<TimeRange, NodeValueTable> > value_cache_;
+
+  /**
+   * @brief How many calls to ProcessNode() deep we are, the cache is cleared when the outermost one returns
+   */
+  int traversal_depth_;
+
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -22,45 +22,124 @@
 
 OLIVE_NAMESPACE_ENTER
 
+QHash<QString, int> NodeValue::tag_ids_;
+QVector<QString> NodeValue::tag_names_;
+QReadWriteLock NodeValue::tag_lock_;
+
+// These must be defined after the tag table above so it's been constructed by the time they're interned
+const int NodeValue::kTagTimeIn = NodeValue::InternTag(QStringLiteral("time_in"));
+const int NodeValue::kTagTimeOut = NodeValue::InternTag(QStringLiteral("time_out"));
+const int NodeValue::kTagLength = NodeValue::InternTag(QStringLiteral("length"));
+
 NodeValueTable& NodeValueDatabase::operator[](const QString &input_id)
 {
-  return tables_[input_id];
+  int index = IndexOf(input_id);
+
+  if (index == -1) {
+    index = tables_.size();
+    tables_.append({nullptr, input_id, NodeValueTable()});
+  }
+
+  return tables_[index].table;
 }
 
 NodeValueTable& NodeValueDatabase::operator[](const NodeInput *input)
 {
-  return tables_[input->id()];
+  int index = IndexOf(input);
+
+  if (index == -1) {
+    index = tables_.size();
+    tables_.append({input, input->id(), NodeValueTable()});
+  }
+
+  return tables_[index].table;
 }
 
 const NodeValueTable NodeValueDatabase::operator[](const QString &input_id) const
 {
-  return tables_[input_id];
+  int index = IndexOf(input_id);
+
+  if (index == -1) {
+    return NodeValueTable();
+  }
+
+  return tables_.at(index).table;
 }
 
 const NodeValueTable NodeValueDatabase::operator[](const NodeInput *input) const
 {
-  return tables_[input->id()];
+  int index = IndexOf(input);
+
+  if (index == -1) {
+    return NodeValueTable();
+  }
+
+  return tables_.at(index).table;
 }
 
 void NodeValueDatabase::Insert(const QString &key, const NodeValueTable &value)
 {
-  tables_.insert(key, value);
+  operator[](key) = value;
 }
 
 void NodeValueDatabase::Insert(const NodeInput *key, const NodeValueTable &value)
 {
-  tables_.insert(key->id(), value);
+  operator[](key) = value;
 }
 
 NodeValueTable NodeValueDatabase::Merge() const
 {
-  return NodeValueTable::Merge(tables_.values());
+  QList<NodeValueTable> tables;
+
+  tables.reserve(tables_.size());
+
+  foreach (const Entry& e, tables_) {
+    tables.append(e.table);
+  }
+
+  return NodeValueTable::Merge(tables);
+}
+
+int NodeValueDatabase::IndexOf(const QString &input_id) const
+{
+  for (int i=0;i<tables_.size();i++) {
+    if (tables_.at(i).id == input_id) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+int NodeValueDatabase::IndexOf(const NodeInput *input) const
+{
+  for (int i=0;i<tables_.size();i++) {
+    if (tables_.at(i).input == input) {
+      return i;
+    }
+  }
+
+  // The table may have been inserted by ID, or by an equivalent input on a copy of this node
+  return IndexOf(input->id());
+}
+
+NodeValue::NodeValue() :
+  type_(NodeParam::kNone),
+  tag_(0)
+{
 }
 
 NodeValue::NodeValue(const NodeParam::DataType &type, const QVariant &data, const QString &tag) :
   type_(type),
   data_(data),
-  tag_(tag)
+  tag_(InternTag(tag))
+{
+}
+
+NodeValue::NodeValue(const NodeParam::DataType &type, const QVariant &data, int tag_id) :
+  type_(type),
+  data_(data),
+  tag_(tag_id)
 {
 }
 
@@ -69,7 +148,18 @@ const NodeParam::DataType &NodeValue::type() const
   return type_;
 }
 
-const QString &NodeValue::tag() const
+QString NodeValue::tag() const
+{
+  if (!tag_) {
+    return QString();
+  }
+
+  QReadLocker locker(&tag_lock_);
+
+  return tag_names_.at(tag_ - 1);
+}
+
+const int &NodeValue::tag_id() const
 {
   return tag_;
 }
@@ -79,6 +169,37 @@ bool NodeValue::operator==(const NodeValue &rhs) const
   return type_ == rhs.type_ && tag_ == rhs.tag_ && data_ == rhs.data_;
 }
 
+int NodeValue::InternTag(const QString &tag)
+{
+  int id = FindTag(tag);
+
+  if (id == -1) {
+    QWriteLocker locker(&tag_lock_);
+
+    // Another thread may have added this tag while we were waiting for the lock
+    id = tag_ids_.value(tag, -1);
+
+    if (id == -1) {
+      tag_names_.append(tag);
+      id = tag_names_.size();
+      tag_ids_.insert(tag, id);
+    }
+  }
+
+  return id;
+}
+
+int NodeValue::FindTag(const QString &tag)
+{
+  if (tag.isEmpty()) {
+    return 0;
+  }
+
+  QReadLocker locker(&tag_lock_);
+
+  return tag_ids_.value(tag, -1);
+}
+
 const QVariant &NodeValue::data() const
 {
   return data_;
@@ -86,12 +207,22 @@ const QVariant &NodeValue::data() const
 
 QVariant NodeValueTable::Get(const NodeParam::DataType &type, const QString &tag) const
 {
-  return GetWithMeta(type, tag).data();
+  return Get(type, NodeValue::FindTag(tag));
+}
+
+QVariant NodeValueTable::Get(const NodeParam::DataType &type, int tag_id) const
+{
+  return GetWithMeta(type, tag_id).data();
 }
 
 NodeValue NodeValueTable::GetWithMeta(const NodeParam::DataType &type, const QString &tag) const
 {
-  int value_index = GetInternal(type, tag);
+  return GetWithMeta(type, NodeValue::FindTag(tag));
+}
+
+NodeValue NodeValueTable::GetWithMeta(const NodeParam::DataType &type, int tag_id) const
+{
+  int value_index = GetInternal(type, tag_id);
 
   if (value_index >= 0) {
     return values_.at(value_index);
@@ -102,15 +233,25 @@ NodeValue NodeValueTable::GetWithMeta(const NodeParam::DataType &type, const QSt
 
 QVariant NodeValueTable::Take(const NodeParam::DataType &type, const QString &tag)
 {
-  return TakeWithMeta(type, tag).data();
+  return Take(type, NodeValue::FindTag(tag));
+}
+
+QVariant NodeValueTable::Take(const NodeParam::DataType &type, int tag_id)
+{
+  return TakeWithMeta(type, tag_id).data();
 }
 
 NodeValue NodeValueTable::TakeWithMeta(const NodeParam::DataType &type, const QString &tag)
 {
-  int value_index = GetInternal(type, tag);
+  return TakeWithMeta(type, NodeValue::FindTag(tag));
+}
+
+NodeValue NodeValueTable::TakeWithMeta(const NodeParam::DataType &type, int tag_id)
+{
+  int value_index = GetInternal(type, tag_id);
 
   if (value_index >= 0) {
-    return values_.takeAt(value_index);
+    return TakeAt(value_index);
   }
 
   return NodeValue(NodeParam::kNone, QVariant());
@@ -126,6 +267,11 @@ void NodeValueTable::Push(const NodeParam::DataType &type, const QVariant &data,
   Push(NodeValue(type, data, tag));
 }
 
+void NodeValueTable::Push(const NodeParam::DataType &type, const QVariant &data, int tag_id)
+{
+  Push(NodeValue(type, data, tag_id));
+}
+
 void NodeValueTable::Prepend(const NodeValue &value)
 {
   values_.prepend(value);
@@ -136,6 +282,11 @@ void NodeValueTable::Prepend(const NodeParam::DataType &type, const QVariant &da
   Prepend(NodeValue(type, data, tag));
 }
 
+void NodeValueTable::Prepend(const NodeParam::DataType &type, const QVariant &data, int tag_id)
+{
+  Prepend(NodeValue(type, data, tag_id));
+}
+
 const NodeValue &NodeValueTable::At(int index) const
 {
   return values_.at(index);
@@ -143,7 +294,11 @@ const NodeValue &NodeValueTable::At(int index) const
 
 NodeValue NodeValueTable::TakeAt(int index)
 {
-  return values_.takeAt(index);
+  NodeValue v = values_.at(index);
+
+  values_.remove(index);
+
+  return v;
 }
 
 int NodeValueTable::Count() const
@@ -170,7 +325,7 @@ void NodeValueTable::Remove(const NodeValue &v)
     const NodeValue& compare = values_.at(i);
 
     if (compare == v) {
-      values_.removeAt(i);
+      values_.remove(i);
       return;
     }
   }
@@ -208,7 +363,7 @@ NodeValueTable NodeValueTable::Merge(QList<NodeValueTable> tables)
   return merged_table;
 }
 
-int NodeValueTable::GetInternal(const NodeParam::DataType &type, const QString &tag) const
+int NodeValueTable::GetInternal(const NodeParam::DataType &type, int tag_id) const
 {
   int index = -1;
 
@@ -218,7 +373,9 @@ int NodeValueTable::GetInternal(const NodeParam::DataType &type, const QString &
     if (v.type() & type) {
       index = i;
 
-      if (tag.isEmpty() || tag == v.tag()) {
+      // Stop at the most recent value with a matching tag. If none match (a tag of -1 was never used, so it never
+      // will), we keep going and end up with the earliest pushed value of this type.
+      if (!tag_id || tag_id == v.tag_id()) {
         break;
       }
     }
@@ -21,7 +21,9 @@
 #ifndef VALUE_H
 #define VALUE_H
 
+#include <QReadWriteLock>
 #include <QString>
+#include <QVector>
 
 #include "input.h"
 
@@ -30,19 +32,49 @@ OLIVE_NAMESPACE_ENTER
 class NodeValue
 {
 public:
-  NodeValue() = default;
+  NodeValue();
   NodeValue(const NodeParam::DataType& type, const QVariant& data, const QString& tag = QString());
+  NodeValue(const NodeParam::DataType& type, const QVariant& data, int tag_id);
 
   const NodeParam::DataType& type() const;
   const QVariant& data() const;
-  const QString& tag() const;
+  QString tag() const;
+
+  /**
+   * @brief The interned ID of tag(), which is what tags are compared by
+   */
+  const int& tag_id() const;
 
   bool operator==(const NodeValue& rhs) const;
 
+  /**
+   * @brief Returns the ID for a tag, assigning it one if it's never been used before
+   *
+   * The empty tag is always 0. IDs are shared by the whole application and never change, so they can be looked up once
+   * and stored.
+   */
+  static int InternTag(const QString& tag);
+
+  /**
+   * @brief Returns the ID for a tag without assigning one, or -1 if no value has ever been tagged with it
+   */
+  static int FindTag(const QString& tag);
+
+  /**
+   * @brief Tags used by built-in nodes, interned up front so they can be used without any lookup
+   */
+  static const int kTagTimeIn;
+  static const int kTagTimeOut;
+  static const int kTagLength;
+
 private:
   NodeParam::DataType type_;
   QVariant data_;
-  QString tag_;
+  int tag_;
+
+  static QHash<QString, int> tag_ids_;
+  static QVector<QString> tag_names_;
+  static QReadWriteLock tag_lock_;
 
 };
 
@@ -51,14 +83,26 @@ class NodeValueTable
 public:
   NodeValueTable() = default;
 
+  /**
+   * @brief Returns the most recently pushed value of this type with this tag
+   *
+   * If no value has this tag, the earliest pushed value of this type is returned instead. The overloads taking a tag ID
+   * (see NodeValue::InternTag()) skip looking the tag up, which is preferable on hot paths.
+   */
   QVariant Get(const NodeParam::DataType& type, const QString& tag = QString()) const;
+  QVariant Get(const NodeParam::DataType& type, int tag_id) const;
   NodeValue GetWithMeta(const NodeParam::DataType& type, const QString& tag = QString()) const;
+  NodeValue GetWithMeta(const NodeParam::DataType& type, int tag_id) const;
   QVariant Take(const NodeParam::DataType& type, const QString& tag = QString());
+  QVariant Take(const NodeParam::DataType& type, int tag_id);
   NodeValue TakeWithMeta(const NodeParam::DataType& type, const QString& tag = QString());
+  NodeValue TakeWithMeta(const NodeParam::DataType& type, int tag_id);
   void Push(const NodeValue& value);
   void Push(const NodeParam::DataType& type, const QVariant& data, const QString& tag = QString());
+  void Push(const NodeParam::DataType& type, const QVariant& data, int tag_id);
   void Prepend(const NodeValue& value);
   void Prepend(const NodeParam::DataType& type, const QVariant& data, const QString& tag = QString());
+  void Prepend(const NodeParam::DataType& type, const QVariant& data, int tag_id);
   const NodeValue& At(int index) const;
   NodeValue TakeAt(int index);
   int Count() const;
@@ -70,12 +114,18 @@ public:
   static NodeValueTable Merge(QList<NodeValueTable> tables);
 
 private:
-  int GetInternal(const NodeParam::DataType& type, const QString& tag) const;
+  int GetInternal(const NodeParam::DataType& type, int tag_id) const;
 
-  QList<NodeValue> values_;
+  QVector<NodeValue> values_;
 
 };
 
+/**
+ * @brief The tables of values received by each of a node's inputs
+ *
+ * A node only has a handful of inputs, so tables are kept in a flat list in the order they were inserted and found by
+ * comparing input pointers rather than hashing input IDs.
+ */
 class NodeValueDatabase
 {
 public:
@@ -93,7 +143,16 @@ public:
   NodeValueTable Merge() const;
 
 private:
-  QHash<QString, NodeValueTable> tables_;
+  struct Entry {
+    const NodeInput* input;
+    QString id;
+    NodeValueTable table;
+  };
+
+  int IndexOf(const QString& input_id) const;
+  int IndexOf(const NodeInput* input) const;
+
+  QVector<Entry> tables_;
 
 };
 
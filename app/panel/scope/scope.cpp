@@ -89,7 +89,7 @@ void ScopePanel::DrewManagedTexture(OpenGLTexture *texture)
   waveform_view_->SetTexture(texture);
 }
 
-void ScopePanel::SetBuffer(Frame *frame)
+void ScopePanel::SetBuffer(FramePtr frame)
 {
   histogram_->SetBuffer(frame);
 }
@@ -52,7 +52,7 @@ public:
 public slots:
   void DrewManagedTexture(OpenGLTexture* texture);
 
-  void SetBuffer(Frame* frame);
+  void SetBuffer(FramePtr frame);
 
   void SetColorProcessor(ColorProcessorPtr processor);
 
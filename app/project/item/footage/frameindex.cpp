@@ -0,0 +1,261 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "frameindex.h"
+
+#include <algorithm>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+OLIVE_NAMESPACE_ENTER
+
+const quint32 kFrameIndexMagic = 0x5846494F; // "OIFX"
+
+const quint32 kFrameIndexVersion = 1;
+
+const int kFrameIndexHeaderSize = 13;
+
+FrameIndex::FrameIndex() :
+  complete_(false)
+{
+}
+
+void FrameIndex::Append(int64_t timestamp, int64_t position, bool keyframe)
+{
+  // Packets arrive in decode order so anything out of order is only ever a few frames from the end
+  int insert = timestamps_.size();
+
+  while (insert > 0 && timestamps_.at(insert - 1) > timestamp) {
+    insert--;
+  }
+
+  timestamps_.insert(insert, timestamp);
+  positions_.insert(insert, position);
+
+  // Shift keyframes after this entry along and slot this one in if necessary
+  int key_insert = keyframes_.size();
+
+  while (key_insert > 0 && keyframes_.at(key_insert - 1) >= insert) {
+    key_insert--;
+    keyframes_[key_insert]++;
+  }
+
+  if (keyframe) {
+    keyframes_.insert(key_insert, insert);
+  }
+}
+
+void FrameIndex::SetComplete()
+{
+  complete_ = true;
+}
+
+bool FrameIndex::is_complete() const
+{
+  return complete_;
+}
+
+bool FrameIndex::isEmpty() const
+{
+  return timestamps_.isEmpty();
+}
+
+int FrameIndex::count() const
+{
+  return timestamps_.size();
+}
+
+int64_t FrameIndex::timestamp(int index) const
+{
+  return timestamps_.at(index);
+}
+
+int64_t FrameIndex::position(int index) const
+{
+  return positions_.at(index);
+}
+
+int64_t FrameIndex::last_timestamp() const
+{
+  return timestamps_.last();
+}
+
+int FrameIndex::FindFrame(int64_t timestamp) const
+{
+  QVector<int64_t>::const_iterator i = std::upper_bound(timestamps_.constBegin(), timestamps_.constEnd(), timestamp);
+
+  return static_cast<int>(i - timestamps_.constBegin()) - 1;
+}
+
+int FrameIndex::FindKeyframe(int index) const
+{
+  if (index < 0) {
+    return -1;
+  }
+
+  QVector<int>::const_iterator i = std::upper_bound(keyframes_.constBegin(), keyframes_.constEnd(), index);
+
+  if (i == keyframes_.constBegin()) {
+    return -1;
+  }
+
+  return *(i - 1);
+}
+
+bool FrameIndex::Save(const QString &filename) const
+{
+  QByteArray bytes(kFrameIndexHeaderSize, Qt::Uninitialized);
+  uchar* header = reinterpret_cast<uchar*>(bytes.data());
+
+  qToLittleEndian(kFrameIndexMagic, header);
+  qToLittleEndian(kFrameIndexVersion, header + 4);
+  qToLittleEndian(static_cast<quint32>(timestamps_.size()), header + 8);
+  header[12] = complete_ ? 1 : 0;
+
+  // Worst case for both varints
+  bytes.reserve(bytes.size() + timestamps_.size() * 20);
+
+  int64_t last_ts = 0;
+  int64_t last_pos = 0;
+  int next_key = 0;
+
+  for (int i=0;i<timestamps_.size();i++) {
+    bool key = (next_key < keyframes_.size() && keyframes_.at(next_key) == i);
+
+    if (key) {
+      next_key++;
+    }
+
+    // Zigzag so small negative deltas stay small, the timestamp's lowest bit is the keyframe flag
+    quint64 values[2];
+
+    int64_t ts_delta = timestamps_.at(i) - last_ts;
+    int64_t pos_delta = positions_.at(i) - last_pos;
+
+    values[0] = (((static_cast<quint64>(ts_delta) << 1) ^ static_cast<quint64>(ts_delta >> 63)) << 1) | (key ? 1 : 0);
+    values[1] = (static_cast<quint64>(pos_delta) << 1) ^ static_cast<quint64>(pos_delta >> 63);
+
+    for (int j=0;j<2;j++) {
+      quint64 v = values[j];
+
+      while (v >= 0x80) {
+        bytes.append(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+      }
+
+      bytes.append(static_cast<char>(v));
+    }
+
+    last_ts = timestamps_.at(i);
+    last_pos = positions_.at(i);
+  }
+
+  QSaveFile file(filename);
+
+  if (!file.open(QFile::WriteOnly)) {
+    return false;
+  }
+
+  file.write(bytes);
+
+  return file.commit();
+}
+
+FrameIndexPtr FrameIndex::Load(const QString &filename)
+{
+  QFile file(filename);
+
+  if (!file.open(QFile::ReadOnly)) {
+    return nullptr;
+  }
+
+  QByteArray bytes = file.readAll();
+
+  file.close();
+
+  if (bytes.size() < kFrameIndexHeaderSize) {
+    return nullptr;
+  }
+
+  const uchar* data = reinterpret_cast<const uchar*>(bytes.constData());
+
+  if (qFromLittleEndian<quint32>(data) != kFrameIndexMagic
+      || qFromLittleEndian<quint32>(data + 4) != kFrameIndexVersion) {
+    return nullptr;
+  }
+
+  quint32 stored_count = qFromLittleEndian<quint32>(data + 8);
+
+  // Every frame takes at least two bytes, so a count larger than that can't be genuine and shouldn't be reserved for
+  if (stored_count > static_cast<quint32>(bytes.size() - kFrameIndexHeaderSize) / 2) {
+    return nullptr;
+  }
+
+  int count = static_cast<int>(stored_count);
+
+  std::shared_ptr<FrameIndex> index = std::make_shared<FrameIndex>();
+
+  index->timestamps_.reserve(count);
+  index->positions_.reserve(count);
+
+  if (data[12]) {
+    index->SetComplete();
+  }
+
+  const uchar* read = data + kFrameIndexHeaderSize;
+  const uchar* end = data + bytes.size();
+
+  int64_t last_ts = 0;
+  int64_t last_pos = 0;
+
+  for (int i=0;i<count;i++) {
+    quint64 values[2];
+
+    for (int j=0;j<2;j++) {
+      quint64 v = 0;
+      int shift = 0;
+
+      do {
+        if (read == end || shift > 63) {
+          // Truncated or corrupt
+          return nullptr;
+        }
+
+        v |= static_cast<quint64>(*read & 0x7F) << shift;
+        shift += 7;
+      } while (*(read++) & 0x80);
+
+      values[j] = v;
+    }
+
+    bool key = values[0] & 1;
+    quint64 ts_zigzag = values[0] >> 1;
+
+    last_ts += static_cast<int64_t>(ts_zigzag >> 1) ^ -static_cast<int64_t>(ts_zigzag & 1);
+    last_pos += static_cast<int64_t>(values[1] >> 1) ^ -static_cast<int64_t>(values[1] & 1);
+
+    index->Append(last_ts, last_pos, key);
+  }
+
+  return index;
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,100 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef FRAMEINDEX_H
+#define FRAMEINDEX_H
+
+#include <memory>
+#include <QString>
+#include <QVector>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+class FrameIndex;
+using FrameIndexPtr = std::shared_ptr<const FrameIndex>;
+
+/**
+ * @brief Presentation timestamps of every frame in a video stream along with their byte offsets and keyframes
+ *
+ * Entries are kept sorted by timestamp so lookups are binary searches. Once published (as a FrameIndexPtr) an index is
+ * never modified, an indexer builds a new one and publishes it in its place, so readers never need to lock.
+ *
+ * On disk the index is delta-encoded with variable-length integers, which usually comes to 2-4 bytes per frame.
+ */
+class FrameIndex
+{
+public:
+  FrameIndex();
+
+  /**
+   * @brief Add a frame, entries may arrive in decode order and are sorted as they're added
+   */
+  void Append(int64_t timestamp, int64_t position, bool keyframe);
+
+  /**
+   * @brief Mark this index as covering the entire stream
+   */
+  void SetComplete();
+
+  bool is_complete() const;
+
+  bool isEmpty() const;
+
+  int count() const;
+
+  int64_t timestamp(int index) const;
+
+  int64_t position(int index) const;
+
+  int64_t last_timestamp() const;
+
+  /**
+   * @brief Returns the index of the last frame at or before `timestamp`, or -1 if there isn't one
+   */
+  int FindFrame(int64_t timestamp) const;
+
+  /**
+   * @brief Returns the index of the last keyframe at or before the frame at `index`, or -1 if there isn't one
+   */
+  int FindKeyframe(int index) const;
+
+  bool Save(const QString& filename) const;
+
+  static FrameIndexPtr Load(const QString& filename);
+
+private:
+  QVector<int64_t> timestamps_;
+
+  QVector<int64_t> positions_;
+
+  /**
+   * @brief Indices of keyframes into `timestamps_`, sorted
+   */
+  QVector<int> keyframes_;
+
+  bool complete_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // FRAMEINDEX_H
@@ -20,14 +20,10 @@
 
 #include "videostream.h"
 
-#include <QFile>
-
 #include "common/timecodefunctions.h"
 
 OLIVE_NAMESPACE_ENTER
 
-const int64_t VideoStream::kEndTimestamp = AV_NOPTS_VALUE;
-
 VideoStream::VideoStream() :
   start_time_(0),
   is_image_sequence_(false)
@@ -84,101 +80,64 @@ int64_t VideoStream::get_closest_timestamp_in_frame_index(const rational &time)
 
 int64_t VideoStream::get_closest_timestamp_in_frame_index(int64_t timestamp)
 {
-  QMutexLocker locker(&index_access_lock_);
+  FrameIndexPtr index = frame_index();
 
-  if (frame_index_.isEmpty()) {
+  if (!index || index->isEmpty()) {
     return -1;
   }
 
   // Adjust target by stream's start time
   timestamp += start_time_;
 
-  if (timestamp <= 0) {
-    return frame_index_.first();
-  }
-
-  int index_size = frame_index_.size();
-
-  if (frame_index_.last() == kEndTimestamp) {
-    index_size--;
-  }
-
-  // Use index to find closest frame in file
-  for (int i=0;i<index_size;i++) {
-    int64_t this_ts = frame_index_.at(i);
-
-    if (this_ts == timestamp) {
-      return timestamp;
-    } else if (this_ts > timestamp) {
-      return frame_index_.at(i - 1);
-    }
+  if (timestamp <= index->timestamp(0)) {
+    return index->timestamp(0);
   }
 
-  if (frame_index_.last() == kEndTimestamp) {
-    // Index is done
-    return frame_index_.last();
-  } else {
-    // Index is not done yet
+  if (timestamp > index->last_timestamp() && !index->is_complete()) {
+    // Index hasn't got this far yet
     return -1;
   }
+
+  return index->timestamp(index->FindFrame(timestamp));
 }
 
-void VideoStream::clear_frame_index()
+FrameIndexPtr VideoStream::frame_index() const
 {
-  {
-    QMutexLocker locker(&index_access_lock_);
+  return std::atomic_load(&frame_index_);
+}
 
-    frame_index_.clear();
-  }
+void VideoStream::set_frame_index(FrameIndexPtr index)
+{
+  std::atomic_store(&frame_index_, index);
 
   emit IndexChanged();
 }
 
-void VideoStream::append_frame_index(const int64_t &ts)
+void VideoStream::clear_frame_index()
 {
-  {
-    QMutexLocker locker(&index_access_lock_);
-
-    frame_index_.append(ts);
-  }
-
-  emit IndexChanged();
+  set_frame_index(nullptr);
 }
 
-bool VideoStream::is_frame_index_ready()
+bool VideoStream::is_frame_index_ready() const
 {
-  QMutexLocker locker(&index_access_lock_);
+  FrameIndexPtr index = frame_index();
 
-  return !frame_index_.isEmpty() && frame_index_.last() == VideoStream::kEndTimestamp;
+  return index && index->is_complete();
 }
 
-int64_t VideoStream::last_frame_index_timestamp()
+int64_t VideoStream::last_frame_index_timestamp() const
 {
-  QMutexLocker locker(&index_access_lock_);
+  FrameIndexPtr index = frame_index();
 
-  return frame_index_.last();
+  return (index && !index->isEmpty()) ? index->last_timestamp() : -1;
 }
 
 bool VideoStream::load_frame_index(const QString &s)
 {
-  // Load index from file
-  QFile index_file(s);
-
-  if (index_file.exists() && index_file.open(QFile::ReadOnly)) {
-    {
-      QMutexLocker locker(&index_access_lock_);
-
-      // Resize based on filesize
-      frame_index_.resize(static_cast<size_t>(index_file.size()) / sizeof(int64_t));
-
-      // Read frame index into vector
-      index_file.read(reinterpret_cast<char*>(frame_index_.data()),
-                      index_file.size());
-    }
-
-    index_file.close();
+  FrameIndexPtr index = FrameIndex::Load(s);
 
-    emit IndexChanged();
+  if (index) {
+    set_frame_index(index);
 
     return true;
   }
@@ -186,23 +145,11 @@ bool VideoStream::load_frame_index(const QString &s)
   return false;
 }
 
-bool VideoStream::save_frame_index(const QString &s)
+bool VideoStream::save_frame_index(const QString &s) const
 {
-  QFile index_file(s);
+  FrameIndexPtr index = frame_index();
 
-  if (index_file.open(QFile::WriteOnly)) {
-    // Write index in binary
-    QMutexLocker locker(&index_access_lock_);
-
-    index_file.write(reinterpret_cast<const char*>(frame_index_.constData()),
-                     frame_index_.size() * static_cast<int>(sizeof(int64_t)));
-
-    index_file.close();
-
-    return true;
-  }
-
-  return false;
+  return index && index->Save(s);
 }
 
 OLIVE_NAMESPACE_EXIT
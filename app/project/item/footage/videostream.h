@@ -21,6 +21,7 @@
 #ifndef VIDEOSTREAM_H
 #define VIDEOSTREAM_H
 
+#include "frameindex.h"
 #include "imagestream.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -31,8 +32,6 @@ class VideoStream : public ImageStream
 public:
   VideoStream();
 
-  static const int64_t kEndTimestamp;
-
   virtual QString description() const override;
 
   /**
@@ -51,23 +50,34 @@ public:
 
   int64_t get_closest_timestamp_in_frame_index(const rational& time);
   int64_t get_closest_timestamp_in_frame_index(int64_t timestamp);
+
+  /**
+   * @brief Returns the current frame index, safe to call from any thread without locking
+   *
+   * The returned index never changes, indexing publishes a new one with set_frame_index() as it progresses. May be
+   * nullptr if this stream hasn't started indexing yet.
+   */
+  FrameIndexPtr frame_index() const;
+
+  void set_frame_index(FrameIndexPtr index);
+
   void clear_frame_index();
-  void append_frame_index(const int64_t& ts);
-  bool is_frame_index_ready();
-  int64_t last_frame_index_timestamp();
+
+  bool is_frame_index_ready() const;
+
+  int64_t last_frame_index_timestamp() const;
 
   bool load_frame_index(const QString& s);
-  bool save_frame_index(const QString& s);
+
+  bool save_frame_index(const QString& s) const;
 
 private:
   rational frame_rate_;
 
-  QVector<int64_t> frame_index_;
+  FrameIndexPtr frame_index_;
 
   int64_t start_time_;
 
-  QMutex index_access_lock_;
-
   bool is_image_sequence_;
 
 };
@@ -100,7 +100,11 @@ int AudioRenderingParams::time_to_samples(const rational &time) const
 {
   Q_ASSERT(is_valid());
 
-  return qFloor(time.toDouble() * sample_rate());
+  if (time.isNull()) {
+    return 0;
+  }
+
+  return static_cast<int>(av_rescale_rnd(time.numerator(), sample_rate(), time.denominator(), AV_ROUND_DOWN));
 }
 
 int AudioRenderingParams::samples_to_bytes(const int &samples) const
@@ -20,6 +20,7 @@
 
 #include "audiobackend.h"
 
+#include "audio/peakpyramid.h"
 #include "audioworker.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -84,7 +85,9 @@ void AudioBackend::ThreadCompletedCache(NodeDependency dep, NodeValueTable data,
   if (job_time == render_job_info_.value(dep.range())) {
     render_job_info_.remove(dep.range());
 
-    QByteArray cached_samples = data.Get(NodeParam::kSamples).value<SampleBufferPtr>()->toPackedData();
+    SampleBufferPtr samples = data.Get(NodeParam::kSamples).value<SampleBufferPtr>();
+
+    QByteArray cached_samples = samples->toPackedData();
 
     int offset = params().time_to_bytes(dep.in());
     int length = params().time_to_bytes(dep.range().length());
@@ -119,6 +122,8 @@ void AudioBackend::ThreadCompletedCache(NodeDependency dep, NodeValueTable data,
         }
 
         f.close();
+
+        PeakPyramid::Write(PeaksPathName(), samples, dep.in());
       } else {
         qWarning() << "Failed to write to cached PCM file";
       }
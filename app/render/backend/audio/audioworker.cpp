@@ -20,8 +20,15 @@
 
 #include "audioworker.h"
 
+#include <algorithm>
+
 OLIVE_NAMESPACE_ENTER
 
+// Connected inputs (and keyframed ones that can't be sampled directly) are evaluated at this interval (in samples)
+// and interpolated in between. It's well below anything audible but saves evaluating the graph for every single
+// sample.
+const int kAutomationInterval = 64;
+
 AudioWorker::AudioWorker(QHash<Node *, Node *> *copy_map, QObject *parent) :
   AudioRenderWorker(copy_map, parent)
 {
@@ -33,7 +40,8 @@ void AudioWorker::FrameToValue(DecoderPtr decoder, StreamPtr stream, const TimeR
     return;
   }
 
-  if (decoder->HasConformedVersion(audio_params())) {
+  // Conformed audio is just a cache if the decoder can stream from the source
+  if (decoder->HasConformedVersion(audio_params()) || decoder->CanStreamAudio()) {
     SampleBufferPtr frame = decoder->RetrieveAudio(range.in(), range.out() - range.in(), audio_params());
 
     if (frame) {
@@ -69,39 +77,124 @@ void AudioWorker::RunNodeAccelerated(const Node *node, const TimeRange &range, N
     return;
   }
 
-  SampleBufferPtr output_buffer = SampleBuffer::CreateAllocated(input_buffer->audio_params(), input_buffer->sample_count_per_channel());
-
   int sample_count = input_buffer->sample_count_per_channel();
 
-  // FIXME: Hardcoded float sample format
-  for (int i=0;i<sample_count;i++) {
-    // Calculate the exact rational time at this sample
-    int sample_out_of_channel = i / audio_params().channel_count();
-    double sample_to_second = static_cast<double>(sample_out_of_channel) / static_cast<double>(audio_params().sample_rate());
-
-    rational this_sample_time = rational::fromDouble(range.in().toDouble() + sample_to_second);
-
-    // Update all non-sample and non-footage inputs
-    foreach (NodeParam* param, node->parameters()) {
-      if (param->type() == NodeParam::kInput
-          && param != sample_input) {
-        NodeInput* input = static_cast<NodeInput*>(param);
-
-        // If the input isn't keyframing, we don't need to update it unless it's connected, in which case it may change
-        if (input->IsConnected() || input->is_keyframing()) {
-          input_params.Insert(input, ProcessInput(input, TimeRange(this_sample_time, this_sample_time)));
+  SampleBufferPtr output_buffer = SampleBuffer::CreateAllocated(input_buffer->audio_params(), sample_count);
+
+  // Resolve every numeric input over the whole buffer so the node can process it in one go
+  SampleAutomationMap automation;
+
+  foreach (NodeParam* param, node->parameters()) {
+    if (param->type() == NodeParam::kInput
+        && param != sample_input) {
+      NodeInput* input = static_cast<NodeInput*>(param);
+      SampleAutomation input_automation;
+      float constant;
+
+      // If the input isn't keyframing, it won't change over the buffer unless it's connected
+      if (!input->IsConnected()
+          && input->is_keyframing()
+          && input->data_type() == NodeParam::kFloat
+          && input->get_number_of_keyframe_tracks() == 1) {
+        // Plain keyframed floats can be sampled exactly without going through the traverser
+        if (sample_count) {
+          QVector<float> curve(sample_count);
+
+          input->get_values_at_interval_for_track(range.in(),
+                                                  rational(1, audio_params().sample_rate()),
+                                                  sample_count,
+                                                  0,
+                                                  curve.data());
+
+          if (std::all_of(curve.constBegin(), curve.constEnd(), [&curve](float v){ return v == curve.first(); })) {
+            automation.insert(input, SampleAutomation(curve.first()));
+          } else {
+            automation.insert(input, SampleAutomation(curve));
+          }
+        }
+      } else if (input->IsConnected() || input->is_keyframing()) {
+        if (EvaluateAutomation(input, range.in(), sample_count, &input_automation)) {
+          automation.insert(input, input_automation);
         }
+      } else if (TableToNumber(input_params[input], &constant)) {
+        automation.insert(input, SampleAutomation(constant));
       }
     }
-
-    node->ProcessSamples(input_params,
-                         audio_params(),
-                         input_buffer,
-                         output_buffer,
-                         i);
   }
 
+  // FIXME: Hardcoded float sample format
+  node->ProcessSamples(input_params,
+                       automation,
+                       audio_params(),
+                       input_buffer,
+                       output_buffer);
+
   output_params.Push(NodeParam::kSamples, QVariant::fromValue(output_buffer));
 }
 
+bool AudioWorker::EvaluateAutomation(const NodeInput *input, const rational &start, int sample_count, SampleAutomation *automation)
+{
+  if (!sample_count) {
+    // Nothing to evaluate
+    return false;
+  }
+
+  QVector<float> curve(sample_count);
+  bool is_constant = true;
+  int last_index = -1;
+
+  for (int i=0;;i+=kAutomationInterval) {
+    int index = qMin(i, sample_count - 1);
+    rational time = start + rational(index, audio_params().sample_rate());
+    float value;
+
+    if (!TableToNumber(ProcessInput(input, TimeRange(time, time)), &value)) {
+      return false;
+    }
+
+    curve[index] = value;
+
+    if (last_index >= 0) {
+      float last_value = curve.at(last_index);
+
+      is_constant &= (value == last_value);
+
+      // Linearly interpolate the samples in between
+      float step = (value - last_value) / static_cast<float>(index - last_index);
+      for (int j=last_index+1;j<index;j++) {
+        curve[j] = last_value + step * static_cast<float>(j - last_index);
+      }
+    }
+
+    last_index = index;
+
+    if (index == sample_count - 1) {
+      break;
+    }
+  }
+
+  if (is_constant) {
+    *automation = SampleAutomation(curve.first());
+  } else {
+    *automation = SampleAutomation(curve);
+  }
+
+  return true;
+}
+
+bool AudioWorker::TableToNumber(const NodeValueTable &table, float *number)
+{
+  NodeValue value = table.GetWithMeta(NodeParam::kNumber);
+
+  if (value.type() == NodeParam::kRational) {
+    *number = static_cast<float>(value.data().value<rational>().toDouble());
+  } else if (value.type() & NodeParam::kNumber) {
+    *number = value.data().toFloat();
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
 OLIVE_NAMESPACE_EXIT
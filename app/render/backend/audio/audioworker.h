@@ -36,6 +36,14 @@ protected:
   virtual void RunNodeAccelerated(const Node *node, const TimeRange& range, NodeValueDatabase& input_params, NodeValueTable& output_params) override;
 
 private:
+  /**
+   * @brief Evaluate a keyframed or connected input at every sample of a buffer starting at `start`
+   *
+   * Returns false if the input doesn't resolve to a number.
+   */
+  bool EvaluateAutomation(const NodeInput* input, const rational& start, int sample_count, SampleAutomation* automation);
+
+  static bool TableToNumber(const NodeValueTable& table, float* number);
 
 };
 
@@ -23,6 +23,7 @@
 #include <QDir>
 #include <QtMath>
 
+#include "audio/peakpyramid.h"
 #include "audiorenderworker.h"
 #include "common/filefunctions.h"
 #include "render/backend/indexmanager.h"
@@ -58,23 +59,17 @@ void AudioRenderBackend::SetParameters(const AudioRenderingParams &params)
 void AudioRenderBackend::ConnectViewer(ViewerOutput *node)
 {
   connect(node, &ViewerOutput::AudioChangedBetween, this, &AudioRenderBackend::InvalidateCache);
-  connect(node, &ViewerOutput::AudioGraphChanged, this, &AudioRenderBackend::QueueRecompile);
   connect(node, &ViewerOutput::LengthChanged, this, &AudioRenderBackend::TruncateCache);
 }
 
 void AudioRenderBackend::DisconnectViewer(ViewerOutput *node)
 {
   disconnect(node, &ViewerOutput::AudioChangedBetween, this, &AudioRenderBackend::InvalidateCache);
-  disconnect(node, &ViewerOutput::AudioGraphChanged, this, &AudioRenderBackend::QueueRecompile);
   disconnect(node, &ViewerOutput::LengthChanged, this, &AudioRenderBackend::TruncateCache);
 }
 
 bool AudioRenderBackend::CompileInternal()
 {
-  for (int i=0;i<copied_graph_.nodes().size();i++) {
-    copy_map_.insert(copied_graph_.nodes().at(i), source_node_list_.at(i));
-  }
-
   return true;
 }
 
@@ -83,6 +78,16 @@ void AudioRenderBackend::DecompileInternal()
   copy_map_.clear();
 }
 
+void AudioRenderBackend::NodeCopiedEvent(Node *source, Node *copy)
+{
+  copy_map_.insert(copy, source);
+}
+
+void AudioRenderBackend::NodeCopyRemovedEvent(Node *copy)
+{
+  copy_map_.remove(copy);
+}
+
 bool AudioRenderBackend::GenerateCacheIDInternal(QCryptographicHash &hash)
 {
   if (!params_.is_valid()) {
@@ -114,6 +119,11 @@ QString AudioRenderBackend::CachePathName() const
   return QDir(GetMediaCacheLocation()).filePath(cache_fn);
 }
 
+QString AudioRenderBackend::PeaksPathName() const
+{
+  return CachePathName().append(QStringLiteral(".peaks"));
+}
+
 bool AudioRenderBackend::CanRender()
 {
   return params_.is_valid();
@@ -231,6 +241,8 @@ void AudioRenderBackend::TruncateCache(const rational &r)
   if (cache_pcm.size() > seq_length) {
     cache_pcm.resize(seq_length);
   }
+
+  PeakPyramid::Truncate(PeaksPathName(), r);
 }
 
 void AudioRenderBackend::FilterQueueCompleteSignal()
@@ -46,6 +46,11 @@ public:
 
   QString CachePathName() const;
 
+  /**
+   * @brief Waveform peaks of the audio in CachePathName() (see PeakPyramid)
+   */
+  QString PeaksPathName() const;
+
 signals:
   void ParamsChanged();
 
@@ -60,6 +65,10 @@ protected:
 
   virtual void DecompileInternal() override;
 
+  virtual void NodeCopiedEvent(Node* source, Node* copy) override;
+
+  virtual void NodeCopyRemovedEvent(Node* copy) override;
+
   /**
    * @brief Internal function for generating the cache ID
    */
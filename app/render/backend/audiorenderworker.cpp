@@ -24,12 +24,18 @@
 #include <QFloat16>
 
 #include "audio/audiomanager.h"
-#include "audio/sumsamples.h"
+#include "audio/peakpyramid.h"
+#include "audio/timestretcher.h"
 #include "config/config.h"
 #include "node/block/clip/clip.h"
 
 OLIVE_NAMESPACE_ENTER
 
+/**
+ * @brief Extra audio rendered either side of a speed-changed block so chunk boundaries stretch seamlessly
+ */
+const rational kStretchMargin(1, 10);
+
 AudioRenderWorker::AudioRenderWorker(QHash<Node *, Node *> *copy_map, QObject *parent) :
   RenderWorker(parent),
   copy_map_(copy_map)
@@ -70,8 +76,29 @@ NodeValueTable AudioRenderWorker::RenderBlock(const TrackOutput *track, const Ti
     int destination_offset = audio_params_.time_to_samples(range_for_block.in() - range.in());
     int max_dest_sz = audio_params_.time_to_samples(range_for_block.length());
 
+    rational abs_speed = qAbs(b->speed());
+    bool stretch = (abs_speed != 1);
+
+    // Each render only covers part of a block, so when stretching, render some extra audio on either side to give the
+    // stretcher the same context it would have had in one continuous pass and cut it off again afterwards
+    TimeRange range_to_process = range_for_block;
+    int stretch_offset = 0;
+
+    if (stretch) {
+      int start = audio_params_.time_to_samples(range_for_block.in() - b->in());
+      int preroll_start = qMax(0, start - audio_params_.time_to_samples(kStretchMargin));
+
+      // Start a whole number of hops from the block's in point so neighboring renders put their grains in the same place
+      preroll_start -= preroll_start % TimeStretcher::GetHopSize(audio_params_.sample_rate());
+
+      stretch_offset = start - preroll_start;
+
+      range_to_process = TimeRange(b->in() + audio_params_.samples_to_time(preroll_start),
+                                   qMin(b->out(), range_for_block.out() + kStretchMargin));
+    }
+
     // Destination buffer
-    NodeValueTable table = ProcessNode(NodeDependency(b, range_for_block));
+    NodeValueTable table = ProcessNode(NodeDependency(b, range_to_process));
     QVariant sample_val = table.Take(NodeParam::kSamples);
     SampleBufferPtr samples_from_this_block;
 
@@ -82,17 +109,38 @@ NodeValueTable AudioRenderWorker::RenderBlock(const TrackOutput *track, const Ti
     }
 
     // Stretch samples here
-    rational abs_speed = qAbs(b->speed());
-
-    if (abs_speed != 1) {
-      samples_from_this_block->speed(abs_speed.toDouble());
+    if (stretch) {
+      samples_from_this_block = TimeStretcher::Stretch(samples_from_this_block, abs_speed.toDouble());
     }
 
     if (b->is_reversed()) {
+      if (!stretch) {
+        // This buffer may be shared with other consumers of the block's value, so reverse a copy of it
+        SampleBufferPtr copy = SampleBuffer::CreateAllocated(samples_from_this_block->audio_params(),
+                                                             samples_from_this_block->sample_count_per_channel());
+        copy->set(samples_from_this_block->const_data(), samples_from_this_block->sample_count_per_channel());
+        samples_from_this_block = copy;
+      }
+
       // Reverse the audio buffer
       samples_from_this_block->reverse();
     }
 
+    if (stretch) {
+      // Remove the extra audio either side of the range we actually wanted
+      int trimmed_length = qBound(0, samples_from_this_block->sample_count_per_channel() - stretch_offset, max_dest_sz);
+      SampleBufferPtr trimmed = SampleBuffer::CreateAllocated(audio_params_, trimmed_length);
+
+      QVector<const float*> trimmed_src(audio_params_.channel_count());
+      for (int i=0;i<trimmed_src.size();i++) {
+        trimmed_src[i] = samples_from_this_block->const_data()[i] + stretch_offset;
+      }
+
+      trimmed->set(trimmed_src.data(), trimmed_length);
+
+      samples_from_this_block = trimmed;
+    }
+
     int copy_length = qMin(max_dest_sz, samples_from_this_block->sample_count_per_channel());
 
     // Copy samples into destination buffer
@@ -105,45 +153,8 @@ NodeValueTable AudioRenderWorker::RenderBlock(const TrackOutput *track, const Ti
       QDir waveform_loc = local_appdata_dir.filePath(QStringLiteral("waveform"));
       waveform_loc.mkpath(".");
       QString wave_fn(waveform_loc.filePath(QString::number(reinterpret_cast<quintptr>(src_block))));
-      QFile wave_file(wave_fn);
-
-      if (wave_file.open(QFile::ReadWrite)) {
-        // We use S32 as a size-compatible substitute for SampleSummer::Sum which is 4 bytes in size
-        AudioRenderingParams waveform_params(SampleSummer::kSumSampleRate, audio_params_.channel_layout(), SampleFormat::SAMPLE_FMT_S32);
-        int chunk_size = (audio_params().sample_rate() / waveform_params.sample_rate());
-
-        qint64 start_offset = waveform_params.time_to_bytes(range_for_block.in() - b->in());
-        qint64 length_offset = waveform_params.time_to_bytes(range_for_block.length());
-        qint64 end_offset = start_offset + length_offset;
-
-        if (wave_file.size() < end_offset) {
-          wave_file.resize(end_offset);
-        }
-
-        wave_file.seek(start_offset);
-
-        for (int i=0;i<samples_from_this_block->sample_count_per_channel();i+=chunk_size) {
-          QVector<SampleSummer::Sum> summary = SampleSummer::SumSamples(samples_from_this_block,
-                                                                        i,
-                                                                        qMin(chunk_size, samples_from_this_block->sample_count_per_channel() - i));
-
-          wave_file.write(reinterpret_cast<const char*>(summary.constData()),
-                          summary.size() * sizeof(SampleSummer::Sum));
-        }
-
-        wave_file.close();
-
-        // Write metadata about this waveform file
-        QFile wave_metadata(wave_fn.append(QStringLiteral(".meta")));
-        if (wave_metadata.open(QFile::WriteOnly)) {
-          SampleSummer::Info info;
-          info.channels = audio_params_.channel_count();
-
-          wave_metadata.write(reinterpret_cast<char*>(&info), sizeof(SampleSummer::Info));
-
-          wave_metadata.close();
-        }
 
+      if (PeakPyramid::Write(wave_fn, samples_from_this_block, range_for_block.in() - b->in())) {
         if (src_block->type() == Block::kClip) {
           emit static_cast<ClipBlock*>(src_block)->PreviewUpdated();
         }
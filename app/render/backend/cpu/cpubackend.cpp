@@ -0,0 +1,62 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "cpubackend.h"
+
+#include "cpuworker.h"
+
+OLIVE_NAMESPACE_ENTER
+
+CPUBackend::CPUBackend(QObject *parent) :
+  VideoRenderBackend(parent)
+{
+}
+
+CPUBackend::~CPUBackend()
+{
+  Close();
+}
+
+bool CPUBackend::InitInternal()
+{
+  if (!VideoRenderBackend::InitInternal()) {
+    return false;
+  }
+
+  // Initiate one thread per CPU core, each worker also splits its frames across the global thread pool
+  for (int i=0;i<threads().size();i++) {
+    CPUWorker* processor = new CPUWorker(frame_cache());
+    processor->SetParameters(params());
+    processors_.append(processor);
+  }
+
+  return true;
+}
+
+bool CPUBackend::CompileInternal()
+{
+  return true;
+}
+
+void CPUBackend::DecompileInternal()
+{
+}
+
+OLIVE_NAMESPACE_EXIT
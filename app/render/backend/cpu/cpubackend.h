@@ -0,0 +1,52 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef CPUBACKEND_H
+#define CPUBACKEND_H
+
+#include "../videorenderbackend.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Video backend that renders without a GPU
+ *
+ * Useful for headless machines and as a reference for the OpenGL backend's output.
+ */
+class CPUBackend : public VideoRenderBackend
+{
+  Q_OBJECT
+public:
+  CPUBackend(QObject* parent = nullptr);
+
+  virtual ~CPUBackend() override;
+
+protected:
+  virtual bool InitInternal() override;
+
+  virtual bool CompileInternal() override;
+
+  virtual void DecompileInternal() override;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // CPUBACKEND_H
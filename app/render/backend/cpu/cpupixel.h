@@ -0,0 +1,167 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef CPUPIXEL_H
+#define CPUPIXEL_H
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define OLIVE_CPU_PIXEL_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief A single premultiplied RGBA32F pixel used by the CPU render kernels
+ *
+ * On x86 this wraps an SSE register so the four channels are processed together. Other architectures fall back to
+ * plain floats, which most compilers will auto-vectorize anyway.
+ */
+class CPUPixel
+{
+public:
+#ifdef OLIVE_CPU_PIXEL_SSE
+  CPUPixel() :
+    v_(_mm_setzero_ps())
+  {
+  }
+
+  CPUPixel(float r, float g, float b, float a) :
+    v_(_mm_setr_ps(r, g, b, a))
+  {
+  }
+
+  static CPUPixel Load(const float* p)
+  {
+    return CPUPixel(_mm_loadu_ps(p));
+  }
+
+  void Store(float* p) const
+  {
+    _mm_storeu_ps(p, v_);
+  }
+
+  float alpha() const
+  {
+    return _mm_cvtss_f32(_mm_shuffle_ps(v_, v_, _MM_SHUFFLE(3, 3, 3, 3)));
+  }
+
+  CPUPixel operator+(const CPUPixel& rhs) const
+  {
+    return CPUPixel(_mm_add_ps(v_, rhs.v_));
+  }
+
+  CPUPixel operator-(const CPUPixel& rhs) const
+  {
+    return CPUPixel(_mm_sub_ps(v_, rhs.v_));
+  }
+
+  CPUPixel operator*(float s) const
+  {
+    return CPUPixel(_mm_mul_ps(v_, _mm_set1_ps(s)));
+  }
+#else
+  CPUPixel()
+  {
+    v_[0] = v_[1] = v_[2] = v_[3] = 0.0f;
+  }
+
+  CPUPixel(float r, float g, float b, float a)
+  {
+    v_[0] = r;
+    v_[1] = g;
+    v_[2] = b;
+    v_[3] = a;
+  }
+
+  static CPUPixel Load(const float* p)
+  {
+    return CPUPixel(p[0], p[1], p[2], p[3]);
+  }
+
+  void Store(float* p) const
+  {
+    for (int i=0;i<4;i++) {
+      p[i] = v_[i];
+    }
+  }
+
+  float alpha() const
+  {
+    return v_[3];
+  }
+
+  CPUPixel operator+(const CPUPixel& rhs) const
+  {
+    return CPUPixel(v_[0] + rhs.v_[0], v_[1] + rhs.v_[1], v_[2] + rhs.v_[2], v_[3] + rhs.v_[3]);
+  }
+
+  CPUPixel operator-(const CPUPixel& rhs) const
+  {
+    return CPUPixel(v_[0] - rhs.v_[0], v_[1] - rhs.v_[1], v_[2] - rhs.v_[2], v_[3] - rhs.v_[3]);
+  }
+
+  CPUPixel operator*(float s) const
+  {
+    return CPUPixel(v_[0] * s, v_[1] * s, v_[2] * s, v_[3] * s);
+  }
+#endif
+
+  CPUPixel& operator+=(const CPUPixel& rhs)
+  {
+    *this = *this + rhs;
+    return *this;
+  }
+
+  /**
+   * @brief Linear interpolation between two pixels, t = 0.0 returns `a` and t = 1.0 returns `b`
+   */
+  static CPUPixel Mix(const CPUPixel& a, const CPUPixel& b, float t)
+  {
+    return a + (b - a) * t;
+  }
+
+  /**
+   * @brief Composite this pixel over `base` (both premultiplied)
+   */
+  CPUPixel Over(const CPUPixel& base) const
+  {
+    return *this + base * (1.0f - alpha());
+  }
+
+private:
+#ifdef OLIVE_CPU_PIXEL_SSE
+  explicit CPUPixel(__m128 v) :
+    v_(v)
+  {
+  }
+
+  __m128 v_;
+#else
+  float v_[4];
+#endif
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // CPUPIXEL_H
@@ -0,0 +1,615 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "cpurenderfunctions.h"
+
+#include <cstring>
+#include <QThreadPool>
+#include <QtMath>
+
+#include "common/clamp.h"
+#include "render/pixelformat.h"
+
+OLIVE_NAMESPACE_ENTER
+
+FramePtr CPURenderFunctions::CreateTexture(int width, int height)
+{
+  FramePtr frame = Frame::Create();
+
+  frame->set_video_params(VideoRenderingParams(width, height, PixelFormat::PIX_FMT_RGBA32F));
+  frame->allocate();
+
+  // Match the OpenGL backend, which clears every framebuffer before drawing to it
+  memset(frame->data(), 0, static_cast<size_t>(frame->allocated_size()));
+
+  return frame;
+}
+
+FramePtr CPURenderFunctions::ConvertToTexture(FramePtr frame)
+{
+  if (PixelFormat::FormatHasAlphaChannel(frame->format())) {
+    return PixelFormat::ConvertPixelFormat(frame, PixelFormat::PIX_FMT_RGBA32F);
+  }
+
+  FramePtr rgb = PixelFormat::ConvertPixelFormat(frame, PixelFormat::PIX_FMT_RGB32F);
+
+  if (!rgb) {
+    return nullptr;
+  }
+
+  // Converting straight to RGBA would leave the new alpha channel at zero, so we expand it ourselves
+  FramePtr rgba = CreateTexture(rgb->width(), rgb->height());
+  rgba->set_timestamp(rgb->timestamp());
+
+  const float* src = reinterpret_cast<const float*>(rgb->const_data());
+  float* dst = reinterpret_cast<float*>(rgba->data());
+  int pixel_count = rgb->width() * rgb->height();
+
+  for (int i=0;i<pixel_count;i++) {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+    dst[3] = 1.0f;
+
+    src += 3;
+    dst += 4;
+  }
+
+  return rgba;
+}
+
+FramePtr CPURenderFunctions::MatchSize(FramePtr src, int width, int height)
+{
+  if (src->width() == width && src->height() == height) {
+    return src;
+  }
+
+  FramePtr resized = CreateTexture(width, height);
+  Blit(resized, src);
+  return resized;
+}
+
+void CPURenderFunctions::ParallelRows(int height, const std::function<void (int, int)> &func)
+{
+  QThreadPool* pool = QThreadPool::globalInstance();
+
+  // Use a few tiles per thread so a slow tile doesn't hold everything up
+  int threads = qMax(1, pool->maxThreadCount());
+  int tile_height = qMax(8, (height + threads * 4 - 1) / (threads * 4));
+  int tile_count = (height + tile_height - 1) / tile_height;
+
+  if (tile_count <= 1) {
+    func(0, height);
+    return;
+  }
+
+  RowTiles tiles;
+  tiles.func = &func;
+  tiles.height = height;
+  tiles.tile_height = tile_height;
+
+  // The calling thread works through tiles too, helpers simply exit if it has already taken all of them
+  int helpers = qMin(threads, tile_count) - 1;
+
+  for (int i=0;i<helpers;i++) {
+    pool->start(new RowHelper(&tiles));
+  }
+
+  RunTiles(&tiles);
+
+  tiles.helpers_finished.acquire(helpers);
+}
+
+void CPURenderFunctions::Blit(FramePtr dst, FramePtr src)
+{
+  if (src->width() == dst->width() && src->height() == dst->height()) {
+    memcpy(dst->data(), src->const_data(), static_cast<size_t>(dst->allocated_size()));
+    return;
+  }
+
+  const float* src_data = reinterpret_cast<const float*>(src->const_data());
+  float* dst_data = reinterpret_cast<float*>(dst->data());
+  int src_width = src->width();
+  int src_height = src->height();
+  int dst_width = dst->width();
+  float dst_width_f = static_cast<float>(dst->width());
+  float dst_height_f = static_cast<float>(dst->height());
+
+  ParallelRows(dst->height(), [&](int start, int end){
+    for (int y=start;y<end;y++) {
+      float v = (static_cast<float>(y) + 0.5f) / dst_height_f;
+      float* out = dst_data + y * dst_width * 4;
+
+      for (int x=0;x<dst_width;x++) {
+        float u = (static_cast<float>(x) + 0.5f) / dst_width_f;
+
+        Sample(src_data, src_width, src_height, u, v).Store(out + x * 4);
+      }
+    }
+  });
+}
+
+void CPURenderFunctions::AlphaOver(FramePtr dst, FramePtr base, FramePtr blend)
+{
+  if (!base && !blend) {
+    return;
+  }
+
+  if (!base || !blend) {
+    Blit(dst, base ? base : blend);
+    return;
+  }
+
+  const float* base_data = reinterpret_cast<const float*>(base->const_data());
+  const float* blend_data = reinterpret_cast<const float*>(blend->const_data());
+  float* dst_data = reinterpret_cast<float*>(dst->data());
+  int width = dst->width();
+
+  ParallelRows(dst->height(), [&](int start, int end){
+    for (int i=start*width*4;i<end*width*4;i+=4) {
+      CPUPixel::Load(blend_data + i).Over(CPUPixel::Load(base_data + i)).Store(dst_data + i);
+    }
+  });
+}
+
+void CPURenderFunctions::Mix(FramePtr dst, FramePtr a, float a_weight, FramePtr b, float b_weight)
+{
+  // A missing input contributes nothing, which is the same as a transparent one with any weight
+  if (!a) {
+    a = b;
+    a_weight = 0.0f;
+  } else if (!b) {
+    b = a;
+    b_weight = 0.0f;
+  }
+
+  if (!a) {
+    return;
+  }
+
+  const float* a_data = reinterpret_cast<const float*>(a->const_data());
+  const float* b_data = reinterpret_cast<const float*>(b->const_data());
+  float* dst_data = reinterpret_cast<float*>(dst->data());
+  int width = dst->width();
+
+  ParallelRows(dst->height(), [&](int start, int end){
+    for (int i=start*width*4;i<end*width*4;i+=4) {
+      (CPUPixel::Load(a_data + i) * a_weight + CPUPixel::Load(b_data + i) * b_weight).Store(dst_data + i);
+    }
+  });
+}
+
+void CPURenderFunctions::Solid(FramePtr dst, const Color &color)
+{
+  CPUPixel px(color.red(), color.green(), color.blue(), color.alpha());
+  float* dst_data = reinterpret_cast<float*>(dst->data());
+  int width = dst->width();
+
+  ParallelRows(dst->height(), [&](int start, int end){
+    for (int i=start*width*4;i<end*width*4;i+=4) {
+      px.Store(dst_data + i);
+    }
+  });
+}
+
+void CPURenderFunctions::Blur(FramePtr dst,
+                              FramePtr src,
+                              CPURenderFunctions::BlurMethod method,
+                              float radius,
+                              bool horizontal,
+                              bool vertical,
+                              bool repeat_edge_pixels,
+                              const QVector2D &resolution)
+{
+  if (qIsNull(radius) || (!horizontal && !vertical)) {
+    Blit(dst, src);
+    return;
+  }
+
+  // We only sample on hard pixels, so we don't accept decimal radii
+  float real_radius = qCeil(radius);
+  float sigma = real_radius;
+
+  if (method == kGaussianBlur) {
+    // Using (radius = 3 * sigma) because 3 standard deviations covers 97% of the blur, same as the shader
+    real_radius *= 3.0f;
+  }
+
+  // Weights are the same for every pixel, so calculate them once instead of per pixel like the shader does. Each
+  // sample lands halfway between two pixels so the bilinear filter averages them, halving the number of samples.
+  QVector<float> offsets;
+  QVector<float> weights;
+  float weight_sum = 0.0f;
+
+  for (float i=-real_radius+0.5f;i<=real_radius;i+=2.0f) {
+    float weight;
+
+    if (method == kGaussianBlur) {
+      weight = qExp(-0.5f * (i * i) / (sigma * sigma)) / (sigma * sigma * 2.0f * static_cast<float>(M_PI));
+    } else {
+      weight = 1.0f / real_radius;
+    }
+
+    offsets.append(i);
+    weights.append(weight);
+    weight_sum += weight;
+  }
+
+  QVector<Tap> horiz_taps;
+  QVector<Tap> vert_taps;
+
+  for (int i=0;i<offsets.size();i++) {
+    float weight = weights.at(i);
+
+    if (method == kGaussianBlur) {
+      weight /= weight_sum;
+    }
+
+    // Radii are in sequence pixels, which may be larger than texture pixels if we're rendering at a lower resolution
+    horiz_taps.append(MakeTap(offsets.at(i) * src->width() / resolution.x(), 0.0f, weight));
+    vert_taps.append(MakeTap(0.0f, offsets.at(i) * src->height() / resolution.y(), weight));
+  }
+
+  if (horizontal && vertical) {
+    FramePtr horiz_pass = CreateTexture(dst->width(), dst->height());
+
+    BlurPass(horiz_pass, src, horiz_taps, true, repeat_edge_pixels);
+    BlurPass(dst, horiz_pass, vert_taps, false, repeat_edge_pixels);
+  } else if (horizontal) {
+    BlurPass(dst, src, horiz_taps, true, repeat_edge_pixels);
+  } else {
+    BlurPass(dst, src, vert_taps, false, repeat_edge_pixels);
+  }
+}
+
+void CPURenderFunctions::DropShadow(FramePtr dst,
+                                    FramePtr src,
+                                    const Color &color,
+                                    float softness,
+                                    float opacity,
+                                    float distance,
+                                    float direction,
+                                    const QVector2D &resolution)
+{
+  // Use pythagoras with the distance (hypotenuse) to find the shadow offset
+  float direction_radians = qDegreesToRadians(direction);
+  float opposite = qSin(direction_radians) * distance;
+  float adjacent = qCos(direction_radians) * distance;
+
+  float x_scale = src->width() / resolution.x();
+  float y_scale = src->height() / resolution.y();
+
+  QVector<Tap> taps;
+
+  if (softness > 0.0f) {
+    // For a soft shadow, we use a box blur-like formula
+    float radius = qCeil(softness);
+    float divider = 1.0f / (softness * softness);
+
+    for (float x=-radius+0.5f;x<=radius;x+=2.0f) {
+      for (float y=-radius+0.5f;y<=radius;y+=2.0f) {
+        taps.append(MakeTap((x - adjacent) * x_scale, (y - opposite) * y_scale, divider));
+      }
+    }
+  } else {
+    // Perfectly hard shadow
+    taps.append(MakeTap(-adjacent * x_scale, -opposite * y_scale, 1.0f));
+  }
+
+  const float* src_data = reinterpret_cast<const float*>(src->const_data());
+  float* dst_data = reinterpret_cast<float*>(dst->data());
+  int width = src->width();
+  int height = src->height();
+  float opacity_multiplier = opacity * 0.01f;
+
+  ParallelRows(height, [&](int start, int end){
+    for (int y=start;y<end;y++) {
+      for (int x=0;x<width;x++) {
+        float shadow_alpha = 0.0f;
+
+        foreach (const Tap& tap, taps) {
+          shadow_alpha += FetchTapAlpha(src_data, width, height, x, y, tap) * tap.weight;
+        }
+
+        shadow_alpha *= opacity_multiplier;
+
+        // NOTE: The shader declares color_in as a vec3 and the OpenGL backend sets it with four components, so the GL
+        //       shadow is always black. We honor the color here, premultiplied like every other texture.
+        CPUPixel shadow(color.red() * shadow_alpha,
+                        color.green() * shadow_alpha,
+                        color.blue() * shadow_alpha,
+                        shadow_alpha);
+
+        // Alpha over the current pixel over the shadow we've made
+        int index = (y * width + x) * 4;
+        CPUPixel::Load(src_data + index).Over(shadow).Store(dst_data + index);
+      }
+    }
+  });
+}
+
+void CPURenderFunctions::Stroke(FramePtr dst,
+                                FramePtr src,
+                                float radius,
+                                float opacity,
+                                bool inner,
+                                const QVector2D &resolution)
+{
+  if (qIsNull(radius) || qIsNull(opacity)) {
+    Blit(dst, src);
+    return;
+  }
+
+  float real_radius = qCeil(radius);
+  float x_scale = src->width() / resolution.x();
+  float y_scale = src->height() / resolution.y();
+
+  // Sample a circle of pixels around each pixel
+  QVector<Tap> taps;
+
+  for (float i=-real_radius+0.5f;i<=real_radius;i+=2.0f) {
+    for (float j=-real_radius+0.5f;j<=real_radius;j+=2.0f) {
+      if (qSqrt(i*i + j*j) < real_radius) {
+        taps.append(MakeTap(i * x_scale, j * y_scale, 1.0f));
+      }
+    }
+  }
+
+  const float* src_data = reinterpret_cast<const float*>(src->const_data());
+  float* dst_data = reinterpret_cast<float*>(dst->data());
+  int width = src->width();
+  int height = src->height();
+  float opacity_multiplier = opacity * 0.01f;
+
+  ParallelRows(height, [&](int start, int end){
+    for (int y=start;y<end;y++) {
+      for (int x=0;x<width;x++) {
+        int index = (y * width + x) * 4;
+        CPUPixel pixel_here = CPUPixel::Load(src_data + index);
+
+        // Detect no-op situations
+        if ((inner && qIsNull(pixel_here.alpha()))
+            || (!inner && pixel_here.alpha() == 1.0f)) {
+          pixel_here.Store(dst_data + index);
+          continue;
+        }
+
+        float stroke_weight = 0.0f;
+
+        foreach (const Tap& tap, taps) {
+          float alpha = FetchTapAlpha(src_data, width, height, x, y, tap);
+
+          if (inner) {
+            alpha = 1.0f - alpha;
+          }
+
+          stroke_weight += alpha;
+
+          if (stroke_weight >= 1.0f) {
+            stroke_weight = 1.0f;
+            break;
+          }
+        }
+
+        stroke_weight *= opacity_multiplier;
+
+        if (inner) {
+          stroke_weight *= pixel_here.alpha();
+        }
+
+        // Matches the shader, which currently ignores color_in and always strokes in white
+        CPUPixel stroke_col(stroke_weight, stroke_weight, stroke_weight, stroke_weight);
+
+        if (inner) {
+          // Alpha over the stroke over the texture
+          stroke_col = stroke_col.Over(pixel_here);
+        } else {
+          // Alpha over the texture over the stroke
+          stroke_col = pixel_here.Over(stroke_col);
+        }
+
+        stroke_col.Store(dst_data + index);
+      }
+    }
+  });
+}
+
+void CPURenderFunctions::TransformFootage(FramePtr dst,
+                                          FramePtr src,
+                                          const QMatrix4x4 &matrix,
+                                          const QVector2D &footage_resolution,
+                                          const QVector2D &resolution)
+{
+  // The vertex shader maps the footage quad with: scale(1/resolution) * matrix * scale(footage_resolution). We walk
+  // the destination pixels instead so we run this backwards to find where in the footage each one lands.
+  bool invertible;
+  QMatrix4x4 inverse = matrix.inverted(&invertible);
+
+  if (!invertible) {
+    // Footage has been scaled to nothing, leave the destination transparent
+    return;
+  }
+
+  const float* src_data = reinterpret_cast<const float*>(src->const_data());
+  float* dst_data = reinterpret_cast<float*>(dst->data());
+  int src_width = src->width();
+  int src_height = src->height();
+  int dst_width = dst->width();
+  float dst_width_f = static_cast<float>(dst->width());
+  float dst_height_f = static_cast<float>(dst->height());
+
+  ParallelRows(dst->height(), [&](int start, int end){
+    for (int y=start;y<end;y++) {
+      float ndc_y = ((static_cast<float>(y) + 0.5f) / dst_height_f * 2.0f - 1.0f) * resolution.y();
+      float* out = dst_data + y * dst_width * 4;
+
+      for (int x=0;x<dst_width;x++) {
+        float ndc_x = ((static_cast<float>(x) + 0.5f) / dst_width_f * 2.0f - 1.0f) * resolution.x();
+
+        // Transforms are 2D so we can ignore Z and the projection row
+        float pos_x = inverse(0, 0) * ndc_x + inverse(0, 1) * ndc_y + inverse(0, 3);
+        float pos_y = inverse(1, 0) * ndc_x + inverse(1, 1) * ndc_y + inverse(1, 3);
+
+        // Convert from the -1.0 - 1.0 quad to 0.0 - 1.0 texture coordinates
+        float u = (pos_x / footage_resolution.x() + 1.0f) * 0.5f;
+        float v = (pos_y / footage_resolution.y() + 1.0f) * 0.5f;
+
+        if (u >= 0.0f && u < 1.0f && v >= 0.0f && v < 1.0f) {
+          Sample(src_data, src_width, src_height, u, v).Store(out + x * 4);
+        }
+      }
+    }
+  });
+}
+
+CPURenderFunctions::Tap CPURenderFunctions::MakeTap(float x_offset, float y_offset, float weight)
+{
+  Tap t;
+
+  float x_floor = qFloor(x_offset);
+  float y_floor = qFloor(y_offset);
+
+  t.x = static_cast<int>(x_floor);
+  t.y = static_cast<int>(y_floor);
+  t.fx = x_offset - x_floor;
+  t.fy = y_offset - y_floor;
+  t.weight = weight;
+
+  return t;
+}
+
+CPUPixel CPURenderFunctions::Fetch(const float *data, int width, int height, int x, int y)
+{
+  // Clamp to edge
+  x = clamp(x, 0, width - 1);
+  y = clamp(y, 0, height - 1);
+
+  return CPUPixel::Load(data + (y * width + x) * 4);
+}
+
+CPUPixel CPURenderFunctions::FetchTap(const float *data, int width, int height, int x, int y, const CPURenderFunctions::Tap &tap)
+{
+  x += tap.x;
+  y += tap.y;
+
+  CPUPixel px = Fetch(data, width, height, x, y);
+
+  if (tap.fx > 0.0f) {
+    px = CPUPixel::Mix(px, Fetch(data, width, height, x + 1, y), tap.fx);
+  }
+
+  if (tap.fy > 0.0f) {
+    CPUPixel below = Fetch(data, width, height, x, y + 1);
+
+    if (tap.fx > 0.0f) {
+      below = CPUPixel::Mix(below, Fetch(data, width, height, x + 1, y + 1), tap.fx);
+    }
+
+    px = CPUPixel::Mix(px, below, tap.fy);
+  }
+
+  return px;
+}
+
+float CPURenderFunctions::FetchTapAlpha(const float *data, int width, int height, int x, int y, const CPURenderFunctions::Tap &tap)
+{
+  int x0 = clamp(x + tap.x, 0, width - 1);
+  int x1 = clamp(x + tap.x + 1, 0, width - 1);
+  int y0 = clamp(y + tap.y, 0, height - 1);
+  int y1 = clamp(y + tap.y + 1, 0, height - 1);
+
+  float top = data[(y0 * width + x0) * 4 + 3];
+  top += (data[(y0 * width + x1) * 4 + 3] - top) * tap.fx;
+
+  float bottom = data[(y1 * width + x0) * 4 + 3];
+  bottom += (data[(y1 * width + x1) * 4 + 3] - bottom) * tap.fx;
+
+  return top + (bottom - top) * tap.fy;
+}
+
+CPUPixel CPURenderFunctions::Sample(const float *data, int width, int height, float u, float v)
+{
+  // Texel centers are at half-pixel coordinates. Bound the position first so huge coordinates can't overflow an int,
+  // anything outside the texture is clamped to the edge anyway.
+  float x = qBound(-1.0f, u * width - 0.5f, static_cast<float>(width));
+  float y = qBound(-1.0f, v * height - 0.5f, static_cast<float>(height));
+
+  return FetchTap(data, width, height, 0, 0, MakeTap(x, y, 1.0f));
+}
+
+void CPURenderFunctions::BlurPass(FramePtr dst, FramePtr src, const QVector<CPURenderFunctions::Tap> &taps, bool horizontal, bool repeat_edge_pixels)
+{
+  const float* src_data = reinterpret_cast<const float*>(src->const_data());
+  float* dst_data = reinterpret_cast<float*>(dst->data());
+  int width = src->width();
+  int height = src->height();
+
+  ParallelRows(height, [&](int start, int end){
+    for (int y=start;y<end;y++) {
+      for (int x=0;x<width;x++) {
+        CPUPixel composite;
+
+        foreach (const Tap& tap, taps) {
+          if (!repeat_edge_pixels) {
+            // Skip samples that land outside the texture. Sample positions are relative to texel centers so the
+            // texture's edges are half a texel out.
+            float pos = horizontal ? x + tap.x + tap.fx : y + tap.y + tap.fy;
+            float limit = horizontal ? width : height;
+
+            if (pos < -0.5f || pos >= limit - 0.5f) {
+              continue;
+            }
+          }
+
+          composite += FetchTap(src_data, width, height, x, y, tap) * tap.weight;
+        }
+
+        composite.Store(dst_data + (y * width + x) * 4);
+      }
+    }
+  });
+}
+
+void CPURenderFunctions::RunTiles(CPURenderFunctions::RowTiles *tiles)
+{
+  while (true) {
+    int start = tiles->next.fetchAndAddOrdered(tiles->tile_height);
+
+    if (start >= tiles->height) {
+      break;
+    }
+
+    (*tiles->func)(start, qMin(start + tiles->tile_height, tiles->height));
+  }
+}
+
+CPURenderFunctions::RowHelper::RowHelper(CPURenderFunctions::RowTiles *tiles) :
+  tiles_(tiles)
+{
+}
+
+void CPURenderFunctions::RowHelper::run()
+{
+  RunTiles(tiles_);
+
+  tiles_->helpers_finished.release();
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,184 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef CPURENDERFUNCTIONS_H
+#define CPURENDERFUNCTIONS_H
+
+#include <functional>
+#include <QAtomicInt>
+#include <QMatrix4x4>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QVector2D>
+
+#include "codec/frame.h"
+#include "cpupixel.h"
+#include "render/color.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief CPU equivalents of the shaders used by the OpenGL backend
+ *
+ * All "textures" are RGBA32F frames with associated alpha, the same as the OpenGL backend's textures. Each function
+ * writes into a `dst` frame (usually from CreateTexture()) and mirrors the sampling of its shader: inputs are sampled at
+ * the texture coordinate of each destination pixel's center with bilinear filtering and clamp-to-edge wrapping.
+ * Apart from TransformFootage() and Blit(), inputs are expected to be the same size as `dst` (see MatchSize()).
+ *
+ * Rows are split into tiles and processed across QThreadPool::globalInstance().
+ */
+class CPURenderFunctions {
+public:
+  enum BlurMethod {
+    kBoxBlur,
+    kGaussianBlur
+  };
+
+  /**
+   * @brief Create an RGBA32F frame cleared to transparent black
+   */
+  static FramePtr CreateTexture(int width, int height);
+
+  /**
+   * @brief Convert any frame to an RGBA32F texture, frames without an alpha channel are made opaque
+   */
+  static FramePtr ConvertToTexture(FramePtr frame);
+
+  /**
+   * @brief Returns `src` if it's already `width`x`height`, otherwise a resampled copy of it
+   */
+  static FramePtr MatchSize(FramePtr src, int width, int height);
+
+  /**
+   * @brief Call `func(start_row, end_row)` for tiles of rows in parallel, returning once all rows are done
+   */
+  static void ParallelRows(int height, const std::function<void(int, int)>& func);
+
+  /**
+   * @brief Stretch `src` to fill `dst`
+   */
+  static void Blit(FramePtr dst, FramePtr src);
+
+  /**
+   * @brief Composite `blend` over `base`, either input may be null
+   */
+  static void AlphaOver(FramePtr dst, FramePtr base, FramePtr blend);
+
+  /**
+   * @brief Sum of two weighted textures, either input may be null
+   *
+   * Used for both transitions, the cross dissolve weights the textures by (1.0 - progress) and progress while the dip
+   * to black weights them by the square of the out and in progress.
+   */
+  static void Mix(FramePtr dst, FramePtr a, float a_weight, FramePtr b, float b_weight);
+
+  static void Solid(FramePtr dst, const Color& color);
+
+  /**
+   * @brief Separable box/gaussian blur, `resolution` is the unscaled sequence resolution radii are measured in
+   */
+  static void Blur(FramePtr dst,
+                   FramePtr src,
+                   BlurMethod method,
+                   float radius,
+                   bool horizontal,
+                   bool vertical,
+                   bool repeat_edge_pixels,
+                   const QVector2D& resolution);
+
+  static void DropShadow(FramePtr dst,
+                         FramePtr src,
+                         const Color& color,
+                         float softness,
+                         float opacity,
+                         float distance,
+                         float direction,
+                         const QVector2D& resolution);
+
+  static void Stroke(FramePtr dst,
+                     FramePtr src,
+                     float radius,
+                     float opacity,
+                     bool inner,
+                     const QVector2D& resolution);
+
+  /**
+   * @brief Draw footage into `dst` through a transformation matrix
+   *
+   * Inverse of the videoinput vertex shader: `footage_resolution` is the footage's size in sequence pixels and
+   * `resolution` is the unscaled sequence resolution. Pixels outside the transformed footage are left transparent.
+   */
+  static void TransformFootage(FramePtr dst,
+                               FramePtr src,
+                               const QMatrix4x4& matrix,
+                               const QVector2D& footage_resolution,
+                               const QVector2D& resolution);
+
+private:
+  /**
+   * @brief A sample at a fixed offset from each destination pixel, split into whole texels and a bilinear fraction
+   */
+  struct Tap {
+    int x;
+    int y;
+    float fx;
+    float fy;
+    float weight;
+  };
+
+  static Tap MakeTap(float x_offset, float y_offset, float weight);
+
+  static CPUPixel Fetch(const float* data, int width, int height, int x, int y);
+
+  static CPUPixel FetchTap(const float* data, int width, int height, int x, int y, const Tap& tap);
+
+  static float FetchTapAlpha(const float* data, int width, int height, int x, int y, const Tap& tap);
+
+  static CPUPixel Sample(const float* data, int width, int height, float u, float v);
+
+  static void BlurPass(FramePtr dst, FramePtr src, const QVector<Tap>& taps, bool horizontal, bool repeat_edge_pixels);
+
+  struct RowTiles {
+    const std::function<void(int, int)>* func;
+    int height;
+    int tile_height;
+    QAtomicInt next;
+    QSemaphore helpers_finished;
+  };
+
+  static void RunTiles(RowTiles* tiles);
+
+  class RowHelper : public QRunnable
+  {
+  public:
+    RowHelper(RowTiles* tiles);
+
+    virtual void run() override;
+
+  private:
+    RowTiles* tiles_;
+
+  };
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // CPURENDERFUNCTIONS_H
@@ -0,0 +1,270 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "cpuworker.h"
+
+#include <QDebug>
+#include <QtMath>
+
+#include "cpurenderfunctions.h"
+#include "node/block/transition/transition.h"
+#include "node/node.h"
+#include "project/item/footage/footage.h"
+#include "project/item/footage/imagestream.h"
+#include "project/project.h"
+#include "render/colormanager.h"
+#include "render/pixelformat.h"
+
+OLIVE_NAMESPACE_ENTER
+
+CPUWorker::CPUWorker(VideoRenderFrameCache *frame_cache, QObject *parent) :
+  VideoRenderWorker(frame_cache, parent)
+{
+}
+
+void CPUWorker::FrameToValue(DecoderPtr decoder, StreamPtr stream, const TimeRange &range, NodeValueTable *table)
+{
+  // Ensure stream is video or image type
+  if (stream->type() != Stream::kVideo && stream->type() != Stream::kImage) {
+    return;
+  }
+
+  ImageStreamPtr video_stream = std::static_pointer_cast<ImageStream>(stream);
+
+  // Set up OCIO context
+  QString colorspace_match = QStringLiteral("%1:%2").arg(video_stream->footage()->project()->ocio_config(), video_stream->colorspace());
+
+  if (stream->type() == Stream::kImage && still_image_cache_.Has(stream.get())) {
+    CachedStill cs = still_image_cache_.Get(stream.get());
+
+    if (cs.colorspace == colorspace_match
+        && cs.alpha_is_associated == video_stream->premultiplied_alpha()
+        && cs.divider == video_params().divider()) {
+      table->Push(NodeParam::kTexture, QVariant::fromValue(cs.texture));
+      return;
+    } else {
+      still_image_cache_.Remove(stream.get());
+    }
+  }
+
+  FramePtr frame = decoder->RetrieveVideo(range.in(), video_params().divider());
+
+  if (!frame) {
+    return;
+  }
+
+  ColorProcessorPtr color_processor = color_cache()->Get(colorspace_match);
+
+  if (!color_processor) {
+    color_processor = ColorProcessor::Create(video_stream->footage()->project()->color_manager(),
+                                             video_stream->colorspace(),
+                                             video_stream->footage()->project()->color_manager()->GetReferenceColorSpace());
+    color_cache()->Add(colorspace_match, color_processor);
+  }
+
+  bool has_alpha = PixelFormat::FormatHasAlphaChannel(frame->format());
+  rational sample_aspect_ratio = frame->sample_aspect_ratio();
+
+  // Always use OCIO's CPU path, there's no GPU to fall back on here. This is the same as the OpenGL backend's
+  // "accurate" method.
+  frame = PixelFormat::ConvertPixelFormat(frame, has_alpha ? PixelFormat::PIX_FMT_RGBA32F : PixelFormat::PIX_FMT_RGB32F);
+
+  if (!frame) {
+    return;
+  }
+
+  // If alpha is associated, disassociate for the color transform
+  if (has_alpha && video_stream->premultiplied_alpha()) {
+    ColorManager::DisassociateAlpha(frame);
+  }
+
+  // Perform color transform
+  color_processor->ConvertFrame(frame);
+
+  // Associate alpha
+  if (has_alpha) {
+    if (video_stream->premultiplied_alpha()) {
+      ColorManager::ReassociateAlpha(frame);
+    } else {
+      ColorManager::AssociateAlpha(frame);
+    }
+  }
+
+  FramePtr texture = CPURenderFunctions::ConvertToTexture(frame);
+
+  if (!texture) {
+    return;
+  }
+
+  texture->set_sample_aspect_ratio(sample_aspect_ratio);
+
+  if (stream->type() == Stream::kImage) {
+    // Since this is a still image, we could likely optimize this
+    still_image_cache_.Add(stream.get(), {texture, colorspace_match, video_stream->premultiplied_alpha(), video_params().divider()});
+  }
+
+  table->Push(NodeParam::kTexture, QVariant::fromValue(texture));
+}
+
+void CPUWorker::RunNodeAccelerated(const Node *node, const TimeRange &range, NodeValueDatabase &input_params, NodeValueTable &output_params)
+{
+  if (!(node->GetCapabilities(input_params) & Node::kShader)) {
+    return;
+  }
+
+  QString id = node->id();
+  QVector2D resolution(video_params().width(), video_params().height());
+  FramePtr dst = CPURenderFunctions::CreateTexture(video_params().effective_width(), video_params().effective_height());
+
+  if (id == QStringLiteral("org.olivevideoeditor.Olive.videoinput")) {
+    FramePtr footage = GetInputValue(node, QStringLiteral("footage_in"), input_params).value<FramePtr>();
+
+    if (footage) {
+      // Footage is decoded at the divided resolution, so scale it back up to sequence pixels
+      QVector2D footage_resolution(footage->width() * video_params().divider(),
+                                   footage->height() * video_params().divider());
+
+      // Scale the footage in a way that does not reduce the resolution
+      const rational& sar = footage->sample_aspect_ratio();
+      if (sar > 1) {
+        footage_resolution.setX(footage_resolution.x() * static_cast<float>(sar.toDouble()));
+      } else if (sar != 0 && sar < 1) {
+        footage_resolution.setY(footage_resolution.y() / static_cast<float>(sar.toDouble()));
+      }
+
+      CPURenderFunctions::TransformFootage(dst,
+                                           footage,
+                                           GetInputValue(node, QStringLiteral("matrix_in"), input_params).value<QMatrix4x4>(),
+                                           footage_resolution,
+                                           resolution);
+    }
+  } else if (id == QStringLiteral("org.olivevideoeditor.Olive.alphaoverblend")) {
+    CPURenderFunctions::AlphaOver(dst,
+                                  GetInputTexture(node, QStringLiteral("base_in"), input_params),
+                                  GetInputTexture(node, QStringLiteral("blend_in"), input_params));
+  } else if (id == QStringLiteral("org.olivevideoeditor.Olive.crossdissolve")
+             || id == QStringLiteral("org.olivevideoeditor.Olive.diptoblack")) {
+    const TransitionBlock* transition_node = static_cast<const TransitionBlock*>(node);
+    float out_weight, in_weight;
+
+    if (id == QStringLiteral("org.olivevideoeditor.Olive.crossdissolve")) {
+      in_weight = static_cast<float>(transition_node->GetTotalProgress(range.in()));
+      out_weight = 1.0f - in_weight;
+    } else {
+      out_weight = static_cast<float>(qPow(transition_node->GetOutProgress(range.in()), 2.0));
+      in_weight = static_cast<float>(qPow(transition_node->GetInProgress(range.in()), 2.0));
+    }
+
+    CPURenderFunctions::Mix(dst,
+                            GetInputTexture(node, QStringLiteral("out_block_in"), input_params),
+                            out_weight,
+                            GetInputTexture(node, QStringLiteral("in_block_in"), input_params),
+                            in_weight);
+  } else if (id == QStringLiteral("org.olivevideoeditor.Olive.solidgenerator")) {
+    CPURenderFunctions::Solid(dst, GetInputValue(node, QStringLiteral("color_in"), input_params).value<Color>());
+  } else if (id == QStringLiteral("org.olivevideoeditor.Olive.blur")) {
+    FramePtr tex = GetInputTexture(node, QStringLiteral("tex_in"), input_params);
+
+    if (tex) {
+      CPURenderFunctions::Blur(dst,
+                               tex,
+                               static_cast<CPURenderFunctions::BlurMethod>(GetInputValue(node, QStringLiteral("method_in"), input_params).toInt()),
+                               GetInputValue(node, QStringLiteral("radius_in"), input_params).toFloat(),
+                               GetInputValue(node, QStringLiteral("horiz_in"), input_params).toBool(),
+                               GetInputValue(node, QStringLiteral("vert_in"), input_params).toBool(),
+                               GetInputValue(node, QStringLiteral("repeat_edge_pixels_in"), input_params).toBool(),
+                               resolution);
+    }
+  } else if (id == QStringLiteral("org.olivevideoeditor.Olive.dropshadow")) {
+    FramePtr tex = GetInputTexture(node, QStringLiteral("tex_in"), input_params);
+
+    if (tex) {
+      CPURenderFunctions::DropShadow(dst,
+                                     tex,
+                                     GetInputValue(node, QStringLiteral("color_in"), input_params).value<Color>(),
+                                     GetInputValue(node, QStringLiteral("softness_in"), input_params).toFloat(),
+                                     GetInputValue(node, QStringLiteral("opacity_in"), input_params).toFloat(),
+                                     GetInputValue(node, QStringLiteral("distance_in"), input_params).toFloat(),
+                                     GetInputValue(node, QStringLiteral("direction_in"), input_params).toFloat(),
+                                     resolution);
+    }
+  } else if (id == QStringLiteral("org.olivevideoeditor.Olive.stroke")) {
+    FramePtr tex = GetInputTexture(node, QStringLiteral("tex_in"), input_params);
+
+    if (tex) {
+      CPURenderFunctions::Stroke(dst,
+                                 tex,
+                                 GetInputValue(node, QStringLiteral("radius_in"), input_params).toFloat(),
+                                 GetInputValue(node, QStringLiteral("opacity_in"), input_params).toFloat(),
+                                 GetInputValue(node, QStringLiteral("inner_in"), input_params).toBool(),
+                                 resolution);
+    }
+  } else {
+    if (!unsupported_nodes_.contains(id)) {
+      qWarning() << "CPU renderer has no implementation for" << id;
+      unsupported_nodes_.insert(id);
+    }
+
+    return;
+  }
+
+  output_params.Push(NodeParam::kTexture, QVariant::fromValue(dst));
+}
+
+void CPUWorker::TextureToBuffer(const QVariant &texture, void *buffer)
+{
+  FramePtr frame = texture.value<FramePtr>();
+
+  if (!frame) {
+    return;
+  }
+
+  frame = CPURenderFunctions::MatchSize(frame, video_params().effective_width(), video_params().effective_height());
+  frame = PixelFormat::ConvertPixelFormat(frame, video_params().format());
+
+  if (frame) {
+    memcpy(buffer, frame->const_data(), static_cast<size_t>(frame->allocated_size()));
+  }
+}
+
+QVariant CPUWorker::GetInputValue(const Node *node, const QString &id, NodeValueDatabase &input_params)
+{
+  NodeParam* param = node->GetParameterWithID(id);
+
+  if (!param || param->type() != NodeParam::kInput) {
+    return QVariant();
+  }
+
+  return node->InputValueFromTable(static_cast<NodeInput*>(param), input_params, true).data();
+}
+
+FramePtr CPUWorker::GetInputTexture(const Node *node, const QString &id, NodeValueDatabase &input_params)
+{
+  FramePtr tex = GetInputValue(node, id, input_params).value<FramePtr>();
+
+  if (!tex) {
+    return nullptr;
+  }
+
+  // Kernels expect their inputs to match the output, the same as sampling them at the output's texture coordinates
+  return CPURenderFunctions::MatchSize(tex, video_params().effective_width(), video_params().effective_height());
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,69 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef CPUWORKER_H
+#define CPUWORKER_H
+
+#include <QSet>
+
+#include "../videorenderworker.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Renders entirely on the CPU using CPURenderFunctions
+ *
+ * Textures are FramePtrs in RGBA32F with associated alpha. Nodes are rendered with CPU ports of their shaders, looked
+ * up by Node ID, so nodes that only provide GLSL code are not supported by this worker.
+ */
+class CPUWorker : public VideoRenderWorker {
+  Q_OBJECT
+public:
+  CPUWorker(VideoRenderFrameCache* frame_cache,
+            QObject* parent = nullptr);
+
+protected:
+  virtual void FrameToValue(DecoderPtr decoder, StreamPtr stream, const TimeRange &range, NodeValueTable* table) override;
+
+  virtual void RunNodeAccelerated(const Node *node, const TimeRange &range, NodeValueDatabase &input_params, NodeValueTable& output_params) override;
+
+  virtual void TextureToBuffer(const QVariant& texture, void *buffer) override;
+
+private:
+  static QVariant GetInputValue(const Node* node, const QString& id, NodeValueDatabase& input_params);
+
+  FramePtr GetInputTexture(const Node* node, const QString& id, NodeValueDatabase& input_params);
+
+  struct CachedStill {
+    FramePtr texture;
+    QString colorspace;
+    bool alpha_is_associated;
+    int divider;
+  };
+
+  RenderCache<Stream*, CachedStill> still_image_cache_;
+
+  QSet<QString> unsupported_nodes_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // CPUWORKER_H
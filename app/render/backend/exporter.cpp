@@ -20,13 +20,18 @@
 
 #include "exporter.h"
 
+#include <QThread>
+
 #include "render/backend/audio/audiobackend.h"
-#include "render/backend/opengl/openglbackend.h"
 #include "render/colormanager.h"
 #include "render/pixelformat.h"
 
 OLIVE_NAMESPACE_ENTER
 
+// Rendered frames are full sequence-sized images, so keep only as many around as it takes to keep the renderer and
+// encoder busy. The encoder converts queued frames in parallel so allow more on machines with more cores.
+const int kMaxEncoderQueue = qBound(4, QThread::idealThreadCount() / 2, 16);
+
 Exporter::Exporter(ViewerOutput* viewer,
                    Encoder *encoder,
                    QObject* parent) :
@@ -38,7 +43,9 @@ Exporter::Exporter(ViewerOutput* viewer,
   audio_done_(true),
   encoder_(encoder),
   export_status_(false),
-  export_msg_(tr("Export hasn't started yet"))
+  export_msg_(tr("Export hasn't started yet")),
+  runs_requested_(0),
+  frames_in_encoder_(0)
 {
   debug_timer_.setInterval(5000);
   connect(&debug_timer_, &QTimer::timeout, this, &Exporter::DebugTimerMessage);
@@ -104,7 +111,7 @@ void Exporter::StartExporting()
 
   // Create renderers
   if (!video_done_) {
-    video_backend_ = new OpenGLBackend();
+    video_backend_ = VideoRenderBackend::Create();
 
     video_backend_->SetLimitCaching(false);
     video_backend_->SetViewerNode(viewer_node_);
@@ -128,6 +135,7 @@ void Exporter::StartExporting()
   connect(encoder_, &Encoder::OpenSucceeded, this, &Exporter::EncoderOpenedSuccessfully, Qt::QueuedConnection);
   connect(encoder_, &Encoder::OpenFailed, this, &Exporter::EncoderOpenFailed, Qt::QueuedConnection);
   connect(encoder_, &Encoder::AudioComplete, this, &Exporter::AudioEncodeComplete, Qt::QueuedConnection);
+  connect(encoder_, &Encoder::FrameWritten, this, &Exporter::EncoderWroteFrame, Qt::QueuedConnection);
 
   QMetaObject::invokeMethod(encoder_,
                             "Open",
@@ -167,36 +175,46 @@ void Exporter::ExportStopped()
 
 void Exporter::EncodeFrame()
 {
-  while (cached_frames_.contains(waiting_for_frame_)) {
-    FramePtr frame = cached_frames_.take(waiting_for_frame_);
-
-    // OCIO conversion requires a frame in 32F format
-    if (frame->format() != PixelFormat::PIX_FMT_RGBA32F) {
-      frame = PixelFormat::ConvertPixelFormat(frame, PixelFormat::PIX_FMT_RGBA32F);
-    }
+  if (video_done_) {
+    return;
+  }
 
-    // Color conversion must be done with unassociated alpha, and the pipeline is always associated
-    ColorManager::DisassociateAlpha(frame);
+  while (!export_runs_.isEmpty() && frames_in_encoder_ < kMaxEncoderQueue) {
+    TimeRange run = export_runs_.first();
+    FramePtr frame = rendered_frames_.value(run.in());
 
-    // Convert color space
-    color_processor_->ConvertFrame(frame);
+    if (!frame) {
+      // Still waiting on the renderer
+      break;
+    }
 
-    // Set frame timestamp
-    frame->set_timestamp(waiting_for_frame_);
+    // Every frame in a run shares the same pixel data, they only differ in timestamp
+    FramePtr copy = std::make_shared<Frame>(*frame);
+    copy->set_timestamp(waiting_for_frame_);
 
-    // Encode (may require re-associating alpha?)
     QMetaObject::invokeMethod(encoder_,
                               "WriteFrame",
                               Qt::QueuedConnection,
-                              OLIVE_NS_ARG(FramePtr, frame));
+                              OLIVE_NS_ARG(FramePtr, copy));
+
+    frames_in_encoder_++;
 
     waiting_for_frame_ += video_params_.time_base();
 
+    if (waiting_for_frame_ >= run.out()) {
+      // Finished with this run, make room for the renderer to start on another one
+      rendered_frames_.remove(run.in());
+      export_runs_.removeFirst();
+      runs_requested_--;
+
+      QueueRenders();
+    }
+
     // Calculate progress
     emit ProgressChanged(waiting_for_frame_.toDouble() / viewer_node_->Length().toDouble());
   }
 
-  if (waiting_for_frame_ >= viewer_node_->Length()) {
+  if (export_runs_.isEmpty()) {
     video_done_ = true;
     debug_timer_.stop();
 
@@ -204,25 +222,42 @@ void Exporter::EncodeFrame()
   }
 }
 
-void Exporter::FrameRendered(const rational &time, FramePtr value)
+void Exporter::QueueRenders()
 {
-  debug_timer_.stop();
-
-  const QMap<rational, QByteArray>& time_hash_map = video_backend_->frame_cache()->time_hash_map();
+  // Rendering further ahead than this would only fill memory while the frames wait to be encoded
+  int max_runs_ahead = QThread::idealThreadCount() * 2;
 
-  QByteArray this_hash = time_hash_map.value(time);
+  while (runs_requested_ < export_runs_.size() && runs_requested_ < max_runs_ahead) {
+    video_backend_->RenderFrame(export_runs_.at(runs_requested_).in());
 
-  qDebug() << "Received" << this_hash.toHex();
+    runs_requested_++;
+  }
+}
 
-  QList<rational> matching_times = time_hash_map.keys(this_hash);
+void Exporter::FrameRendered(const rational &time, FramePtr frame)
+{
+  debug_timer_.stop();
 
-  foreach (const rational& t, matching_times) {
-    qDebug() << "  Matches" << t.toDouble();
+  if (!frame) {
+    // Nothing is visible at this time, encode a blank frame
+    frame = Frame::Create();
+    frame->set_video_params(video_backend_->params());
+    frame->allocate();
+    memset(frame->data(), 0, static_cast<size_t>(frame->allocated_size()));
+  }
 
-    cached_frames_.insert(t, value);
+  // OCIO conversion requires a frame in 32F format
+  if (frame->format() != PixelFormat::PIX_FMT_RGBA32F) {
+    frame = PixelFormat::ConvertPixelFormat(frame, PixelFormat::PIX_FMT_RGBA32F);
   }
 
-  qDebug() << "    Waiting for" << waiting_for_frame_.toDouble();
+  // Color conversion must be done with unassociated alpha, and the pipeline is always associated
+  ColorManager::DisassociateAlpha(frame);
+
+  // Convert color space once for the whole run (may require re-associating alpha?)
+  color_processor_->ConvertFrame(frame);
+
+  rendered_frames_.insert(time, frame);
 
   debug_timer_.start();
 
@@ -284,25 +319,48 @@ void Exporter::EncoderClosed()
   ExportStopped();
 }
 
+void Exporter::EncoderWroteFrame()
+{
+  frames_in_encoder_--;
+
+  EncodeFrame();
+}
+
 void Exporter::VideoHashesComplete()
 {
   // We've got our hashes, time to kick off actual rendering
   disconnect(video_backend_, &VideoRenderBackend::QueueComplete, this, &Exporter::VideoHashesComplete);
 
-  // Determine what frames will be hashed
-  TimeRangeList ranges;
-  ranges.append(TimeRange(0, viewer_node_->Length()));
+  // Group consecutive frames with the same hash (e.g. a still image) so each group only needs to be rendered once
+  const QMap<rational, QByteArray>& time_hash_map = video_backend_->frame_cache()->time_hash_map();
+  QByteArray last_hash;
+
+  export_runs_.clear();
+
+  for (rational t=0; t<viewer_node_->Length(); t+=video_params_.time_base()) {
+    rational next = t + video_params_.time_base();
+    QByteArray hash = time_hash_map.value(t);
 
-  // Set video backend to render mode but NOT hash or download
+    if (!export_runs_.isEmpty() && !hash.isEmpty() && hash == last_hash) {
+      export_runs_.last().set_out(next);
+    } else {
+      export_runs_.append(TimeRange(t, next));
+    }
+
+    last_hash = hash;
+  }
+
+  // Set video backend to render mode but NOT hash or download. Rendered frames go straight to us rather than through
+  // the disk cache.
   video_backend_->SetOperatingMode(VideoRenderWorker::kRenderOnly);
   video_backend_->SetOnlySignalLastFrameRequested(false);
 
-  // FIXME: Exporting is now broken because of this
   connect(video_backend_, &VideoRenderBackend::GeneratedFrame, this, &Exporter::FrameRendered);
 
-  foreach (const TimeRange& range, ranges) {
-    video_backend_->InvalidateCache(range);
-  }
+  QueueRenders();
+
+  // Handles an empty sequence
+  EncodeFrame();
 }
 
 void Exporter::DebugTimerMessage()
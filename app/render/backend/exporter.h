@@ -90,6 +90,8 @@ private:
 
   void EncodeFrame();
 
+  void QueueRenders();
+
   ColorProcessorPtr color_processor_;
 
   Encoder* encoder_;
@@ -100,12 +102,34 @@ private:
 
   rational waiting_for_frame_;
 
-  QHash<rational, FramePtr> cached_frames_;
+  /**
+   * @brief Frames left to encode, grouped into runs of consecutive frames with the same hash
+   *
+   * Only the first frame of each run is rendered, the rest of the run is encoded from the same frame.
+   */
+  QList<TimeRange> export_runs_;
+
+  /**
+   * @brief Number of runs at the start of `export_runs_` that have been sent to the renderer
+   */
+  int runs_requested_;
+
+  /**
+   * @brief Rendered frames waiting for their turn to be encoded, keyed by the start of their run
+   *
+   * Bounded by how many runs we let the renderer get ahead of the encoder (see QueueRenders()).
+   */
+  QHash<rational, FramePtr> rendered_frames_;
+
+  /**
+   * @brief Frames sent to the encoder that it hasn't written yet
+   */
+  int frames_in_encoder_;
 
   QTimer debug_timer_;
 
 private slots:
-  void FrameRendered(const rational &time, FramePtr value);
+  void FrameRendered(const rational &time, FramePtr frame);
 
   void AudioRendered();
 
@@ -117,6 +141,8 @@ private slots:
 
   void EncoderClosed();
 
+  void EncoderWroteFrame();
+
   void VideoHashesComplete();
 
   void DebugTimerMessage();
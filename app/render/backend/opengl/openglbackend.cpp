@@ -28,8 +28,7 @@
 OLIVE_NAMESPACE_ENTER
 
 OpenGLBackend::OpenGLBackend(QObject *parent) :
-  VideoRenderBackend(parent),
-  proxy_(nullptr)
+  VideoRenderBackend(parent)
 {
 }
 
@@ -44,32 +43,37 @@ bool OpenGLBackend::InitInternal()
     return false;
   }
 
-  proxy_ = new OpenGLProxy();
-  proxy_->SetParameters(params());
-  QThread* proxy_thread = new QThread();
-  proxy_thread->start(QThread::IdlePriority);
-  proxy_->moveToThread(proxy_thread);
+  // Initiate one thread per CPU core
+  for (int i=0;i<threads().size();i++) {
+    // Each worker gets its own context (along with its own texture, framebuffer and shader caches) so that workers
+    // don't all have to wait on a single OpenGL thread
+    OpenGLProxy* proxy = new OpenGLProxy();
+    proxy->SetParameters(params());
+    QThread* proxy_thread = new QThread();
+    proxy_thread->start(QThread::IdlePriority);
+    proxy->moveToThread(proxy_thread);
 
-  if (!proxy_->Init()) {
-    proxy_thread->quit();
-    proxy_thread->wait();
-    proxy_thread->deleteLater();
+    if (!proxy->Init()) {
+      proxy_thread->quit();
+      proxy_thread->wait();
+      proxy_thread->deleteLater();
 
-    proxy_->deleteLater();
-    proxy_ = nullptr;
-    return false;
-  }
+      proxy->deleteLater();
+
+      CloseProxies();
+      return false;
+    }
+
+    proxies_.append(proxy);
 
-  // Initiate one thread per CPU core
-  for (int i=0;i<threads().size();i++) {
     // Create one processor object for each thread
     OpenGLWorker* processor = new OpenGLWorker(frame_cache());
     processor->SetParameters(params());
     processors_.append(processor);
 
-    connect(processor, &OpenGLWorker::RequestFrameToValue, proxy_, &OpenGLProxy::FrameToValue, Qt::BlockingQueuedConnection);
-    connect(processor, &OpenGLWorker::RequestTextureToBuffer, proxy_, &OpenGLProxy::TextureToBuffer, Qt::BlockingQueuedConnection);
-    connect(processor, &OpenGLWorker::RequestRunNodeAccelerated, proxy_, &OpenGLProxy::RunNodeAccelerated, Qt::BlockingQueuedConnection);
+    connect(processor, &OpenGLWorker::RequestFrameToValue, proxy, &OpenGLProxy::FrameToValue, Qt::BlockingQueuedConnection);
+    connect(processor, &OpenGLWorker::RequestTextureToBuffer, proxy, &OpenGLProxy::TextureToBuffer, Qt::BlockingQueuedConnection);
+    connect(processor, &OpenGLWorker::RequestRunNodeAccelerated, proxy, &OpenGLProxy::RunNodeAccelerated, Qt::BlockingQueuedConnection);
   }
 
   return true;
@@ -77,14 +81,7 @@ bool OpenGLBackend::InitInternal()
 
 void OpenGLBackend::CloseInternal()
 {
-  if (proxy_) {
-    proxy_->thread()->quit();
-    proxy_->thread()->wait();
-    proxy_->thread()->deleteLater();
-
-    proxy_->deleteLater();
-    proxy_ = nullptr;
-  }
+  CloseProxies();
 
   VideoRenderBackend::CloseInternal();
 }
@@ -102,8 +99,23 @@ void OpenGLBackend::ParamsChangedEvent()
 {
   // If we're initiated, we need to recreate the texture. Otherwise this backend isn't active so it doesn't matter.
   if (IsInitiated()) {
-    proxy_->SetParameters(params());
+    foreach (OpenGLProxy* proxy, proxies_) {
+      proxy->SetParameters(params());
+    }
+  }
+}
+
+void OpenGLBackend::CloseProxies()
+{
+  foreach (OpenGLProxy* proxy, proxies_) {
+    proxy->thread()->quit();
+    proxy->thread()->wait();
+    proxy->thread()->deleteLater();
+
+    proxy->deleteLater();
   }
+
+  proxies_.clear();
 }
 
 OLIVE_NAMESPACE_EXIT
@@ -50,7 +50,12 @@ protected:
   virtual void ParamsChangedEvent() override;
 
 private:
-  OpenGLProxy* proxy_;
+  void CloseProxies();
+
+  /**
+   * @brief One proxy (and therefore one OpenGL context) per worker so workers can render in parallel
+   */
+  QVector<OpenGLProxy*> proxies_;
 
 };
 
@@ -20,7 +20,10 @@
 
 #include "openglproxy.h"
 
+#include <QGenericMatrix>
+#include <QOpenGLExtraFunctions>
 #include <QThread>
+#include <QVector3D>
 
 #include "common/clamp.h"
 #include "core.h"
@@ -36,7 +39,8 @@ OLIVE_NAMESPACE_ENTER
 OpenGLProxy::OpenGLProxy(QObject *parent) :
   QObject(parent),
   ctx_(nullptr),
-  functions_(nullptr)
+  functions_(nullptr),
+  yuv_textures_{0, 0, 0}
 {
   surface_.create();
 }
@@ -130,9 +134,19 @@ void OpenGLProxy::FrameToValue(FramePtr frame, StreamPtr stream, NodeValueTable*
       }
     }
 
-    VideoRenderingParams footage_params(frame->width(), frame->height(), frame->format());
+    VideoRenderingParams footage_params;
 
-    footage_tex_ref = texture_cache_.Get(ctx_, footage_params, frame->data());
+    if (frame->is_yuv()) {
+      footage_tex_ref = YUVFrameToTexture(frame);
+
+      footage_params = VideoRenderingParams(footage_tex_ref->texture()->width(),
+                                            footage_tex_ref->texture()->height(),
+                                            video_params_.format());
+    } else {
+      footage_params = VideoRenderingParams(frame->width(), frame->height(), frame->format());
+
+      footage_tex_ref = texture_cache_.Get(ctx_, footage_params, frame->data());
+    }
 
     if (ocio_method == ColorManager::kOCIOFast) {
       if (!color_processor->IsEnabled()) {
@@ -141,8 +155,8 @@ void OpenGLProxy::FrameToValue(FramePtr frame, StreamPtr stream, NodeValueTable*
 
       // Check frame aspect ratio
       if (frame->sample_aspect_ratio() != 1 && frame->sample_aspect_ratio() != 0) {
-        int new_width = frame->width();
-        int new_height = frame->height();
+        int new_width = footage_params.width();
+        int new_height = footage_params.height();
 
         // Scale the frame in a way that does not reduce the resolution
         if (frame->sample_aspect_ratio() > 1) {
@@ -193,6 +207,12 @@ void OpenGLProxy::FrameToValue(FramePtr frame, StreamPtr stream, NodeValueTable*
 
 void OpenGLProxy::Close()
 {
+  if (functions_ && yuv_textures_[0]) {
+    functions_->glDeleteTextures(3, yuv_textures_);
+    yuv_textures_[0] = yuv_textures_[1] = yuv_textures_[2] = 0;
+  }
+
+  yuv_shader_ = nullptr;
   shader_cache_.Clear();
   buffer_.Destroy();
   functions_ = nullptr;
@@ -224,8 +244,15 @@ void OpenGLProxy::RunNodeAccelerated(const Node *node, const TimeRange &range, N
 
     shader = OpenGLShader::Create();
     shader->create();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+    // Every worker has its own context and therefore compiles its own copy of each shader. Where the driver supports
+    // program binaries, this lets the other contexts reuse the first compile instead of compiling from scratch.
+    shader->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, frag_code);
+    shader->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vert_code);
+#else
     shader->addShaderFromSourceCode(QOpenGLShader::Fragment, frag_code);
     shader->addShaderFromSourceCode(QOpenGLShader::Vertex, vert_code);
+#endif
     shader->link();
 
     shader_cache_.Add(node->id(), shader);
@@ -459,6 +486,89 @@ void OpenGLProxy::SetParameters(const VideoRenderingParams &params)
   }
 }
 
+OpenGLTextureCache::ReferencePtr OpenGLProxy::YUVFrameToTexture(FramePtr frame)
+{
+  QOpenGLExtraFunctions* xf = ctx_->extraFunctions();
+
+  if (!yuv_shader_) {
+    yuv_shader_ = OpenGLShader::Create();
+    yuv_shader_->addShaderFromSourceCode(QOpenGLShader::Vertex, OpenGLShader::CodeDefaultVertex());
+    yuv_shader_->addShaderFromSourceCode(QOpenGLShader::Fragment, Node::ReadFileAsString(":/shaders/yuv2rgb.frag"));
+    yuv_shader_->link();
+
+    xf->glGenTextures(3, yuv_textures_);
+  }
+
+  // Planes are tightly packed, so rows can be any number of bytes long
+  xf->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  // Upload each plane as its own single channel texture, the Y plane ends up on unit 0 which Blit() samples from
+  for (int i=2; i>=0; i--) {
+    xf->glActiveTexture(GL_TEXTURE0 + i);
+    xf->glBindTexture(GL_TEXTURE_2D, yuv_textures_[i]);
+    xf->glTexImage2D(GL_TEXTURE_2D, 0, GL_R8,
+                     frame->yuv_plane_width(i), frame->yuv_plane_height(i),
+                     0, GL_RED, GL_UNSIGNED_BYTE, frame->yuv_plane(i));
+
+    // Mipmaps keep downscaling to the divider smooth
+    xf->glGenerateMipmap(GL_TEXTURE_2D);
+    xf->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    xf->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    xf->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    xf->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+
+  xf->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  // Luma weights of the colorspace's red and blue primaries
+  const Frame::YUVLayout& layout = frame->yuv_layout();
+  float kr = layout.rec709 ? 0.2126f : 0.299f;
+  float kb = layout.rec709 ? 0.0722f : 0.114f;
+  float kg = 1.0f - kr - kb;
+
+  // Limited range puts black at 16 and white at 235 (240 for chroma) instead of using all 256 values
+  float y_scale = layout.full_range ? 1.0f : 255.0f / 219.0f;
+  float c_scale = layout.full_range ? 1.0f : 255.0f / 224.0f;
+
+  const float matrix_values[] = {
+    y_scale, 0.0f,                                  c_scale * 2.0f * (1.0f - kr),
+    y_scale, -c_scale * 2.0f * kb * (1.0f - kb) / kg, -c_scale * 2.0f * kr * (1.0f - kr) / kg,
+    y_scale, c_scale * 2.0f * (1.0f - kb),          0.0f
+  };
+
+  OpenGLTextureCache::ReferencePtr dest = texture_cache_.Get(ctx_, VideoRenderingParams(frame->width() / video_params_.divider(),
+                                                                                         frame->height() / video_params_.divider(),
+                                                                                         video_params_.format()));
+
+  buffer_.Attach(dest->texture(), true);
+  buffer_.Bind();
+
+  functions_->glViewport(0, 0, dest->texture()->width(), dest->texture()->height());
+
+  yuv_shader_->bind();
+  yuv_shader_->setUniformValue("yuv_cb", 1);
+  yuv_shader_->setUniformValue("yuv_cr", 2);
+  yuv_shader_->setUniformValue("yuv_offset", QVector3D(layout.full_range ? 0.0f : 16.0f / 255.0f,
+                                                       128.0f / 255.0f,
+                                                       128.0f / 255.0f));
+  yuv_shader_->setUniformValue("yuv_matrix", QMatrix3x3(matrix_values));
+
+  OpenGLRenderFunctions::Blit(yuv_shader_);
+
+  yuv_shader_->release();
+
+  buffer_.Release();
+  buffer_.Detach();
+
+  // Unbind planes so they don't leak into later draws
+  for (int i=2; i>=0; i--) {
+    xf->glActiveTexture(GL_TEXTURE0 + i);
+    xf->glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  return dest;
+}
+
 void OpenGLProxy::FinishInit()
 {
   // Make context current on that surface
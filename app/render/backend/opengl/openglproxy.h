@@ -96,6 +96,15 @@ private:
 
   RenderCache<Stream*, CachedStill> still_image_cache_;
 
+  /**
+   * @brief Upload a Y'CbCr frame's planes and convert them to an RGB texture at the current divider
+   */
+  OpenGLTextureCache::ReferencePtr YUVFrameToTexture(FramePtr frame);
+
+  OpenGLShaderPtr yuv_shader_;
+
+  GLuint yuv_textures_[3];
+
 private slots:
   void FinishInit();
 
@@ -38,7 +38,10 @@ OpenGLWorker::OpenGLWorker(VideoRenderFrameCache *frame_cache, QObject *parent)
 
 void OpenGLWorker::FrameToValue(DecoderPtr decoder, StreamPtr stream, const TimeRange &range, NodeValueTable *table)
 {
-  FramePtr frame = decoder->RetrieveVideo(range.in(), video_params().divider());
+  // Y'CbCr can be converted in a shader, but only if OCIO is also going to run on the GPU
+  bool allow_yuv = (ColorManager::GetOCIOMethodForMode(video_params().mode()) == ColorManager::kOCIOFast);
+
+  FramePtr frame = decoder->RetrieveVideo(range.in(), video_params().divider(), allow_yuv);
 
   if (frame) {
     emit RequestFrameToValue(frame, stream, table);
@@ -21,6 +21,7 @@
 #include "renderbackend.h"
 
 #include <QDateTime>
+#include <QSet>
 #include <QThread>
 
 #include "core.h"
@@ -35,8 +36,7 @@ RenderBackend::RenderBackend(QObject *parent) :
   started_(false),
   viewer_node_(nullptr),
   copied_viewer_node_(nullptr),
-  recompile_queued_(false),
-  input_update_queued_(false)
+  copies_may_be_unused_(false)
 {
   // FIXME: Don't create in CLI mode
   cancel_dialog_ = new RenderCancelDialog(Core::instance()->main_window());
@@ -144,27 +144,12 @@ bool RenderBackend::Compile()
     return true;
   }
 
-  // Get dependencies of viewer node
-  source_node_list_.append(viewer_node_);
-  source_node_list_.append(viewer_node_->GetDependencies());
+  // Copy the viewer and everything it depends on
+  copied_viewer_node_ = static_cast<ViewerOutput*>(CopyNodeIntoGraph(viewer_node_));
 
-  // Copy all dependencies into graph
-  foreach (Node* n, source_node_list_) {
-    Node* copy = n->copy();
-
-    Node::CopyInputs(n, copy, false);
-
-    copied_graph_.AddNode(copy);
-  }
-
-  // We just copied the inputs, so if an input update is queued, it's unnecessary
-  input_update_queued_ = false;
-
-  // We know that the first node will be the viewer node since we appended that first in the copy
-  copied_viewer_node_ = static_cast<ViewerOutput*>(copied_graph_.nodes().first());
-
-  // Copy connections
-  Node::DuplicateConnectionsBetweenLists(source_node_list_, copied_graph_.nodes());
+  // We just copied everything, so anything in the journal is already up to date
+  changed_inputs_.clear();
+  copies_may_be_unused_ = false;
 
   compiled_ = CompileInternal();
 
@@ -183,9 +168,18 @@ void RenderBackend::Decompile()
 
   DecompileInternal();
 
+  // Stop journaling changes to the source graph
+  for (QHash<Node*, Node*>::const_iterator i=copied_nodes_.constBegin(); i!=copied_nodes_.constEnd(); i++) {
+    DisconnectSource(i.key());
+  }
+
+  copied_nodes_.clear();
+  changed_inputs_.clear();
+  orphaned_copies_.clear();
+  copies_may_be_unused_ = false;
+
   copied_graph_.Clear();
   copied_viewer_node_ = nullptr;
-  source_node_list_.clear();
 
   compiled_ = false;
 }
@@ -251,6 +245,17 @@ void RenderBackend::DisconnectViewer(ViewerOutput *node)
   Q_UNUSED(node)
 }
 
+void RenderBackend::NodeCopiedEvent(Node *source, Node *copy)
+{
+  Q_UNUSED(source)
+  Q_UNUSED(copy)
+}
+
+void RenderBackend::NodeCopyRemovedEvent(Node *copy)
+{
+  Q_UNUSED(copy)
+}
+
 void RenderBackend::CacheNext()
 {
   if (cache_queue_.isEmpty()) {
@@ -267,29 +272,15 @@ void RenderBackend::CacheNext()
     return;
   }
 
-  if ((input_update_queued_ || recompile_queued_) && !AllProcessorsAreAvailable()) {
+  if ((!changed_inputs_.isEmpty() || !orphaned_copies_.isEmpty()) && !AllProcessorsAreAvailable()) {
     return;
   }
 
-  if (recompile_queued_) {
-    Decompile();
-    recompile_queued_ = false;
-  }
-
   if (!compiled_ && !Compile()) {
     return;
   }
 
-  if (input_update_queued_) {
-    for (int i=0;i<source_node_list_.size();i++) {
-      Node* src = source_node_list_.at(i);
-      Node* dst = copied_graph_.nodes().at(i);
-
-      Node::CopyInputs(src, dst, false);
-    }
-
-    input_update_queued_ = false;
-  }
+  ApplyGraphChanges();
 
   Node* node_connected_to_viewer = GetDependentInput()->get_connected_node();
 
@@ -371,9 +362,6 @@ void RenderBackend::InvalidateCache(const TimeRange &range)
            << "and"
            << end_range_adj.toDouble();
 
-  // Queue value update
-  QueueValueUpdate();
-
   InvalidateCacheInternal(start_range_adj, end_range_adj);
 }
 
@@ -387,11 +375,6 @@ const QString &RenderBackend::cache_id() const
   return cache_id_;
 }
 
-void RenderBackend::QueueValueUpdate()
-{
-  input_update_queued_ = true;
-}
-
 bool RenderBackend::WorkerIsBusy(RenderWorker *worker) const
 {
   return processor_busy_state_.at(processors_.indexOf(worker));
@@ -455,11 +438,6 @@ void RenderBackend::InitWorkers()
   processor_busy_state_.fill(false);
 }
 
-void RenderBackend::QueueRecompile()
-{
-  recompile_queued_ = true;
-}
-
 void RenderBackend::FootageUnavailable(StreamPtr stream, Decoder::RetrieveState state, const TimeRange &range, const rational &stream_time)
 {
   if (state == Decoder::kFailedToOpen){
@@ -537,6 +515,218 @@ void RenderBackend::IndexUpdated(Stream* stream)
   }
 }
 
+void RenderBackend::SourceInputValueChanged(NodeInput *input)
+{
+  JournalInputChange(input, false);
+}
+
+void RenderBackend::SourceEdgeChanged(NodeEdgePtr edge)
+{
+  JournalInputChange(edge->input(), true);
+}
+
+void RenderBackend::SourceArraySizeChanged()
+{
+  // Resizing an array removes the connections of any elements that no longer exist
+  JournalInputChange(static_cast<NodeInput*>(sender()), true);
+}
+
+void RenderBackend::SourceNodeDestroyed(QObject *node)
+{
+  // The node is mid-destruction so only its address can be used. Its copy may still be in use by a worker, so it's
+  // deleted the next time the graph is synced.
+  Node* source = static_cast<Node*>(node);
+
+  Node* copy = copied_nodes_.take(source);
+
+  if (copy) {
+    orphaned_copies_.append(copy);
+  }
+
+  changed_inputs_.remove(source);
+}
+
+Node *RenderBackend::CopyNodeIntoGraph(Node *source)
+{
+  Node* copy = copied_nodes_.value(source);
+
+  if (copy) {
+    return copy;
+  }
+
+  copy = source->copy();
+
+  Node::CopyInputs(source, copy, false);
+
+  copied_graph_.AddNode(copy);
+  copied_nodes_.insert(source, copy);
+
+  // Journal any changes to this node so its copy can be kept in sync
+  connect(source, &Node::InputValueChanged, this, &RenderBackend::SourceInputValueChanged);
+  connect(source, &Node::EdgeAdded, this, &RenderBackend::SourceEdgeChanged);
+  connect(source, &Node::EdgeRemoved, this, &RenderBackend::SourceEdgeChanged);
+  connect(source, &QObject::destroyed, this, &RenderBackend::SourceNodeDestroyed);
+
+  NodeCopiedEvent(source, copy);
+
+  // Copy connections, pulling in whatever this node depends on
+  const QList<NodeParam*>& src_params = source->parameters();
+  const QList<NodeParam*>& dst_params = copy->parameters();
+
+  for (int i=0;i<src_params.size();i++) {
+    if (src_params.at(i)->type() == NodeParam::kInput) {
+      NodeInput* src_input = static_cast<NodeInput*>(src_params.at(i));
+
+      if (src_input->IsArray()) {
+        connect(static_cast<NodeInputArray*>(src_input), &NodeInputArray::SizeChanged,
+                this, &RenderBackend::SourceArraySizeChanged);
+      }
+
+      CopyConnections(src_input, static_cast<NodeInput*>(dst_params.at(i)));
+    }
+  }
+
+  return copy;
+}
+
+void RenderBackend::CopyConnections(NodeInput *source, NodeInput *dest)
+{
+  NodeOutput* src_output = source->get_connected_output();
+  NodeOutput* dst_output = nullptr;
+
+  if (src_output) {
+    Node* output_copy = CopyNodeIntoGraph(src_output->parentNode());
+
+    dst_output = static_cast<NodeOutput*>(output_copy->parameters().at(src_output->index()));
+  }
+
+  if (dest->get_connected_output() != dst_output) {
+    if (dest->IsConnected()) {
+      NodeParam::DisconnectEdge(dest->edges().first());
+    }
+
+    if (dst_output) {
+      NodeParam::ConnectEdge(dst_output, dest);
+    }
+  }
+
+  // If inputs are arrays, copy their connections too
+  if (source->IsArray()) {
+    NodeInputArray* src_array = static_cast<NodeInputArray*>(source);
+    NodeInputArray* dst_array = static_cast<NodeInputArray*>(dest);
+
+    for (int i=0;i<src_array->GetSize();i++) {
+      CopyConnections(src_array->At(i), dst_array->At(i));
+    }
+  }
+}
+
+void RenderBackend::ApplyGraphChanges()
+{
+  for (QHash<Node*, QHash<NodeInput*, bool> >::const_iterator i=changed_inputs_.constBegin();
+       i!=changed_inputs_.constEnd();
+       i++) {
+    Node* copy = copied_nodes_.value(i.key());
+
+    for (QHash<NodeInput*, bool>::const_iterator j=i.value().constBegin(); j!=i.value().constEnd(); j++) {
+      NodeInput* src = j.key();
+      NodeInput* dst = static_cast<NodeInput*>(copy->parameters().at(src->index()));
+
+      // This also resizes arrays so their elements line up before connections are copied
+      NodeInput::CopyValues(src, dst, false);
+
+      if (j.value()) {
+        CopyConnections(src, dst);
+        copies_may_be_unused_ = true;
+      }
+    }
+  }
+
+  changed_inputs_.clear();
+
+  RemoveUnusedCopies();
+}
+
+void RenderBackend::RemoveUnusedCopies()
+{
+  if (orphaned_copies_.isEmpty() && !copies_may_be_unused_) {
+    return;
+  }
+
+  QList<Node*> unused = orphaned_copies_;
+
+  if (copies_may_be_unused_) {
+    // Anything the viewer no longer depends on can go, it'll be copied again if it's ever reconnected
+    QSet<Node*> used;
+
+    used.insert(copied_viewer_node_);
+
+    foreach (Node* dep, copied_viewer_node_->GetDependencies()) {
+      used.insert(dep);
+    }
+
+    QHash<Node*, Node*>::iterator i = copied_nodes_.begin();
+
+    while (i != copied_nodes_.end()) {
+      if (used.contains(i.value())) {
+        i++;
+      } else {
+        DisconnectSource(i.key());
+        changed_inputs_.remove(i.key());
+        unused.append(i.value());
+        i = copied_nodes_.erase(i);
+      }
+    }
+  }
+
+  foreach (Node* copy, unused) {
+    NodeCopyRemovedEvent(copy);
+
+    // We own every copy, even ones whose source was flagged as not deletable
+    copy->SetCanBeDeleted(true);
+    copied_graph_.TakeNode(copy);
+    delete copy;
+  }
+
+  orphaned_copies_.clear();
+  copies_may_be_unused_ = false;
+}
+
+void RenderBackend::DisconnectSource(Node *source)
+{
+  disconnect(source, &Node::InputValueChanged, this, &RenderBackend::SourceInputValueChanged);
+  disconnect(source, &Node::EdgeAdded, this, &RenderBackend::SourceEdgeChanged);
+  disconnect(source, &Node::EdgeRemoved, this, &RenderBackend::SourceEdgeChanged);
+  disconnect(source, &QObject::destroyed, this, &RenderBackend::SourceNodeDestroyed);
+
+  foreach (NodeParam* param, source->parameters()) {
+    if (param->type() == NodeParam::kInput && static_cast<NodeInput*>(param)->IsArray()) {
+      disconnect(static_cast<NodeInputArray*>(param), &NodeInputArray::SizeChanged,
+                 this, &RenderBackend::SourceArraySizeChanged);
+    }
+  }
+}
+
+void RenderBackend::JournalInputChange(NodeInput *input, bool connections)
+{
+  // Changes to array elements are journaled as changes to the whole array
+  NodeInputArray* array = qobject_cast<NodeInputArray*>(input->parent());
+
+  if (array) {
+    input = array;
+  }
+
+  Node* source = input->parentNode();
+
+  if (!copied_nodes_.contains(source)) {
+    return;
+  }
+
+  QHash<NodeInput*, bool>& node_changes = changed_inputs_[source];
+
+  node_changes.insert(input, node_changes.value(input) || connections);
+}
+
 bool RenderBackend::FootageWaitInfo::operator==(const RenderBackend::FootageWaitInfo &rhs) const
 {
   return rhs.stream == stream
@@ -94,6 +94,16 @@ protected:
   virtual void ConnectViewer(ViewerOutput* node);
   virtual void DisconnectViewer(ViewerOutput* node);
 
+  /**
+   * @brief Called whenever a node from the viewer's graph has been copied into copied_graph_
+   */
+  virtual void NodeCopiedEvent(Node* source, Node* copy);
+
+  /**
+   * @brief Called just before a copy is removed from copied_graph_ and deleted
+   */
+  virtual void NodeCopyRemovedEvent(Node* copy);
+
   /**
    * @brief Function called when there are frames in the queue to cache
    *
@@ -111,8 +121,6 @@ protected:
 
   const QString& cache_id() const;
 
-  void QueueValueUpdate();
-
   bool AllProcessorsAreAvailable() const;
   bool WorkerIsBusy(RenderWorker* worker) const;
   void SetWorkerBusyState(RenderWorker* worker, bool busy);
@@ -125,14 +133,67 @@ protected:
 
   QHash<TimeRange, qint64> render_job_info_;
 
-  QList<Node*> source_node_list_;
-
   NodeGraph copied_graph_;
 
-protected slots:
-  void QueueRecompile();
-
 private:
+  /**
+   * @brief Return the copy of `source` in copied_graph_, copying it (and anything it depends on) if necessary
+   */
+  Node* CopyNodeIntoGraph(Node* source);
+
+  /**
+   * @brief Make `dest` (in copied_graph_) connected to the copy of whatever `source` is connected to
+   *
+   * Includes the elements of array inputs. Assumes array inputs are already the same size.
+   */
+  void CopyConnections(NodeInput* source, NodeInput* dest);
+
+  /**
+   * @brief Bring copied_graph_ up to date with every change recorded in the journal since it was last synced
+   *
+   * Only the inputs that changed are copied, so this is proportional to the size of the change rather than the size
+   * of the graph.
+   */
+  void ApplyGraphChanges();
+
+  /**
+   * @brief Record that `input` (on a node that's been copied) has changed
+   */
+  void JournalInputChange(NodeInput* input, bool connections);
+
+  /**
+   * @brief Delete copies whose source has been destroyed and any copies the viewer no longer depends on
+   */
+  void RemoveUnusedCopies();
+
+  /**
+   * @brief Stop journaling changes to `source`
+   */
+  void DisconnectSource(Node* source);
+
+  /**
+   * @brief Map of nodes from the viewer's graph to their copies in copied_graph_
+   */
+  QHash<Node*, Node*> copied_nodes_;
+
+  /**
+   * @brief Journal of inputs that have changed since copied_graph_ was last synced
+   *
+   * Grouped by node so entries can be dropped if the node is deleted. Each input is mapped to whether its connections
+   * changed too (rather than just its values).
+   */
+  QHash<Node*, QHash<NodeInput*, bool> > changed_inputs_;
+
+  /**
+   * @brief Copies whose source has been destroyed, deleted the next time copied_graph_ is synced
+   */
+  QList<Node*> orphaned_copies_;
+
+  /**
+   * @brief Set when connections have changed, meaning some copies may no longer be used by the viewer
+   */
+  bool copies_may_be_unused_;
+
   /**
    * @brief Internal list of RenderProcessThreads
    */
@@ -160,9 +221,6 @@ private:
 
   QString cache_id_;
 
-  bool recompile_queued_;
-  bool input_update_queued_;
-
   QVector<bool> processor_busy_state_;
 
   RenderCancelDialog* cancel_dialog_;
@@ -182,6 +240,14 @@ private slots:
 
   void IndexUpdated(Stream *stream);
 
+  void SourceInputValueChanged(NodeInput* input);
+
+  void SourceEdgeChanged(NodeEdgePtr edge);
+
+  void SourceArraySizeChanged();
+
+  void SourceNodeDestroyed(QObject* node);
+
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -29,8 +29,10 @@
 
 #include "common/timecodefunctions.h"
 #include "config/config.h"
+#include "cpu/cpubackend.h"
+#include "opengl/openglbackend.h"
 #include "render/diskmanager.h"
-#include "render/diskmanager.h"
+#include "render/memorymanager.h"
 #include "render/pixelformat.h"
 #include "videorenderworker.h"
 
@@ -39,6 +41,7 @@ OLIVE_NAMESPACE_ENTER
 VideoRenderBackend::VideoRenderBackend(QObject *parent) :
   RenderBackend(parent),
   operating_mode_(VideoRenderWorker::kHashRenderCache),
+  last_invalidation_time_(0),
   only_signal_last_frame_requested_(true),
   limit_caching_(true),
   pop_toggle_(false)
@@ -46,17 +49,24 @@ VideoRenderBackend::VideoRenderBackend(QObject *parent) :
   connect(DiskManager::instance(), &DiskManager::DeletedFrame, this, &VideoRenderBackend::FrameRemovedFromDiskCache);
 }
 
+VideoRenderBackend *VideoRenderBackend::Create(QObject *parent)
+{
+  if (Config::Current()["UseCPURenderer"].toBool()) {
+    return new CPUBackend(parent);
+  }
+
+  return new OpenGLBackend(parent);
+}
+
 void VideoRenderBackend::ConnectViewer(ViewerOutput *node)
 {
   connect(node, &ViewerOutput::VideoChangedBetween, this, &VideoRenderBackend::InvalidateCache);
-  connect(node, &ViewerOutput::VideoGraphChanged, this, &VideoRenderBackend::QueueRecompile);
   connect(node, &ViewerOutput::LengthChanged, this, &VideoRenderBackend::TruncateFrameCacheLength);
 }
 
 void VideoRenderBackend::DisconnectViewer(ViewerOutput *node)
 {
   disconnect(node, &ViewerOutput::VideoChangedBetween, this, &VideoRenderBackend::InvalidateCache);
-  disconnect(node, &ViewerOutput::VideoGraphChanged, this, &VideoRenderBackend::QueueRecompile);
   disconnect(node, &ViewerOutput::LengthChanged, this, &VideoRenderBackend::TruncateFrameCacheLength);
 
   frame_cache_.Clear();
@@ -97,6 +107,13 @@ void VideoRenderBackend::SetOperatingMode(const VideoRenderWorker::OperatingMode
   }
 }
 
+void VideoRenderBackend::RenderFrame(const rational &time)
+{
+  invalidated_.InsertTimeRange(TimeRange(time, time + params_.time_base()));
+
+  Requeue();
+}
+
 void VideoRenderBackend::SetOnlySignalLastFrameRequested(bool enabled)
 {
   only_signal_last_frame_requested_ = enabled;
@@ -153,6 +170,8 @@ void VideoRenderBackend::InvalidateCacheInternal(const rational &start_range, co
 
   invalidated_.InsertTimeRange(invalidated);
 
+  last_invalidation_time_ = QDateTime::currentMSecsSinceEpoch();
+
   emit RangeInvalidated(invalidated);
 
   Requeue();
@@ -163,35 +182,59 @@ VideoRenderFrameCache *VideoRenderBackend::frame_cache()
   return &frame_cache_;
 }
 
-QString VideoRenderBackend::GetCachedFrame(const rational &time)
+bool VideoRenderBackend::GetCachedFrame(const rational &time, FramePtr *frame)
 {
   UpdateLastRequestedTime(time);
 
   if (viewer_node() == nullptr) {
     // Nothing is connected - nothing to show or render
-    return nullptr;
+    return false;
   }
 
   if (cache_id().isEmpty()) {
     qWarning() << "No cache ID";
-    return nullptr;
+    return false;
   }
 
   if (!params_.is_valid()) {
     qWarning() << "Invalid parameters";
-    return nullptr;
+    return false;
   }
 
   // Find frame in map
   QByteArray frame_hash = frame_cache_.TimeToHash(time);
 
-  if (!frame_hash.isEmpty()) {
-    DiskManager::instance()->Accessed(frame_hash);
+  if (frame_hash.isEmpty()) {
+    return false;
+  }
+
+  DiskManager::instance()->Accessed(frame_hash);
+
+  // Try memory first and fall back to the disk cache
+  *frame = MemoryManager::instance()->Get(frame_hash);
 
-    return frame_cache_.CachePathName(frame_hash, params_.format());
+  if (!*frame) {
+    *frame = VideoRenderFrameCache::LoadCacheFrame(frame_cache_.CachePathName(frame_hash, params_.format()));
+
+    if (*frame) {
+      MemoryManager::instance()->Insert(frame_hash, *frame);
+    }
   }
 
-  return QString();
+  return true;
+}
+
+void VideoRenderBackend::PrefetchCachedFrame(const rational &time)
+{
+  if (!params_.is_valid()) {
+    return;
+  }
+
+  QByteArray frame_hash = frame_cache_.TimeToHash(time);
+
+  if (!frame_hash.isEmpty()) {
+    MemoryManager::instance()->Prefetch(frame_hash, frame_cache_.CachePathName(frame_hash, params_.format()));
+  }
 }
 
 void VideoRenderBackend::UpdateLastRequestedTime(const rational &time)
@@ -258,16 +301,13 @@ TimeRange VideoRenderBackend::PopNextFrameFromQueue()
   return TimeRange(frame_range.in(), frame_range.in());
 }
 
-void VideoRenderBackend::ThreadCompletedDownload(NodeDependency dep, qint64 job_time, QByteArray hash, bool texture_existed)
+void VideoRenderBackend::ThreadCompletedDownload(NodeDependency dep, qint64 job_time, QByteArray hash, TimeRange static_range, bool texture_existed)
 {
   SetWorkerBusyState(static_cast<RenderWorker*>(sender()), false);
 
-  SetFrameHash(dep, hash, job_time);
+  Q_UNUSED(texture_existed)
 
-  // Register frame with the disk manager
-  if (texture_existed && operating_mode_ & VideoRenderWorker::kDownloadOnly) {
-    DiskManager::instance()->CreatedFile(frame_cache()->CachePathName(hash, params_.format()), hash);
-  }
+  SetFrameHash(dep, hash, static_range, job_time);
 
   QList<rational> hashes_with_time = frame_cache()->FramesWithHash(hash);
 
@@ -279,25 +319,33 @@ void VideoRenderBackend::ThreadCompletedDownload(NodeDependency dep, qint64 job_
   CacheNext();
 }
 
-void VideoRenderBackend::ThreadSkippedFrame(NodeDependency dep, qint64 job_time, QByteArray hash)
+void VideoRenderBackend::ThreadSkippedFrame(NodeDependency dep, qint64 job_time, QByteArray hash, TimeRange static_range)
 {
   SetWorkerBusyState(static_cast<RenderWorker*>(sender()), false);
 
-  if (SetFrameHash(dep, hash, job_time)
+  QList<rational> times_set;
+
+  if (SetFrameHash(dep, hash, static_range, job_time, &times_set)
       && frame_cache_.HasHash(hash, params_.format())) {
-    emit CachedTimeReady(dep.in(), job_time);
+    foreach (const rational& t, times_set) {
+      emit CachedTimeReady(t, job_time);
+    }
   }
 
   // Queue up a new frame for this worker
   CacheNext();
 }
 
-void VideoRenderBackend::ThreadHashAlreadyExists(NodeDependency dep, qint64 job_time, QByteArray hash)
+void VideoRenderBackend::ThreadHashAlreadyExists(NodeDependency dep, qint64 job_time, QByteArray hash, TimeRange static_range)
 {
   SetWorkerBusyState(static_cast<RenderWorker*>(sender()), false);
 
-  if (SetFrameHash(dep, hash, job_time)) {
-    emit CachedTimeReady(dep.in(), job_time);
+  QList<rational> times_set;
+
+  if (SetFrameHash(dep, hash, static_range, job_time, &times_set)) {
+    foreach (const rational& t, times_set) {
+      emit CachedTimeReady(t, job_time);
+    }
   }
 
   // Queue up a new frame for this worker
@@ -339,6 +387,10 @@ void VideoRenderBackend::FrameRemovedFromDiskCache(const QByteArray &hash)
 
     emit RangeInvalidated(invalidated);
   }
+
+  if (!deleted_frames.isEmpty()) {
+    last_invalidation_time_ = QDateTime::currentMSecsSinceEpoch();
+  }
 }
 
 bool VideoRenderBackend::TimeIsQueued(const TimeRange &time) const
@@ -351,16 +403,61 @@ bool VideoRenderBackend::JobIsCurrent(const NodeDependency &dep, const qint64& j
   return (render_job_info_.value(dep.range()) == job_time && !TimeIsQueued(dep.range()));
 }
 
-bool VideoRenderBackend::SetFrameHash(const NodeDependency &dep, const QByteArray &hash, const qint64& job_time)
+bool VideoRenderBackend::SetFrameHash(const NodeDependency &dep, const QByteArray &hash, const TimeRange &static_range, const qint64& job_time, QList<rational>* times_set)
 {
-  if (JobIsCurrent(dep, job_time)) {
-    frame_cache_.SetHash(dep.in(), hash);
-    render_job_info_.remove(dep.range());
+  if (!JobIsCurrent(dep, job_time)) {
+    return false;
+  }
+
+  frame_cache_.SetHash(dep.in(), hash);
+  render_job_info_.remove(dep.range());
 
+  if (times_set) {
+    times_set->append(dep.in());
+  }
+
+  // If nothing has changed since this job started, every other frame in its static range will have the same hash so
+  // we can set them all now rather than hashing (and possibly rendering) each one
+  if (hash.isEmpty()
+      || static_range.length() == 0
+      || job_time <= last_invalidation_time_) {
     return true;
   }
 
-  return false;
+  const rational& timebase = params_.time_base();
+
+  TimeRangeList ranges = invalidated_.Intersects(static_range);
+
+  foreach (const TimeRange& r, ranges) {
+    // Find the first frame that starts inside this range
+    int64_t ts = Timecode::time_to_timestamp(r.in(), timebase);
+
+    if (Timecode::timestamp_to_time(ts, timebase) < r.in()) {
+      ts++;
+    }
+
+    rational first_frame = Timecode::timestamp_to_time(ts, timebase);
+    rational frame = first_frame;
+
+    if (frame >= r.out()) {
+      continue;
+    }
+
+    for (; frame<r.out(); frame=Timecode::timestamp_to_time(++ts, timebase)) {
+      frame_cache_.SetHash(frame, hash);
+
+      if (times_set && frame != dep.in()) {
+        times_set->append(frame);
+      }
+    }
+
+    TimeRange filled(first_frame, frame);
+
+    invalidated_.RemoveTimeRange(filled);
+    cache_queue_.RemoveTimeRange(filled);
+  }
+
+  return true;
 }
 
 void VideoRenderBackend::Requeue()
@@ -48,6 +48,11 @@ public:
    */
   VideoRenderBackend(QObject* parent = nullptr);
 
+  /**
+   * @brief Create the video backend chosen in the user's configuration ("UseCPURenderer")
+   */
+  static VideoRenderBackend* Create(QObject* parent = nullptr);
+
   /**
    * @brief Set parameters of the Renderer
    *
@@ -58,13 +63,36 @@ public:
 
   void SetOperatingMode(const VideoRenderWorker::OperatingMode& mode);
 
+  /**
+   * @brief Queue a single frame to be rendered
+   *
+   * Unlike InvalidateCache(), this doesn't signal that anything has changed or resync the graph, so it's only suitable
+   * for re-rendering frames when the graph is known to be unchanged (e.g. exporting). Lets the caller control exactly
+   * which frames are rendered and how far ahead.
+   */
+  void RenderFrame(const rational& time);
+
   void SetOnlySignalLastFrameRequested(bool enabled);
 
   bool IsRendered(const rational& time) const;
 
   void SetLimitCaching(bool limit);
 
-  QString GetCachedFrame(const rational& time);
+  /**
+   * @brief Retrieve the cached frame at a given time
+   *
+   * The in-memory cache is checked first, falling back to reading the frame from the disk cache. Returns false if
+   * this time hasn't been cached yet, otherwise returns true and sets `frame` to the cached image (which will be
+   * nullptr if the rendered frame was empty).
+   */
+  bool GetCachedFrame(const rational& time, FramePtr* frame);
+
+  /**
+   * @brief Start loading the cached frame at a given time into memory in the background
+   *
+   * Used to read ahead during playback so GetCachedFrame() doesn't have to decode from disk on the GUI thread.
+   */
+  void PrefetchCachedFrame(const rational& time);
 
   void UpdateLastRequestedTime(const rational& time);
 
@@ -115,7 +143,14 @@ private:
 
   bool JobIsCurrent(const NodeDependency &dep, const qint64& job_time) const;
 
-  bool SetFrameHash(const NodeDependency& dep, const QByteArray& hash, const qint64& job_time);
+  /**
+   * @brief Set the hash of a job's frame if the job is still current
+   *
+   * If the hash is valid across a range of time (`static_range`), the hash is also set on any other invalidated frames
+   * in that range so they don't need to be hashed or rendered individually. Every time that had its hash set is
+   * appended to `times_set`.
+   */
+  bool SetFrameHash(const NodeDependency& dep, const QByteArray& hash, const TimeRange& static_range, const qint64& job_time, QList<rational>* times_set = nullptr);
 
   void Requeue();
 
@@ -125,6 +160,13 @@ private:
 
   TimeRangeList invalidated_;
 
+  /**
+   * @brief Time (in msecs since epoch) of the last invalidation
+   *
+   * Jobs started before this can't have their hash applied to any frames other than their own.
+   */
+  qint64 last_invalidation_time_;
+
   rational last_time_requested_;
 
   bool only_signal_last_frame_requested_;
@@ -134,9 +176,9 @@ private:
   bool pop_toggle_;
 
 private slots:
-  void ThreadCompletedDownload(NodeDependency dep, qint64 job_time, QByteArray hash, bool texture_existed);
-  void ThreadSkippedFrame(NodeDependency dep, qint64 job_time, QByteArray hash);
-  void ThreadHashAlreadyExists(NodeDependency dep, qint64 job_time, QByteArray hash);
+  void ThreadCompletedDownload(NodeDependency dep, qint64 job_time, QByteArray hash, TimeRange static_range, bool texture_existed);
+  void ThreadSkippedFrame(NodeDependency dep, qint64 job_time, QByteArray hash, TimeRange static_range);
+  void ThreadHashAlreadyExists(NodeDependency dep, qint64 job_time, QByteArray hash, TimeRange static_range);
   void ThreadGeneratedFrame();
 
   void TruncateFrameCacheLength(const rational& length);
@@ -20,10 +20,17 @@
 
 #include "videorenderframecache.h"
 
+#include <OpenEXR/ImfChannelList.h>
+#include <OpenEXR/ImfFloatAttribute.h>
+#include <OpenEXR/ImfOutputFile.h>
+#include <OpenImageIO/imageio.h>
+#include <QDebug>
 #include <QDir>
 #include <QFileInfo>
 
+#include "common/define.h"
 #include "common/filefunctions.h"
+#include "render/memorymanager.h"
 
 OLIVE_NAMESPACE_ENTER
 
@@ -41,7 +48,8 @@ void VideoRenderFrameCache::Clear()
 
 bool VideoRenderFrameCache::HasHash(const QByteArray &hash, const PixelFormat::Format& format)
 {
-  return QFileInfo::exists(CachePathName(hash, format)) && !IsCaching(hash);
+  return (MemoryManager::instance()->Contains(hash) || QFileInfo::exists(CachePathName(hash, format)))
+      && !IsCaching(hash);
 }
 
 bool VideoRenderFrameCache::IsCaching(const QByteArray &hash)
@@ -160,4 +168,124 @@ QString VideoRenderFrameCache::CachePathName(const QByteArray& hash, const Pixel
   return cache_dir.filePath(filename);
 }
 
+bool VideoRenderFrameCache::SaveCacheFrame(const QString &filename, FramePtr frame)
+{
+  switch (frame->format()) {
+  case PixelFormat::PIX_FMT_RGB8:
+  case PixelFormat::PIX_FMT_RGBA8:
+  case PixelFormat::PIX_FMT_RGB16U:
+  case PixelFormat::PIX_FMT_RGBA16U:
+  {
+    // Integer types are stored in JPEG which we run through OIIO
+
+    std::string fn_std = filename.toStdString();
+
+    auto out = OIIO::ImageOutput::create(fn_std);
+
+    if (!out) {
+      qCritical() << "Failed to write JPEG file:" << OIIO::geterror().c_str();
+      return false;
+    }
+
+    // Attempt to keep this write to one thread
+    out->threads(1);
+
+    out->open(fn_std, OIIO::ImageSpec(frame->width(),
+                                      frame->height(),
+                                      PixelFormat::ChannelCount(frame->format()),
+                                      PixelFormat::GetOIIOTypeDesc(frame->format())));
+
+    out->write_image(PixelFormat::GetOIIOTypeDesc(frame->format()), frame->const_data());
+
+    out->close();
+
+#if OIIO_VERSION < 10903
+    OIIO::ImageOutput::destroy(out);
+#endif
+
+    return true;
+  }
+  case PixelFormat::PIX_FMT_RGB16F:
+  case PixelFormat::PIX_FMT_RGBA16F:
+  case PixelFormat::PIX_FMT_RGB32F:
+  case PixelFormat::PIX_FMT_RGBA32F:
+  {
+    // Floating point types are stored in EXR
+    Imf::PixelType pix_type;
+
+    if (frame->format() == PixelFormat::PIX_FMT_RGB16F
+        || frame->format() == PixelFormat::PIX_FMT_RGBA16F) {
+      pix_type = Imf::HALF;
+    } else {
+      pix_type = Imf::FLOAT;
+    }
+
+    Imf::Header header(frame->width(),
+                       frame->height());
+    header.channels().insert("R", Imf::Channel(pix_type));
+    header.channels().insert("G", Imf::Channel(pix_type));
+    header.channels().insert("B", Imf::Channel(pix_type));
+    header.channels().insert("A", Imf::Channel(pix_type));
+
+    header.compression() = Imf::DWAA_COMPRESSION;
+    header.insert("dwaCompressionLevel", Imf::FloatAttribute(200.0f));
+
+    Imf::OutputFile out(filename.toUtf8(), header, 0);
+
+    int bpc = PixelFormat::BytesPerChannel(frame->format());
+
+    size_t xs = kRGBAChannels * bpc;
+    size_t ys = frame->width() * kRGBAChannels * bpc;
+
+    Imf::FrameBuffer framebuffer;
+    framebuffer.insert("R", Imf::Slice(pix_type, frame->data(), xs, ys));
+    framebuffer.insert("G", Imf::Slice(pix_type, frame->data() + bpc, xs, ys));
+    framebuffer.insert("B", Imf::Slice(pix_type, frame->data() + 2*bpc, xs, ys));
+    framebuffer.insert("A", Imf::Slice(pix_type, frame->data() + 3*bpc, xs, ys));
+    out.setFrameBuffer(framebuffer);
+
+    out.writePixels(frame->height());
+
+    return true;
+  }
+  case PixelFormat::PIX_FMT_INVALID:
+  case PixelFormat::PIX_FMT_COUNT:
+    break;
+  }
+
+  qCritical() << "Unable to cache invalid pixel format" << frame->format();
+
+  return false;
+}
+
+FramePtr VideoRenderFrameCache::LoadCacheFrame(const QString &filename)
+{
+  if (filename.isEmpty() || !QFileInfo::exists(filename)) {
+    return nullptr;
+  }
+
+  auto input = OIIO::ImageInput::open(filename.toStdString());
+
+  if (!input) {
+    qWarning() << "OIIO Error:" << OIIO::geterror().c_str();
+    return nullptr;
+  }
+
+  PixelFormat::Format image_format = PixelFormat::OIIOFormatToOliveFormat(input->spec().format,
+                                                                          input->spec().nchannels == kRGBAChannels);
+
+  FramePtr frame = Frame::Create();
+  frame->set_video_params(VideoRenderingParams(input->spec().width, input->spec().height, image_format));
+  frame->allocate();
+
+  input->read_image(input->spec().format, frame->data());
+  input->close();
+
+#if OIIO_VERSION < 10903
+  OIIO::ImageInput::destroy(input);
+#endif
+
+  return frame;
+}
+
 OLIVE_NAMESPACE_EXIT
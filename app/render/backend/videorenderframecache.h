@@ -23,6 +23,7 @@
 
 #include <QMutex>
 
+#include "codec/frame.h"
 #include "common/rational.h"
 #include "render/pixelformat.h"
 
@@ -36,7 +37,7 @@ public:
   void Clear();
 
   /**
-   * @brief Return whether a frame with this hash already exists
+   * @brief Return whether a frame with this hash already exists in memory or on disk
    */
   bool HasHash(const QByteArray& hash, const PixelFormat::Format &format);
 
@@ -77,6 +78,18 @@ public:
 
   const QMap<rational, QByteArray>& time_hash_map() const;
 
+  /**
+   * @brief Write a frame to the disk cache
+   *
+   * Integer formats are stored as JPEG and float formats as EXR.
+   */
+  static bool SaveCacheFrame(const QString& filename, FramePtr frame);
+
+  /**
+   * @brief Read a frame from the disk cache, returns nullptr if it doesn't exist or couldn't be read
+   */
+  static FramePtr LoadCacheFrame(const QString& filename);
+
 private:
   QMap<rational, QByteArray> time_hash_map_;
 
@@ -20,16 +20,13 @@
 
 #include "videorenderworker.h"
 
-#include <OpenEXR/ImfFloatAttribute.h>
-#include <OpenEXR/ImfInputFile.h>
-#include <OpenEXR/ImfOutputFile.h>
-#include <OpenEXR/ImfChannelList.h>
-
 #include "common/define.h"
+#include "common/fasthash.h"
 #include "common/functiontimer.h"
 #include "node/block/transition/transition.h"
 #include "node/node.h"
 #include "project/project.h"
+#include "render/memorymanager.h"
 #include "render/pixelformat.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -49,10 +46,11 @@ const VideoRenderingParams &VideoRenderWorker::video_params()
 NodeValueTable VideoRenderWorker::RenderInternal(const NodeDependency& path, const qint64 &job_time)
 {
   // Get hash of node graph
-  // We use SHA-1 for speed (benchmarks show it's the fastest hash available to us)
+  // We only use this hash to identify frames so a fast non-cryptographic hash is sufficient
   QByteArray hash;
+  TimeRange static_range = path.range();
   if (operating_mode_ & kHashOnly) {
-    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    FastHash hasher;
 
     // Embed video parameters into this hash
     int vwidth = video_params_.effective_width();
@@ -65,7 +63,7 @@ NodeValueTable VideoRenderWorker::RenderInternal(const NodeDependency& path, con
     hasher.addData(reinterpret_cast<const char*>(&vfmt), sizeof(PixelFormat::Format));
     hasher.addData(reinterpret_cast<const char*>(&vmode), sizeof(RenderMode::Mode));
 
-    HashNodeRecursively(&hasher, path.node(), path.in());
+    hasher.addData(HashNode(path.node(), path.in(), &static_range));
     hash = hasher.result();
   }
 
@@ -74,12 +72,12 @@ NodeValueTable VideoRenderWorker::RenderInternal(const NodeDependency& path, con
   if (!(operating_mode_ & kRenderOnly)) {
 
     // Emit only the hash
-    emit CompletedDownload(path, job_time, hash, false);
+    emit CompletedDownload(path, job_time, hash, static_range, false);
 
   } else if ((operating_mode_ & kHashOnly) && frame_cache_->HasHash(hash, video_params_.format())) {
 
     // We've already cached this hash, no need to continue
-    emit HashAlreadyExists(path, job_time, hash);
+    emit HashAlreadyExists(path, job_time, hash, static_range);
 
   } else if (!(operating_mode_ & kHashOnly) || frame_cache_->TryCache(hash)) {
 
@@ -91,39 +89,73 @@ NodeValueTable VideoRenderWorker::RenderInternal(const NodeDependency& path, con
 
     // If we actually have a texture, download it into the disk cache
     if (!texture.isNull()) {
-      Download(path.in(), texture, frame_cache_->CachePathName(hash, video_params_.format()));
+      Download(path.in(), texture, hash);
+    } else if (!(operating_mode_ & kDownloadOnly)) {
+      // Nothing is visible at this time, but whoever's waiting on GeneratedFrame still needs to hear about it
+      emit GeneratedFrame(path.in(), nullptr);
     }
 
     frame_cache_->RemoveHashFromCurrentlyCaching(hash);
 
     // Signal that this job is complete
     if (operating_mode_ & kDownloadOnly) {
-      emit CompletedDownload(path, job_time, hash, !texture.isNull());
+      emit CompletedDownload(path, job_time, hash, static_range, !texture.isNull());
     }
 
   } else {
 
     // Another thread must be caching this already, nothing to be done
-    emit HashAlreadyBeingCached(path, job_time, hash);
+    emit HashAlreadyBeingCached(path, job_time, hash, static_range);
 
   }
 
   return value;
 }
 
-void VideoRenderWorker::HashNodeRecursively(QCryptographicHash *hash, const Node* n, const rational& time)
+QByteArray VideoRenderWorker::HashNode(const Node* n, const rational& time, TimeRange* static_range)
 {
   // Resolve BlockList
   if (n->IsTrack()) {
-    n = static_cast<const TrackOutput*>(n)->BlockAtTime(time);
+    const TrackOutput* track = static_cast<const TrackOutput*>(n);
+    const Block* block = track->BlockAtTime(time);
+
+    if (!block) {
+      if (track->IsMuted()) {
+        *static_range = TimeRange(RATIONAL_MIN, RATIONAL_MAX);
+      } else if (time >= track->track_length()) {
+        *static_range = TimeRange(track->track_length(), RATIONAL_MAX);
+      } else {
+        *static_range = TimeRange(time, time);
+      }
 
-    if (!n) {
-      return;
+      return QByteArray();
     }
+
+    QByteArray block_hash = HashNode(block, time, static_range);
+
+    // This hash can't be valid outside of the time the block is active
+    if (static_range->length() > 0) {
+      *static_range = static_range->Intersected(TimeRange(block->in(), block->out()));
+    }
+
+    return block_hash;
   }
 
+  // If this subgraph has been found to be the same at any time, we can use the hash we generated last time
+  QByteArray cached_hash = n->GetCachedHash();
+  if (!cached_hash.isEmpty()) {
+    *static_range = TimeRange(RATIONAL_MIN, RATIONAL_MAX);
+    return cached_hash;
+  }
+
+  bool time_dependent = n->IsTimeDependent();
+
+  *static_range = TimeRange(RATIONAL_MIN, RATIONAL_MAX);
+
+  FastHash hash;
+
   // Add this Node's ID
-  hash->addData(n->id().toUtf8());
+  hash.addData(n->id().toUtf8());
 
   if (n->IsBlock() && static_cast<const Block*>(n)->type() == Block::kTransition) {
     const TransitionBlock* transition = static_cast<const TransitionBlock*>(n);
@@ -132,9 +164,13 @@ void VideoRenderWorker::HashNodeRecursively(QCryptographicHash *hash, const Node
     double in_prog = transition->GetInProgress(time);
     double out_prog = transition->GetOutProgress(time);
 
-    hash->addData(reinterpret_cast<const char*>(&all_prog), sizeof(double));
-    hash->addData(reinterpret_cast<const char*>(&in_prog), sizeof(double));
-    hash->addData(reinterpret_cast<const char*>(&out_prog), sizeof(double));
+    hash.addData(reinterpret_cast<const char*>(&all_prog), sizeof(double));
+    hash.addData(reinterpret_cast<const char*>(&in_prog), sizeof(double));
+    hash.addData(reinterpret_cast<const char*>(&out_prog), sizeof(double));
+  } else if (time_dependent) {
+    // This Node uses the time directly so it must be part of the hash
+    hash.addData(reinterpret_cast<const char*>(&time.numerator()), sizeof(int64_t));
+    hash.addData(reinterpret_cast<const char*>(&time.denominator()), sizeof(int64_t));
   }
 
   foreach (NodeParam* param, n->parameters()) {
@@ -159,11 +195,30 @@ void VideoRenderWorker::HashNodeRecursively(QCryptographicHash *hash, const Node
 
       if (input->IsConnected()) {
         // Traverse down this edge
-        HashNodeRecursively(hash, input->get_connected_node(), input_time);
-      } else {
+        TimeRange input_static_range;
+        hash.addData(HashNode(input->get_connected_node(), input_time, &input_static_range));
+
+        if (input_static_range.length() == 0) {
+          time_dependent = true;
+        } else if (input_static_range != TimeRange(RATIONAL_MIN, RATIONAL_MAX)) {
+          // Convert back to our time and narrow our range to it
+          TimeRange adjusted = n->OutputTimeAdjustment(input, input_static_range);
+
+          if (adjusted.in() <= time && adjusted.out() > time) {
+            *static_range = static_range->Intersected(adjusted);
+          } else {
+            time_dependent = true;
+          }
+        }
+      } else if (input->is_animated()) {
         // Grab the value at this time
         QVariant value = input->get_value_at_time(input_time);
-        hash->addData(NodeParam::ValueToBytes(input->data_type(), value));
+        hash.addData(NodeParam::ValueToBytes(input->data_type(), value));
+
+        time_dependent = true;
+      } else {
+        // Value is the same at any time so we can use the cached bytes
+        hash.addData(input->get_standard_value_bytes());
       }
 
       // We have one exception for FOOTAGE types, since we resolve the footage into a frame in the renderer
@@ -178,58 +233,56 @@ void VideoRenderWorker::HashNodeRecursively(QCryptographicHash *hash, const Node
             // Add footage details to hash
 
             // Footage filename
-            hash->addData(stream->footage()->filename().toUtf8());
+            hash.addData(stream->footage()->filename().toUtf8());
 
             // Footage last modified date
-            hash->addData(stream->footage()->timestamp().toString().toUtf8());
+            hash.addData(stream->footage()->timestamp().toString().toUtf8());
 
             // Footage stream
-            hash->addData(QString::number(stream->index()).toUtf8());
+            hash.addData(QString::number(stream->index()).toUtf8());
 
             if (stream->type() == Stream::kImage || stream->type() == Stream::kVideo) {
               ImageStreamPtr image_stream = std::static_pointer_cast<ImageStream>(stream);
 
               // Current color config and space
-              hash->addData(image_stream->footage()->project()->ocio_config().toUtf8());
-              hash->addData(image_stream->colorspace().toUtf8());
+              hash.addData(image_stream->footage()->project()->ocio_config().toUtf8());
+              hash.addData(image_stream->colorspace().toUtf8());
 
               // Alpha associated setting
-              hash->addData(QString::number(image_stream->premultiplied_alpha()).toUtf8());
+              hash.addData(QString::number(image_stream->premultiplied_alpha()).toUtf8());
             }
 
             // Footage timestamp
             if (stream->type() == Stream::kVideo) {
-              hash->addData(QStringLiteral("%1/%2").arg(QString::number(input_time.numerator()),
-                                                        QString::number(input_time.denominator())).toUtf8());
-
-              hash->addData(QString::number(static_cast<VideoStream*>(stream.get())->start_time()).toUtf8());
-              /*Decoder::RetrieveState state = decoder->GetRetrieveState(input_time);
-
-              if (state == Decoder::kReady) {
-                VideoStreamPtr video_stream = std::static_pointer_cast<VideoStream>(stream);
-
-                int64_t timestamp_here = video_stream->get_closest_timestamp_in_frame_index(input_time);
+              hash.addData(QStringLiteral("%1/%2").arg(QString::number(input_time.numerator()),
+                                                       QString::number(input_time.denominator())).toUtf8());
+              hash.addData(QString::number(static_cast<VideoStream*>(stream.get())->start_time()).toUtf8());
 
-                hash->addData(QString::number(timestamp_here).toUtf8());
-              } else {
-                ReportUnavailableFootage(stream, state, input_time);
-              }*/
+              time_dependent = true;
             }
           }
         }
       }
     }
   }
+
+  QByteArray result = hash.result();
+
+  if (time_dependent) {
+    // This hash is only valid for this exact time
+    *static_range = TimeRange(time, time);
+  } else if (*static_range == TimeRange(RATIONAL_MIN, RATIONAL_MAX)) {
+    // This hash is valid for any time, we don't need to generate it again until something changes
+    n->SetCachedHash(result);
+  }
+
+  return result;
 }
 
 void VideoRenderWorker::SetParameters(const VideoRenderingParams &video_params)
 {
   video_params_ = video_params;
 
-  if (IsStarted()) {
-    ResizeDownloadBuffer();
-  }
-
   ParametersChangedEvent();
 }
 
@@ -240,105 +293,31 @@ void VideoRenderWorker::SetOperatingMode(const VideoRenderWorker::OperatingMode
 
 bool VideoRenderWorker::InitInternal()
 {
-  ResizeDownloadBuffer();
   return true;
 }
 
 void VideoRenderWorker::CloseInternal()
 {
-  download_buffer_.clear();
 }
 
-void VideoRenderWorker::Download(const rational& time, QVariant texture, QString filename)
+void VideoRenderWorker::Download(const rational& time, QVariant texture, const QByteArray& hash)
 {
-  if (operating_mode_ & kDownloadOnly) {
-
-    TextureToBuffer(texture, download_buffer_.data());
-
-    switch (video_params().format()) {
-    case PixelFormat::PIX_FMT_RGB8:
-    case PixelFormat::PIX_FMT_RGBA8:
-    case PixelFormat::PIX_FMT_RGB16U:
-    case PixelFormat::PIX_FMT_RGBA16U:
-    {
-      // Integer types are stored in JPEG which we run through OIIO
-
-      std::string fn_std = filename.toStdString();
-
-      auto out = OIIO::ImageOutput::create(fn_std);
-
-      if (out) {
-        // Attempt to keep this write to one thread
-        out->threads(1);
-
-        out->open(fn_std, OIIO::ImageSpec(video_params().effective_width(),
-                                          video_params().effective_height(),
-                                          PixelFormat::ChannelCount(video_params().format()),
-                                          PixelFormat::GetOIIOTypeDesc(video_params().format())));
-
-        out->write_image(PixelFormat::GetOIIOTypeDesc(video_params().format()), download_buffer_.data());
-
-        out->close();
-
-#if OIIO_VERSION < 10903
-        OIIO::ImageOutput::destroy(out);
-#endif
-      } else {
-        qCritical() << "Failed to write JPEG file:" << OIIO::geterror().c_str();
-      }
-      break;
-    }
-    case PixelFormat::PIX_FMT_RGB16F:
-    case PixelFormat::PIX_FMT_RGBA16F:
-    case PixelFormat::PIX_FMT_RGB32F:
-    case PixelFormat::PIX_FMT_RGBA32F:
-    {
-      // Floating point types are stored in EXR
-      Imf::PixelType pix_type;
-
-      if (video_params().format() == PixelFormat::PIX_FMT_RGB16F
-          || video_params().format() == PixelFormat::PIX_FMT_RGBA16F) {
-        pix_type = Imf::HALF;
-      } else {
-        pix_type = Imf::FLOAT;
-      }
-
-      Imf::Header header(video_params().effective_width(),
-                         video_params().effective_height());
-      header.channels().insert("R", Imf::Channel(pix_type));
-      header.channels().insert("G", Imf::Channel(pix_type));
-      header.channels().insert("B", Imf::Channel(pix_type));
-      header.channels().insert("A", Imf::Channel(pix_type));
-
-      header.compression() = Imf::DWAA_COMPRESSION;
-      header.insert("dwaCompressionLevel", Imf::FloatAttribute(200.0f));
+  FramePtr frame = Frame::Create();
 
-      Imf::OutputFile out(filename.toUtf8(), header, 0);
-
-      int bpc = PixelFormat::BytesPerChannel(video_params().format());
+  if (operating_mode_ & kDownloadOnly) {
 
-      size_t xs = kRGBAChannels * bpc;
-      size_t ys = video_params().effective_width() * kRGBAChannels * bpc;
+    frame->set_video_params(VideoRenderingParams(video_params().effective_width(),
+                                                 video_params().effective_height(),
+                                                 video_params().format()));
+    frame->allocate();
 
-      Imf::FrameBuffer framebuffer;
-      framebuffer.insert("R", Imf::Slice(pix_type, download_buffer_.data(), xs, ys));
-      framebuffer.insert("G", Imf::Slice(pix_type, download_buffer_.data() + bpc, xs, ys));
-      framebuffer.insert("B", Imf::Slice(pix_type, download_buffer_.data() + 2*bpc, xs, ys));
-      framebuffer.insert("A", Imf::Slice(pix_type, download_buffer_.data() + 3*bpc, xs, ys));
-      out.setFrameBuffer(framebuffer);
+    TextureToBuffer(texture, frame->data());
 
-      out.writePixels(video_params().effective_height());
-      break;
-    }
-    case PixelFormat::PIX_FMT_INVALID:
-    case PixelFormat::PIX_FMT_COUNT:
-      qCritical() << "Unable to cache invalid pixel format" << video_params().format();
-      break;
-    }
+    // Make the frame available in memory immediately and let the disk write happen in the background
+    MemoryManager::instance()->InsertAndWriteBack(hash, frame, frame_cache_->CachePathName(hash, video_params().format()));
 
   } else {
 
-    FramePtr frame = Frame::Create();
     frame->set_video_params(video_params());
     frame->allocate();
 
@@ -349,11 +328,6 @@ void VideoRenderWorker::Download(const rational& time, QVariant texture, QString
   }
 }
 
-void VideoRenderWorker::ResizeDownloadBuffer()
-{
-  download_buffer_.resize(PixelFormat::GetBufferSize(video_params_.format(), video_params_.effective_width(), video_params_.effective_height()));
-}
-
 NodeValueTable VideoRenderWorker::RenderBlock(const TrackOutput *track, const TimeRange &range)
 {
   // A frame can only have one active block so we just validate the in point of the range
@@ -21,8 +21,6 @@
 #ifndef VIDEORENDERWORKER_H
 #define VIDEORENDERWORKER_H
 
-#include <QCryptographicHash>
-
 #include "colorprocessorcache.h"
 #include "node/dependency.h"
 #include "render/videoparams.h"
@@ -70,11 +68,16 @@ public:
   void SetOperatingMode(const OperatingMode& mode);
 
 signals:
-  void CompletedDownload(NodeDependency path, qint64 job_time, QByteArray hash, bool texture_existed);
+  /**
+   * @brief Emitted when a job has finished
+   *
+   * `static_range` is the range of time around the job's time that will produce the same hash (see HashNode()).
+   */
+  void CompletedDownload(NodeDependency path, qint64 job_time, QByteArray hash, TimeRange static_range, bool texture_existed);
 
-  void HashAlreadyBeingCached(NodeDependency path, qint64 job_time, QByteArray hash);
+  void HashAlreadyBeingCached(NodeDependency path, qint64 job_time, QByteArray hash, TimeRange static_range);
 
-  void HashAlreadyExists(NodeDependency path, qint64 job_time, QByteArray hash);
+  void HashAlreadyExists(NodeDependency path, qint64 job_time, QByteArray hash, TimeRange static_range);
 
   void GeneratedFrame(const rational &time, FramePtr frame);
 
@@ -100,11 +103,17 @@ protected:
   ColorProcessorCache* color_cache();
 
 private:
-  void HashNodeRecursively(QCryptographicHash* hash, const Node *n, const rational &time);
-
-  void Download(const rational &time, QVariant texture, QString filename);
+  /**
+   * @brief Generate a hash of a Node and everything upstream of it at a given time
+   *
+   * Sets `static_range` to the range of time around `time` over which this hash will be identical, e.g. the length of a
+   * clip with a still image and no keyframes. If the hash is only valid for this exact time, `static_range` is set to
+   * an empty range at `time`. Subgraphs that are identical at any time have their hash memoized on the Node so they
+   * don't need to be walked again until they're invalidated.
+   */
+  QByteArray HashNode(const Node *n, const rational &time, TimeRange *static_range);
 
-  void ResizeDownloadBuffer();
+  void Download(const rational &time, QVariant texture, const QByteArray &hash);
 
   VideoRenderingParams video_params_;
 
@@ -112,8 +121,6 @@ private:
 
   ColorProcessorCache color_cache_;
 
-  QByteArray download_buffer_;
-
   OperatingMode operating_mode_;
 
 private slots:
@@ -0,0 +1,250 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "memorymanager.h"
+
+#include <iterator>
+#include <QThread>
+
+#include "config/config.h"
+#include "render/backend/videorenderframecache.h"
+#include "render/diskmanager.h"
+
+OLIVE_NAMESPACE_ENTER
+
+MemoryManager* MemoryManager::instance_ = nullptr;
+
+MemoryManager::MemoryManager() :
+  consumption_(0)
+{
+  // Keep this tier a subset of the disk cache
+  connect(DiskManager::instance(), &DiskManager::DeletedFrame, this, &MemoryManager::Remove);
+
+  // Disk writes are I/O bound, so a couple of threads is enough to keep up with the renderers
+  write_pool_.setMaxThreadCount(2);
+
+  // Reading is mostly decoding, give it half the cores and leave the rest to the renderers
+  read_pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+MemoryManager::~MemoryManager()
+{
+  // Any outstanding reads are no longer needed
+  read_pool_.clear();
+  read_pool_.waitForDone();
+
+  // Ensure every dirty frame has made it to disk before we go
+  write_pool_.waitForDone();
+}
+
+void MemoryManager::CreateInstance()
+{
+  instance_ = new MemoryManager();
+}
+
+void MemoryManager::DestroyInstance()
+{
+  delete instance_;
+  instance_ = nullptr;
+}
+
+MemoryManager *MemoryManager::instance()
+{
+  return instance_;
+}
+
+FramePtr MemoryManager::Get(const QByteArray &hash)
+{
+  QMutexLocker locker(&lock_);
+
+  QHash<QByteArray, CachedFrame>::iterator i = frames_.find(hash);
+
+  if (i == frames_.end()) {
+    return nullptr;
+  }
+
+  // Move to the back of the list, this doesn't invalidate the iterator
+  access_order_.splice(access_order_.end(), access_order_, i->order);
+
+  return i->frame;
+}
+
+bool MemoryManager::Contains(const QByteArray &hash)
+{
+  QMutexLocker locker(&lock_);
+
+  return frames_.contains(hash);
+}
+
+void MemoryManager::Insert(const QByteArray &hash, FramePtr frame)
+{
+  InsertInternal(hash, frame, false);
+}
+
+void MemoryManager::InsertAndWriteBack(const QByteArray &hash, FramePtr frame, const QString &filename)
+{
+  InsertInternal(hash, frame, true);
+
+  write_pool_.start(new WriteBackTask(this, hash, frame, filename));
+}
+
+void MemoryManager::Prefetch(const QByteArray &hash, const QString &filename)
+{
+  {
+    QMutexLocker locker(&lock_);
+
+    if (frames_.contains(hash) || prefetching_.contains(hash)) {
+      return;
+    }
+
+    prefetching_.insert(hash);
+  }
+
+  read_pool_.start(new PrefetchTask(this, hash, filename));
+}
+
+void MemoryManager::Clear()
+{
+  QMutexLocker locker(&lock_);
+
+  // Dirty frames are still referenced by their write tasks so it's safe to drop them here
+  frames_.clear();
+  access_order_.clear();
+  consumption_ = 0;
+}
+
+void MemoryManager::Remove(const QByteArray &hash)
+{
+  QMutexLocker locker(&lock_);
+
+  QHash<QByteArray, CachedFrame>::iterator i = frames_.find(hash);
+
+  if (i != frames_.end()) {
+    consumption_ -= i->size;
+    access_order_.erase(i->order);
+    frames_.erase(i);
+  }
+}
+
+void MemoryManager::InsertInternal(const QByteArray &hash, FramePtr frame, bool dirty)
+{
+  QMutexLocker locker(&lock_);
+
+  QHash<QByteArray, CachedFrame>::iterator existing = frames_.find(hash);
+
+  if (existing != frames_.end()) {
+    consumption_ -= existing->size;
+    dirty |= existing->dirty;
+    access_order_.erase(existing->order);
+  }
+
+  access_order_.push_back(hash);
+
+  CachedFrame f = {frame, frame->allocated_size(), dirty, std::prev(access_order_.end())};
+
+  frames_.insert(hash, f);
+  consumption_ += f.size;
+
+  RemoveLeastRecent();
+}
+
+void MemoryManager::WriteBackComplete(const QByteArray &hash)
+{
+  QMutexLocker locker(&lock_);
+
+  QHash<QByteArray, CachedFrame>::iterator i = frames_.find(hash);
+
+  if (i != frames_.end()) {
+    i->dirty = false;
+  }
+
+  RemoveLeastRecent();
+}
+
+void MemoryManager::PrefetchComplete(const QByteArray &hash, FramePtr frame)
+{
+  {
+    QMutexLocker locker(&lock_);
+
+    prefetching_.remove(hash);
+  }
+
+  if (frame) {
+    Insert(hash, frame);
+  }
+}
+
+void MemoryManager::RemoveLeastRecent()
+{
+  // NOTE: Assumes lock_ is held by the caller
+  qint64 limit = MemoryLimit();
+
+  for (std::list<QByteArray>::iterator i=access_order_.begin();i!=access_order_.end() && consumption_ > limit;) {
+    QHash<QByteArray, CachedFrame>::iterator f = frames_.find(*i);
+
+    if (f->dirty) {
+      // Can't evict until this frame is on disk
+      i++;
+    } else {
+      consumption_ -= f->size;
+      frames_.erase(f);
+      i = access_order_.erase(i);
+    }
+  }
+}
+
+qint64 MemoryManager::MemoryLimit()
+{
+  double gigabytes = Config::Current()["MemoryCacheSize"].toDouble();
+
+  // Convert gigabytes to bytes
+  return qRound64(gigabytes * 1073741824);
+}
+
+MemoryManager::WriteBackTask::WriteBackTask(MemoryManager *parent, const QByteArray &hash, FramePtr frame, const QString &filename) :
+  parent_(parent),
+  hash_(hash),
+  frame_(frame),
+  filename_(filename)
+{
+}
+
+void MemoryManager::WriteBackTask::run()
+{
+  if (VideoRenderFrameCache::SaveCacheFrame(filename_, frame_)) {
+    DiskManager::instance()->CreatedFile(filename_, hash_);
+  }
+
+  parent_->WriteBackComplete(hash_);
+}
+
+MemoryManager::PrefetchTask::PrefetchTask(MemoryManager *parent, const QByteArray &hash, const QString &filename) :
+  parent_(parent),
+  hash_(hash),
+  filename_(filename)
+{
+}
+
+void MemoryManager::PrefetchTask::run()
+{
+  parent_->PrefetchComplete(hash_, VideoRenderFrameCache::LoadCacheFrame(filename_));
+}
+
+OLIVE_NAMESPACE_EXIT
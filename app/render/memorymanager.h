@@ -0,0 +1,168 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef MEMORYMANAGER_H
+#define MEMORYMANAGER_H
+
+#include <list>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+
+#include "codec/frame.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief In-memory tier of the frame cache that sits in front of the DiskManager
+ *
+ * Frames are keyed by the same hash used by VideoRenderFrameCache and evicted least-recently-used first once the
+ * memory budget ("MemoryCacheSize") is exceeded. Freshly rendered frames are inserted "dirty" and written to the disk
+ * cache in the background; dirty frames are never evicted until their write has completed so a frame is always
+ * available from at least one of the two tiers.
+ *
+ * All functions are thread-safe.
+ */
+class MemoryManager : public QObject
+{
+  Q_OBJECT
+public:
+  static void CreateInstance();
+
+  static void DestroyInstance();
+
+  static MemoryManager* instance();
+
+  /**
+   * @brief Retrieve a frame from memory and mark it as the most recently used
+   *
+   * Returns nullptr if no frame with this hash is currently held in memory.
+   */
+  FramePtr Get(const QByteArray& hash);
+
+  bool Contains(const QByteArray& hash);
+
+  /**
+   * @brief Insert a frame that already exists in the disk cache (e.g. one that was just read from it)
+   */
+  void Insert(const QByteArray& hash, FramePtr frame);
+
+  /**
+   * @brief Insert a freshly rendered frame and write it to the disk cache in the background
+   *
+   * The DiskManager is notified of the file once the write has completed.
+   */
+  void InsertAndWriteBack(const QByteArray& hash, FramePtr frame, const QString& filename);
+
+  /**
+   * @brief Read a frame from the disk cache into memory in the background
+   *
+   * Used for playback read-ahead so that frames are already in memory by the time they're displayed. Does nothing if
+   * the frame is already in memory or currently being read.
+   */
+  void Prefetch(const QByteArray& hash, const QString& filename);
+
+  void Clear();
+
+public slots:
+  void Remove(const QByteArray& hash);
+
+private:
+  MemoryManager();
+
+  virtual ~MemoryManager() override;
+
+  static MemoryManager* instance_;
+
+  void InsertInternal(const QByteArray& hash, FramePtr frame, bool dirty);
+
+  void WriteBackComplete(const QByteArray& hash);
+
+  void PrefetchComplete(const QByteArray& hash, FramePtr frame);
+
+  void RemoveLeastRecent();
+
+  static qint64 MemoryLimit();
+
+  class WriteBackTask : public QRunnable
+  {
+  public:
+    WriteBackTask(MemoryManager* parent, const QByteArray& hash, FramePtr frame, const QString& filename);
+
+    virtual void run() override;
+
+  private:
+    MemoryManager* parent_;
+
+    QByteArray hash_;
+
+    FramePtr frame_;
+
+    QString filename_;
+
+  };
+
+  class PrefetchTask : public QRunnable
+  {
+  public:
+    PrefetchTask(MemoryManager* parent, const QByteArray& hash, const QString& filename);
+
+    virtual void run() override;
+
+  private:
+    MemoryManager* parent_;
+
+    QByteArray hash_;
+
+    QString filename_;
+
+  };
+
+  struct CachedFrame {
+    FramePtr frame;
+    qint64 size;
+    bool dirty;
+    std::list<QByteArray>::iterator order;
+  };
+
+  QHash<QByteArray, CachedFrame> frames_;
+
+  /**
+   * @brief Hashes in order of access, least recently used first
+   */
+  std::list<QByteArray> access_order_;
+
+  QSet<QByteArray> prefetching_;
+
+  qint64 consumption_;
+
+  QMutex lock_;
+
+  QThreadPool write_pool_;
+
+  QThreadPool read_pool_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // MEMORYMANAGER_H
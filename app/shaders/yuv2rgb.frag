@@ -0,0 +1,24 @@
+#version 110
+
+#ifdef GL_ES
+precision highp float;
+#endif
+
+// Y, Cb and Cr planes, each stored in the red channel
+uniform sampler2D ove_maintex;
+uniform sampler2D yuv_cb;
+uniform sampler2D yuv_cr;
+
+// Removes the black level/chroma bias and applies the colorspace's conversion matrix
+uniform vec3 yuv_offset;
+uniform mat3 yuv_matrix;
+
+varying vec2 ove_texcoord;
+
+void main(void) {
+  vec3 yuv = vec3(texture2D(ove_maintex, ove_texcoord).r,
+                  texture2D(yuv_cb, ove_texcoord).r,
+                  texture2D(yuv_cr, ove_texcoord).r);
+
+  gl_FragColor = vec4(yuv_matrix * (yuv - yuv_offset), 1.0);
+}
@@ -30,7 +30,6 @@ OLIVE_NAMESPACE_ENTER
 
 HistogramScope::HistogramScope(QWidget* parent) :
   QOpenGLWidget(parent),
-  buffer_(nullptr),
   processor_(nullptr)
 {
   connect(&worker_, &HistogramScopeWorker::Finished, this, &HistogramScope::FinishedProcessing, Qt::QueuedConnection);
@@ -44,7 +43,7 @@ HistogramScope::~HistogramScope()
   worker_.wait();
 }
 
-void HistogramScope::SetBuffer(Frame* frame)
+void HistogramScope::SetBuffer(FramePtr frame)
 {
   buffer_ = frame;
 
@@ -69,7 +69,7 @@ public:
   virtual ~HistogramScope() override;
 
 public slots:
-  void SetBuffer(Frame* frame);
+  void SetBuffer(FramePtr frame);
 
   void SetColorProcessor(ColorProcessorPtr processor);
 
@@ -82,7 +82,7 @@ protected:
 private:
   void StartUpdate();
 
-  Frame* buffer_;
+  FramePtr buffer_;
 
   ColorProcessorPtr processor_;
 
@@ -28,7 +28,9 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
+#include <QtMath>
 
+#include "audio/peakpyramid.h"
 #include "common/qtutils.h"
 #include "config/config.h"
 #include "core.h"
@@ -97,31 +99,23 @@ void TimelineViewBlockItem::paint(QPainter *painter, const QStyleOptionGraphicsI
 
     // Draw waveform if one is available
     QString wave_fn = QDir(QDir(Config::Current()["DiskCachePath"].toString()).filePath("waveform")).filePath(QString::number(reinterpret_cast<quintptr>(block_)));
-    QFile wave_file(wave_fn);
-    if (wave_file.open(QFile::ReadOnly)){
+    PeakPyramid peaks(wave_fn);
+    if (peaks.open()) {
       painter->setPen(QColor(64, 64, 64));
 
-      QByteArray w = wave_file.readAll();
-
-      wave_file.close();
-
-      // Read metadata
-      SampleSummer::Info info;
-      QFile wave_meta(wave_fn.append(QStringLiteral(".meta")));
-      if (wave_meta.open(QFile::ReadOnly)) {
-        wave_meta.read(reinterpret_cast<char*>(&info), sizeof(SampleSummer::Info));
-        wave_meta.close();
-      }
-
-      // Prevent divide by zero
-      if (info.channels) {
-        AudioWaveformView::DrawWaveform(painter,
-                                        rect().toRect(),
-                                        this->GetScale(),
-                                        reinterpret_cast<const SampleSummer::Sum*>(w.constData()),
-                                        w.size() / sizeof(SampleSummer::Sum),
-                                        info.channels);
-      }
+      // Only read the level that has about as many peaks as there are pixels
+      int level = PeakPyramid::LevelForScale(this->GetScale());
+      double rate = PeakPyramid::LevelRate(level);
+
+      QVector<SampleSummer::Sum> w = peaks.read(level, 0, qCeil(rect().width() / this->GetScale() * rate) + 1);
+
+      AudioWaveformView::DrawWaveform(painter,
+                                      rect().toRect(),
+                                      this->GetScale(),
+                                      w.constData(),
+                                      w.size(),
+                                      peaks.channels(),
+                                      rate);
     }
 
     painter->setPen(Qt::white);
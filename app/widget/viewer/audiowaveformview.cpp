@@ -24,7 +24,9 @@
 #include <QPainter>
 #include <QtMath>
 
+#include "audio/peakpyramid.h"
 #include "common/clamp.h"
+#include "common/filefunctions.h"
 #include "config/config.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -58,7 +60,7 @@ void AudioWaveformView::SetBackend(AudioRenderBackend *backend)
   ForceUpdate();
 }
 
-void AudioWaveformView::DrawWaveform(QPainter *painter, const QRect& rect, const double& scale, const SampleSummer::Sum* samples, int nb_samples, int channels)
+void AudioWaveformView::DrawWaveform(QPainter *painter, const QRect& rect, const double& scale, const SampleSummer::Sum* samples, int nb_samples, int channels, const double &sum_rate)
 {
   int sample_index, next_sample_index = 0;
 
@@ -76,7 +78,7 @@ void AudioWaveformView::DrawWaveform(QPainter *painter, const QRect& rect, const
     }
 
     next_sample_index = qMin(nb_samples,
-                             qFloor(static_cast<double>(SampleSummer::kSumSampleRate) * static_cast<double>(i+1) / scale) * channels);
+                             qFloor(sum_rate * static_cast<double>(i+1) / scale) * channels);
 
     if (summary_index != sample_index) {
       summary = SampleSummer::ReSumSamples(&samples[sample_index],
@@ -126,9 +128,43 @@ void AudioWaveformView::paintEvent(QPaintEvent *event)
     cached_waveform_ = QPixmap(size());
     cached_waveform_.fill(Qt::transparent);
 
+    PeakPyramid peaks(backend_->PeaksPathName());
     QFile fs(backend_->CachePathName());
 
-    if (fs.open(QFile::ReadOnly)) {
+    if (GetScale() < SampleSummer::kSumSampleRate
+        && peaks.open()
+        && peaks.channels() == params.channel_count()) {
+
+      // There are fewer pixels than peaks, so only read the level that has about as many peaks as there are pixels
+      QPainter wave_painter(&cached_waveform_);
+
+      // FIXME: Hardcoded color
+      wave_painter.setPen(QColor(64, 255, 160));
+
+      int level = PeakPyramid::LevelForScale(GetScale());
+      double rate = PeakPyramid::LevelRate(level);
+
+      double first = ScreenToUnitFloat(0) / static_cast<double>(params.sample_rate()) * rate;
+      qint64 first_index = qMax(static_cast<qint64>(0), static_cast<qint64>(qFloor(first)));
+
+      QVector<SampleSummer::Sum> sums = peaks.read(level, first_index, qCeil(width() / GetScale() * rate) + 1);
+
+      // Align the first peak we read with where it is on screen
+      int x_offset = qRound((static_cast<double>(first_index) - first) / rate * GetScale());
+
+      DrawWaveform(&wave_painter,
+                   QRect(x_offset, 0, width() - x_offset, height()),
+                   GetScale(),
+                   sums.constData(),
+                   sums.size(),
+                   params.channel_count(),
+                   rate);
+
+      cached_size_ = size();
+      cached_scale_ = GetScale();
+      cached_scroll_ = GetScroll();
+
+    } else if (fs.open(QFile::ReadOnly)) {
 
       QPainter wave_painter(&cached_waveform_);
 
@@ -140,21 +176,43 @@ void AudioWaveformView::paintEvent(QPaintEvent *event)
 
       int drew = 0;
 
-      fs.seek(params.samples_to_bytes(ScreenToUnitRounded(0)));
+      qint64 file_size = fs.size();
+      qint64 pos = qMax(0, params.samples_to_bytes(ScreenToUnitRounded(0)));
 
-      for (int x=0; x<width() && !fs.atEnd(); x++) {
+      // Summarize straight from a mapping of the file if we can, otherwise fall back to reading it
+      const char* mapped_data = reinterpret_cast<const char*>(fs.map(0, file_size));
+      QByteArray read_buffer;
+
+      if (mapped_data) {
+        AdviseSequentialAccess(mapped_data, file_size);
+      } else {
+        fs.seek(pos);
+      }
+
+      for (int x=0; x<width() && pos < file_size; x++) {
 
         int samples_len = ScreenToUnitRounded(x+1) - ScreenToUnitRounded(x);
         int max_read_size = params.samples_to_bytes(samples_len);
+        int read_size;
+        const char* sample_data;
+
+        if (mapped_data) {
+          read_size = static_cast<int>(qMin(static_cast<qint64>(max_read_size), file_size - pos));
+          sample_data = mapped_data + pos;
+        } else {
+          read_buffer = fs.read(max_read_size);
+          read_size = read_buffer.size();
+          sample_data = read_buffer.constData();
+        }
 
-        QByteArray read_buffer = fs.read(max_read_size);
+        pos += read_size;
 
         // Detect whether we've reached EOF and recalculate sample count if so
-        if (read_buffer.size() < max_read_size) {
-          samples_len = params.bytes_to_samples(read_buffer.size());
+        if (read_size < max_read_size) {
+          samples_len = params.bytes_to_samples(read_size);
         }
 
-        QVector<SampleSummer::Sum> samples = SampleSummer::SumSamples(reinterpret_cast<const float*>(read_buffer.constData()),
+        QVector<SampleSummer::Sum> samples = SampleSummer::SumSamples(reinterpret_cast<const float*>(sample_data),
                                                                       samples_len,
                                                                       params.channel_count());
 
@@ -40,7 +40,10 @@ public:
 
   void SetBackend(AudioRenderBackend* backend);
 
-  static void DrawWaveform(QPainter* painter, const QRect &rect, const double &scale, const SampleSummer::Sum *samples, int nb_samples, int channels);
+  /**
+   * @brief Draw peaks that were summarized at `sum_rate` per second, starting at the left of `rect`
+   */
+  static void DrawWaveform(QPainter* painter, const QRect &rect, const double &scale, const SampleSummer::Sum *samples, int nb_samples, int channels, const double& sum_rate);
 
 protected:
   virtual void paintEvent(QPaintEvent* event) override;
@@ -102,7 +102,7 @@ ViewerWidget::ViewerWidget(QWidget *parent) :
   SetScale(48.0);
 
   // Start background renderers
-  video_renderer_ = new OpenGLBackend(this);
+  video_renderer_ = VideoRenderBackend::Create(this);
   connect(video_renderer_, &VideoRenderBackend::CachedTimeReady, this, &ViewerWidget::RendererCachedTime);
   connect(video_renderer_, &VideoRenderBackend::CachedTimeReady, ruler(), &TimeRuler::CacheTimeReady);
   connect(video_renderer_, &VideoRenderBackend::RangeInvalidated, ruler(), &TimeRuler::CacheInvalidatedRange);
@@ -130,6 +130,8 @@ void ViewerWidget::TimeChangedEvent(const int64_t &i)
 
     UpdateTextureFromNode(time_set);
 
+    PrefetchPlayback(i);
+
     PushScrubbedAudio();
   }
 
@@ -332,13 +334,13 @@ VideoRenderBackend *ViewerWidget::video_renderer() const
 void ViewerWidget::UpdateTextureFromNode(const rational& time)
 {
   if (!GetConnectedNode() || time >= GetConnectedNode()->Length()) {
-    main_gl_widget()->SetImage(QString());
+    main_gl_widget()->SetImage(nullptr);
     video_renderer_->UpdateLastRequestedTime(time);
   } else {
-    QString frame_fn = video_renderer_->GetCachedFrame(time);
+    FramePtr frame;
 
-    if (!frame_fn.isEmpty()) {
-      main_gl_widget()->SetImage(frame_fn);
+    if (video_renderer_->GetCachedFrame(time, &frame)) {
+      main_gl_widget()->SetImage(frame);
     }
   }
 }
@@ -365,6 +367,8 @@ void ViewerWidget::PlayInternal(int speed, bool in_to_out_only)
   start_msec_ = QDateTime::currentMSecsSinceEpoch();
   start_timestamp_ = ruler()->GetTime();
 
+  PrefetchPlayback(start_timestamp_);
+
   controls_->ShowPauseButton();
 
   if (stack_->currentWidget() == sizer_) {
@@ -395,6 +399,43 @@ void ViewerWidget::PushScrubbedAudio()
   }
 }
 
+void ViewerWidget::ShuttleInternal(int speed)
+{
+  if (IsPlaying()
+      && (speed > 0) == (playback_speed_ > 0)
+      && AudioManager::instance()->SetOutputSpeed(speed)) {
+    // Audio carries on at the new speed, so just continue the video timer from where we are now
+    start_msec_ = QDateTime::currentMSecsSinceEpoch();
+    start_timestamp_ = ruler()->GetTime();
+    playback_speed_ = speed;
+
+    PrefetchPlayback(start_timestamp_);
+    return;
+  }
+
+  Pause();
+
+  PlayInternal(speed, false);
+}
+
+void ViewerWidget::PrefetchPlayback(int64_t from)
+{
+  if (!IsPlaying()) {
+    return;
+  }
+
+  // Read the next few frames in the direction and at the speed we're playing
+  for (int i=1;i<=kPlaybackReadAhead;i++) {
+    int64_t ts = from + i * playback_speed_;
+
+    if (ts < 0) {
+      break;
+    }
+
+    video_renderer_->PrefetchCachedFrame(Timecode::timestamp_to_time(ts, timebase()));
+  }
+}
+
 int ViewerWidget::CalculateDivider()
 {
   if (GetConnectedNode() && Config::Current()["AutoSelectDivider"].toBool()) {
@@ -716,17 +757,13 @@ void ViewerWidget::ShuttleLeft()
 {
   int current_speed = playback_speed_;
 
-  if (current_speed != 0) {
-    Pause();
-  }
-
   current_speed--;
 
   if (current_speed == 0) {
     current_speed--;
   }
 
-  PlayInternal(current_speed, false);
+  ShuttleInternal(current_speed);
 }
 
 void ViewerWidget::ShuttleStop()
@@ -738,17 +775,13 @@ void ViewerWidget::ShuttleRight()
 {
   int current_speed = playback_speed_;
 
-  if (current_speed != 0) {
-    Pause();
-  }
-
   current_speed++;
 
   if (current_speed == 0) {
     current_speed++;
   }
 
-  PlayInternal(current_speed, false);
+  ShuttleInternal(current_speed);
 }
 
 void ViewerWidget::SetOCIOParameters(const QString &display, const QString &view, const QString &look)
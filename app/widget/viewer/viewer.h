@@ -32,7 +32,7 @@
 #include "common/rational.h"
 #include "node/output/viewer/viewer.h"
 #include "panel/scope/scope.h"
-#include "render/backend/opengl/openglbackend.h"
+#include "render/backend/videorenderbackend.h"
 #include "render/backend/opengl/opengltexture.h"
 #include "render/backend/audio/audiobackend.h"
 #include "viewerglwidget.h"
@@ -140,7 +140,7 @@ signals:
   /**
    * @brief Wrapper for ViewerGLWidget::LoadedBuffer()
    */
-  void LoadedBuffer(Frame* load_buffer);
+  void LoadedBuffer(FramePtr load_buffer);
 
   /**
    * @brief Wrapper for ViewerGLWidget::LoadedTexture()
@@ -176,7 +176,7 @@ protected:
 
   virtual void resizeEvent(QResizeEvent *event) override;
 
-  OpenGLBackend* video_renderer_;
+  VideoRenderBackend* video_renderer_;
   AudioBackend* audio_renderer_;
 
   PlaybackControls* controls_;
@@ -185,14 +185,26 @@ protected:
   ViewerGLWidget* main_gl_widget() const;
 
 private:
+  /**
+   * @brief Number of cached frames to read into memory ahead of the playhead during playback
+   */
+  static const int kPlaybackReadAhead = 8;
+
   void UpdateTimeInternal(int64_t i);
 
   void UpdateTextureFromNode(const rational &time);
 
   void PlayInternal(int speed, bool in_to_out_only);
 
+  /**
+   * @brief Change to a shuttle speed, changing speed in place if we're already playing in that direction
+   */
+  void ShuttleInternal(int speed);
+
   void PushScrubbedAudio();
 
+  void PrefetchPlayback(int64_t from);
+
   int CalculateDivider();
 
   void UpdateMinimumScale();
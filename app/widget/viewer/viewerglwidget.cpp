@@ -20,8 +20,6 @@
 
 #include "viewerglwidget.h"
 
-#include <OpenImageIO/imagebuf.h>
-#include <QFileInfo>
 #include <QMessageBox>
 #include <QMouseEvent>
 #include <QOpenGLContext>
@@ -86,63 +84,32 @@ void ViewerGLWidget::SetMatrix(const QMatrix4x4 &mat)
   update();
 }
 
-void ViewerGLWidget::SetImage(const QString &fn)
+void ViewerGLWidget::SetImage(FramePtr frame)
 {
-  has_image_ = false;
+  load_buffer_ = frame;
+  has_image_ = (load_buffer_ != nullptr);
 
-  if (!fn.isEmpty() && QFileInfo::exists(fn)) {
-    auto input = OIIO::ImageInput::open(fn.toStdString());
-
-    if (input) {
-
-      PixelFormat::Format image_format = PixelFormat::OIIOFormatToOliveFormat(input->spec().format,
-                                                                              input->spec().nchannels == kRGBAChannels);
-
-      // Ensure the following texture operations are done in our context (in case we're in a separate window for instance)
-      makeCurrent();
-
-      if (!texture_.IsCreated()
-          || texture_.width() != input->spec().width
-          || texture_.height() != input->spec().height
-          || texture_.format() != image_format) {
-        load_buffer_.destroy();
-        texture_.Destroy();
-
-        load_buffer_.set_video_params(VideoRenderingParams(input->spec().width, input->spec().height, image_format));
-        load_buffer_.allocate();
-
-        texture_.Create(context(), input->spec().width, input->spec().height, image_format);
-      }
-
-      input->read_image(input->spec().format, load_buffer_.data());
-      input->close();
-
-      emit LoadedBuffer(&load_buffer_);
-
-      texture_.Upload(load_buffer_.data());
-
-      emit LoadedTexture(&texture_);
-
-      doneCurrent();
-
-      has_image_ = true;
-
-#if OIIO_VERSION < 10903
-      OIIO::ImageInput::destroy(input);
-#endif
+  if (has_image_) {
+    // Ensure the following texture operations are done in our context (in case we're in a separate window for instance)
+    makeCurrent();
 
+    if (!texture_.IsCreated()
+        || texture_.width() != load_buffer_->width()
+        || texture_.height() != load_buffer_->height()
+        || texture_.format() != load_buffer_->format()) {
+      texture_.Create(context(), load_buffer_->width(), load_buffer_->height(), load_buffer_->format(), load_buffer_->const_data());
     } else {
-      qWarning() << "OIIO Error:" << OIIO::geterror().c_str();
+      texture_.Upload(load_buffer_->const_data());
     }
+
+    emit LoadedTexture(&texture_);
+
+    doneCurrent();
   }
 
   update();
 
-  if (has_image_) {
-    emit LoadedBuffer(&load_buffer_);
-  } else {
-    emit LoadedBuffer(nullptr);
-  }
+  emit LoadedBuffer(load_buffer_);
 }
 
 void ViewerGLWidget::SetSignalCursorColorEnabled(bool e)
@@ -151,9 +118,9 @@ void ViewerGLWidget::SetSignalCursorColorEnabled(bool e)
   setMouseTracking(e);
 }
 
-void ViewerGLWidget::SetImageFromLoadBuffer(Frame *in_buffer)
+void ViewerGLWidget::SetImageFromLoadBuffer(FramePtr in_buffer)
 {
-  has_image_ = in_buffer;
+  has_image_ = (in_buffer != nullptr);
 
   if (has_image_) {
     makeCurrent();
@@ -237,7 +204,7 @@ const QString &ViewerGLWidget::ocio_look() const
 void ViewerGLWidget::ConnectSibling(ViewerGLWidget *sibling)
 {
   connect(this, &ViewerGLWidget::LoadedBuffer, sibling, &ViewerGLWidget::SetImageFromLoadBuffer, Qt::QueuedConnection);
-  sibling->SetImageFromLoadBuffer(&load_buffer_);
+  sibling->SetImageFromLoadBuffer(load_buffer_);
 }
 
 const ViewerSafeMarginInfo &ViewerGLWidget::GetSafeMargin() const
@@ -266,17 +233,17 @@ void ViewerGLWidget::mouseMoveEvent(QMouseEvent *event)
   if (signal_cursor_color_) {
     Color reference, display;
 
-    if (has_image_) {
+    if (has_image_ && load_buffer_) {
       QVector3D pixel_pos(static_cast<float>(event->x()) / static_cast<float>(width()) * 2.0f - 1.0f,
                           static_cast<float>(event->y()) / static_cast<float>(height()) * 2.0f - 1.0f,
                           0);
 
       pixel_pos = pixel_pos * matrix_.inverted();
 
-      int frame_x = qRound((pixel_pos.x() + 1.0f) * 0.5f * load_buffer_.width());
-      int frame_y = qRound((pixel_pos.y() + 1.0f) * 0.5f * load_buffer_.height());
+      int frame_x = qRound((pixel_pos.x() + 1.0f) * 0.5f * load_buffer_->width());
+      int frame_y = qRound((pixel_pos.y() + 1.0f) * 0.5f * load_buffer_->height());
 
-      reference = load_buffer_.get_pixel(frame_x, frame_y);
+      reference = load_buffer_->get_pixel(frame_x, frame_y);
       display = color_service_->ConvertColor(reference);
     }
 
@@ -74,9 +74,11 @@ public:
   void DisconnectColorManager();
 
   /**
-   * @brief Set an image to load and display on screen
+   * @brief Set an image to display on screen
+   *
+   * Passing nullptr will clear the display.
    */
-  void SetImage(const QString& fn);
+  void SetImage(FramePtr frame);
 
   ColorManager* color_manager() const;
 
@@ -146,7 +148,7 @@ public slots:
    * If there are multiple ViewerGLWidgets showing the same thing, this is faster than decoding the image from file
    * each time.
    */
-  void SetImageFromLoadBuffer(Frame* in_buffer);
+  void SetImageFromLoadBuffer(FramePtr in_buffer);
 
   /**
    * @brief Enables or disables DrewManagedTexture()
@@ -175,7 +177,7 @@ signals:
    *
    * Connect this to the SetImageFromLoadBuffer() slot of another ViewerGLWidget to show the same thing
    */
-  void LoadedBuffer(Frame* load_buffer);
+  void LoadedBuffer(FramePtr load_buffer);
 
   /**
    * @brief Signal emitted when a buffer is loaded into a texture
@@ -283,9 +285,9 @@ private:
   QMatrix4x4 matrix_;
 
   /**
-   * @brief Buffer to load images into RAM before sending them to the display
+   * @brief The frame currently being displayed, kept for cursor color sampling and sibling widgets
    */
-  Frame load_buffer_;
+  FramePtr load_buffer_;
 
 #ifdef Q_OS_LINUX
   static bool nouveau_check_done_;
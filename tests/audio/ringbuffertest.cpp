@@ -0,0 +1,224 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "audio/ringbuffer.h"
+
+using OLIVE_NAMESPACE::AudioRingBuffer;
+
+/**
+ * @brief Fill `buffer` with a byte sequence continuing on from `start` so reads can be checked for order
+ */
+static void FillSequence(std::vector<char>& buffer, int start)
+{
+  for (size_t i=0; i<buffer.size(); i++) {
+    buffer[i] = static_cast<char>(start + static_cast<int>(i));
+  }
+}
+
+TEST(AudioRingBufferTest, CapacityRoundsUpToPowerOfTwo)
+{
+  AudioRingBuffer ring;
+
+  ring.Allocate(100);
+  EXPECT_EQ(ring.capacity(), 128);
+
+  ring.Allocate(64);
+  EXPECT_EQ(ring.capacity(), 64);
+}
+
+TEST(AudioRingBufferTest, EmptyReadsNothing)
+{
+  AudioRingBuffer ring;
+  ring.Allocate(16);
+
+  char out[4];
+
+  EXPECT_EQ(ring.available(), 0);
+  EXPECT_EQ(ring.queued(), 0);
+  EXPECT_EQ(ring.free_space(), 16);
+  EXPECT_EQ(ring.read(out, 4), 0);
+  EXPECT_EQ(ring.read_position(), 0u);
+}
+
+TEST(AudioRingBufferTest, FullRejectsWrites)
+{
+  AudioRingBuffer ring;
+  ring.Allocate(16);
+
+  std::vector<char> in(20);
+  FillSequence(in, 0);
+
+  // Only as much as fits is written
+  EXPECT_EQ(ring.write(in.data(), 20), 16);
+  EXPECT_EQ(ring.free_space(), 0);
+  EXPECT_EQ(ring.available(), 16);
+  EXPECT_EQ(ring.write(in.data(), 1), 0);
+
+  // Reading one byte frees exactly one byte
+  char out;
+  EXPECT_EQ(ring.read(&out, 1), 1);
+  EXPECT_EQ(out, in[0]);
+  EXPECT_EQ(ring.free_space(), 1);
+  EXPECT_EQ(ring.write(in.data(), 2), 1);
+}
+
+TEST(AudioRingBufferTest, WrapsAround)
+{
+  AudioRingBuffer ring;
+  ring.Allocate(8);
+
+  std::vector<char> in(6);
+  std::vector<char> out(6);
+
+  // Each pass starts at a different offset, so most of these writes and reads are split across the end of storage
+  for (int pass=0; pass<5; pass++) {
+    FillSequence(in, pass * 6);
+
+    ASSERT_EQ(ring.write(in.data(), 6), 6);
+    ASSERT_EQ(ring.available(), 6);
+    ASSERT_EQ(ring.read(out.data(), 6), 6);
+
+    EXPECT_EQ(out, in);
+    EXPECT_EQ(ring.available(), 0);
+    EXPECT_EQ(ring.free_space(), 8);
+  }
+
+  EXPECT_EQ(ring.read_position(), 30u);
+}
+
+TEST(AudioRingBufferTest, FlushSkipsQueuedData)
+{
+  AudioRingBuffer ring;
+  ring.Allocate(8);
+
+  std::vector<char> stale(4);
+  FillSequence(stale, 0);
+
+  std::vector<char> fresh(2);
+  FillSequence(fresh, 100);
+
+  ring.write(stale.data(), 4);
+  ring.Flush();
+
+  EXPECT_EQ(ring.available(), 0);
+  EXPECT_EQ(ring.queued(), 0);
+
+  ring.write(fresh.data(), 2);
+
+  std::vector<char> out(4);
+  EXPECT_EQ(ring.read(out.data(), 4), 2);
+  EXPECT_EQ(out[0], fresh[0]);
+  EXPECT_EQ(out[1], fresh[1]);
+
+  // Flushed bytes still count as consumed
+  EXPECT_EQ(ring.read_position(), 6u);
+  EXPECT_EQ(ring.free_space(), 8);
+}
+
+TEST(AudioRingBufferTest, UnderrunReturnsShortRead)
+{
+  AudioRingBuffer ring;
+  ring.Allocate(16);
+
+  std::vector<char> in(6);
+  FillSequence(in, 0);
+
+  ring.write(in.data(), 6);
+
+  // The output device asks for more than the feeder has supplied, this short read is what it counts as an underrun
+  std::vector<char> out(10, 0x7F);
+  EXPECT_EQ(ring.read(out.data(), 10), 6);
+  EXPECT_TRUE(std::equal(in.begin(), in.end(), out.begin()));
+
+  // Bytes past the short read are left for the caller to fill with silence
+  EXPECT_EQ(out[6], 0x7F);
+
+  // Only real samples count as played, so latency and position don't drift while starved
+  EXPECT_EQ(ring.read_position(), 6u);
+  EXPECT_EQ(ring.queued(), 0);
+  EXPECT_EQ(ring.read(out.data(), 10), 0);
+  EXPECT_EQ(ring.read_position(), 6u);
+
+  // Once the feeder catches up the stream carries on where it left off
+  FillSequence(in, 6);
+  ring.write(in.data(), 6);
+
+  EXPECT_EQ(ring.read(out.data(), 6), 6);
+  EXPECT_TRUE(std::equal(in.begin(), in.end(), out.begin()));
+  EXPECT_EQ(ring.read_position(), 12u);
+}
+
+TEST(AudioRingBufferTest, ProducerConsumerKeepOrder)
+{
+  AudioRingBuffer ring;
+  ring.Allocate(64);
+
+  const int total = 1 << 16;
+
+  std::thread producer([&ring, total]() {
+    std::vector<char> chunk(37);
+    int written = 0;
+
+    while (written < total) {
+      int length = qMin(static_cast<int>(chunk.size()), total - written);
+
+      // Anything that didn't fit is regenerated from the new position next time around
+      FillSequence(chunk, written);
+
+      int count = ring.write(chunk.data(), length);
+
+      if (count == 0) {
+        std::this_thread::yield();
+      }
+
+      written += count;
+    }
+  });
+
+  std::vector<char> chunk(29);
+  int read = 0;
+  bool in_order = true;
+
+  while (read < total) {
+    int length = ring.read(chunk.data(), static_cast<int>(chunk.size()));
+
+    for (int i=0; i<length; i++) {
+      if (chunk[static_cast<size_t>(i)] != static_cast<char>(read + i)) {
+        in_order = false;
+      }
+    }
+
+    if (length == 0) {
+      std::this_thread::yield();
+    }
+
+    read += length;
+  }
+
+  producer.join();
+
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(ring.read_position(), static_cast<quint64>(total));
+}
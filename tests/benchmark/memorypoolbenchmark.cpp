@@ -0,0 +1,123 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "common/memorypool.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief A pool of fixed size blocks, used the same way FFmpegFramePool uses MemoryPool
+ */
+class BenchmarkPool : public MemoryPool<char>
+{
+public:
+  BenchmarkPool(int element_count, size_t element_size) :
+    MemoryPool(element_count),
+    element_size_(element_size)
+  {
+  }
+
+protected:
+  virtual size_t GetElementSize() override
+  {
+    return element_size_;
+  }
+
+private:
+  size_t element_size_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+using OLIVE_NAMESPACE::BenchmarkPool;
+
+const int kArenaSize = 256;
+const size_t kElementSize = 4096;
+
+static BenchmarkPool* pool = nullptr;
+static BenchmarkPool::ElementPtr pinned_element = nullptr;
+
+static void SetUpPool(const benchmark::State& state)
+{
+  if (state.thread_index() == 0) {
+    pool = new BenchmarkPool(kArenaSize, kElementSize);
+
+    // Keep an element out for the whole run so the arena isn't destroyed every time the pool empties
+    pinned_element = pool->Get();
+  }
+}
+
+static void TearDownPool(const benchmark::State& state)
+{
+  if (state.thread_index() == 0) {
+    pinned_element = nullptr;
+
+    delete pool;
+    pool = nullptr;
+  }
+}
+
+/**
+ * @brief Get one element and release it straight away, the best case for a shared free list
+ */
+static void BM_MemoryPoolGetRelease(benchmark::State& state)
+{
+  SetUpPool(state);
+
+  for (auto _ : state) {
+    BenchmarkPool::ElementPtr e = pool->Get();
+    benchmark::DoNotOptimize(e->data());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+
+  TearDownPool(state);
+}
+BENCHMARK(BM_MemoryPoolGetRelease)->ThreadRange(1, 64)->UseRealTime();
+
+/**
+ * @brief Hold several elements at once like a decoder instance's frame cache does, then release them all
+ */
+static void BM_MemoryPoolGetReleaseBatch(benchmark::State& state)
+{
+  SetUpPool(state);
+
+  std::vector<BenchmarkPool::ElementPtr> held(static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    for (size_t i=0; i<held.size(); i++) {
+      held[i] = pool->Get();
+      benchmark::DoNotOptimize(held[i]->data());
+    }
+
+    for (size_t i=0; i<held.size(); i++) {
+      held[i] = nullptr;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+
+  TearDownPool(state);
+}
+BENCHMARK(BM_MemoryPoolGetReleaseBatch)->Arg(2)->ThreadRange(1, 64)->UseRealTime();
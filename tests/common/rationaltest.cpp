@@ -0,0 +1,135 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include <gtest/gtest.h>
+
+#include "common/rational.h"
+
+using OLIVE_NAMESPACE::rational;
+
+// Larger than sqrt(INT64_MAX), so squaring it overflows
+const int64_t kLarge = 3037000501LL;
+
+TEST(RationalTest, AddSameDenominatorReduces)
+{
+  rational r = rational(1, 4) + rational(1, 4);
+
+  EXPECT_EQ(r.numerator(), 1);
+  EXPECT_EQ(r.denominator(), 2);
+}
+
+TEST(RationalTest, AddDifferentDenominatorsReduces)
+{
+  rational r = rational(1, 6) + rational(1, 3);
+
+  EXPECT_EQ(r.numerator(), 1);
+  EXPECT_EQ(r.denominator(), 2);
+}
+
+TEST(RationalTest, AddCoprimeDenominators)
+{
+  rational r = rational(1, 3) + rational(1, 5);
+
+  EXPECT_EQ(r.numerator(), 8);
+  EXPECT_EQ(r.denominator(), 15);
+}
+
+TEST(RationalTest, SubtractKeepsDenominatorPositive)
+{
+  rational r = rational(1, 3) - rational(1, 2);
+
+  EXPECT_EQ(r.numerator(), -1);
+  EXPECT_EQ(r.denominator(), 6);
+}
+
+TEST(RationalTest, AddToZeroIsNull)
+{
+  rational r = rational(1, 3) - rational(1, 3);
+
+  EXPECT_TRUE(r.isNull());
+  EXPECT_EQ(r.numerator(), 0);
+}
+
+TEST(RationalTest, AddSharedFactorAvoidsOverflow)
+{
+  // Multiplying the denominators together would need 2^65
+  rational r = rational(5, 4294967296LL) + rational(3, 8589934592LL);
+
+  EXPECT_EQ(r.numerator(), 13);
+  EXPECT_EQ(r.denominator(), 8589934592LL);
+}
+
+TEST(RationalTest, AddReducesByCommonFactorOfSum)
+{
+  // 1/6074001000 + 2/6074001000 = 3/6074001000, and 3 divides 6074001000
+  rational r = rational(1, 6074001000LL) + rational(1, 3037000500LL);
+
+  EXPECT_EQ(r.numerator(), 1);
+  EXPECT_EQ(r.denominator(), 2024667000LL);
+}
+
+TEST(RationalTest, MultiplyReduces)
+{
+  rational r = rational(2, 3) * rational(3, 4);
+
+  EXPECT_EQ(r.numerator(), 1);
+  EXPECT_EQ(r.denominator(), 2);
+}
+
+TEST(RationalTest, MultiplyCrossReducesAvoidingOverflow)
+{
+  // Multiplying first would need kLarge squared in the denominator
+  rational r = rational(kLarge, 3) * rational(6, kLarge);
+
+  EXPECT_EQ(r.numerator(), 2);
+  EXPECT_EQ(r.denominator(), 1);
+
+  r = rational(kLarge, 7) * rational(7, kLarge);
+
+  EXPECT_EQ(r.numerator(), 1);
+  EXPECT_EQ(r.denominator(), 1);
+
+  r = rational(kLarge) * rational(1, kLarge);
+
+  EXPECT_EQ(r.numerator(), 1);
+  EXPECT_EQ(r.denominator(), 1);
+}
+
+TEST(RationalTest, MultiplyByZeroIsNull)
+{
+  EXPECT_TRUE((rational(2, 3) * rational(0)).isNull());
+  EXPECT_TRUE((rational(0) * rational(2, 3)).isNull());
+}
+
+TEST(RationalTest, DivideByNegativeKeepsDenominatorPositive)
+{
+  rational r = rational(1, 2) / rational(-1, 4);
+
+  EXPECT_EQ(r.numerator(), -2);
+  EXPECT_EQ(r.denominator(), 1);
+}
+
+TEST(RationalTest, DivideCrossReducesAvoidingOverflow)
+{
+  rational r = rational(1, kLarge) / rational(1, kLarge);
+
+  EXPECT_EQ(r.numerator(), 1);
+  EXPECT_EQ(r.denominator(), 1);
+}
@@ -0,0 +1,133 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include <gtest/gtest.h>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+
+#include "project/item/footage/frameindex.h"
+
+using OLIVE_NAMESPACE::FrameIndex;
+using OLIVE_NAMESPACE::FrameIndexPtr;
+
+/**
+ * @brief Builds an index the way a stream with B-frames is scanned, in decode order
+ *
+ * Once sorted, the first timestamp is negative and the positions go backwards in places, so both kinds of delta get
+ * written as negatives.
+ */
+static FrameIndex CreateDecodeOrderIndex()
+{
+  FrameIndex index;
+
+  index.Append(-2002, 0, true);
+  index.Append(1001, 100, false);
+  index.Append(-1001, 200, false);
+  index.Append(0, 300, false);
+  index.Append(4004, 5000000000LL, true);
+  index.Append(2002, 5000000100LL, false);
+  index.Append(3003, 5000000200LL, false);
+
+  return index;
+}
+
+TEST(FrameIndexTest, AppendSortsByTimestamp)
+{
+  FrameIndex index = CreateDecodeOrderIndex();
+
+  ASSERT_EQ(index.count(), 7);
+
+  const int64_t expected_ts[] = {-2002, -1001, 0, 1001, 2002, 3003, 4004};
+  const int64_t expected_pos[] = {0, 200, 300, 100, 5000000100LL, 5000000200LL, 5000000000LL};
+
+  for (int i=0; i<index.count(); i++) {
+    EXPECT_EQ(index.timestamp(i), expected_ts[i]);
+    EXPECT_EQ(index.position(i), expected_pos[i]);
+  }
+
+  EXPECT_EQ(index.FindKeyframe(3), 0);
+  EXPECT_EQ(index.FindKeyframe(6), 6);
+}
+
+TEST(FrameIndexTest, SaveLoadRoundTrip)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  QString filename = dir.filePath(QStringLiteral("index"));
+
+  FrameIndex index = CreateDecodeOrderIndex();
+  index.SetComplete();
+
+  ASSERT_TRUE(index.Save(filename));
+
+  FrameIndexPtr loaded = FrameIndex::Load(filename);
+
+  ASSERT_TRUE(loaded);
+  ASSERT_EQ(loaded->count(), index.count());
+  EXPECT_TRUE(loaded->is_complete());
+
+  for (int i=0; i<index.count(); i++) {
+    EXPECT_EQ(loaded->timestamp(i), index.timestamp(i));
+    EXPECT_EQ(loaded->position(i), index.position(i));
+    EXPECT_EQ(loaded->FindKeyframe(i), index.FindKeyframe(i));
+  }
+}
+
+TEST(FrameIndexTest, LoadRejectsTruncatedFile)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  QString filename = dir.filePath(QStringLiteral("index"));
+
+  ASSERT_TRUE(CreateDecodeOrderIndex().Save(filename));
+
+  QFile file(filename);
+  ASSERT_TRUE(file.open(QFile::ReadWrite));
+  ASSERT_TRUE(file.resize(file.size() - 1));
+  file.close();
+
+  EXPECT_FALSE(FrameIndex::Load(filename));
+}
+
+TEST(FrameIndexTest, LoadRejectsImpossibleCount)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  QString filename = dir.filePath(QStringLiteral("index"));
+
+  ASSERT_TRUE(CreateDecodeOrderIndex().Save(filename));
+
+  // Overwrite the frame count in the header with one far larger than the file could hold
+  QFile file(filename);
+  ASSERT_TRUE(file.open(QFile::ReadWrite));
+
+  uchar count[4];
+  qToLittleEndian<quint32>(0xFFFFFFFF, count);
+
+  ASSERT_TRUE(file.seek(8));
+  ASSERT_EQ(file.write(reinterpret_cast<const char*>(count), 4), 4);
+  file.close();
+
+  EXPECT_FALSE(FrameIndex::Load(filename));
+}